@@ -0,0 +1,296 @@
+#include "BenchmarkCommon.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <new>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <malloc.h>
+#include <sys/resource.h>
+
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	std::atomic<uint64_t> GNumAllocations{0};
+	std::atomic<uint64_t> GBytesAllocated{0};
+	std::atomic<uint64_t> GLiveBytes{0};
+	std::atomic<uint64_t> GPeakLiveBytes{0};
+
+	void* TrackedAllocate(const std::size_t Size)
+	{
+		void* Pointer = std::malloc(Size ? Size : 1);
+		if (!Pointer)
+		{
+			throw std::bad_alloc();
+		}
+		const uint64_t UsableSize = malloc_usable_size(Pointer);
+		GNumAllocations.fetch_add(1, std::memory_order_relaxed);
+		GBytesAllocated.fetch_add(Size, std::memory_order_relaxed);
+		const uint64_t Live = GLiveBytes.fetch_add(UsableSize, std::memory_order_relaxed) + UsableSize;
+		uint64_t Peak = GPeakLiveBytes.load(std::memory_order_relaxed);
+		while (Live > Peak && !GPeakLiveBytes.compare_exchange_weak(Peak, Live, std::memory_order_relaxed))
+		{
+		}
+		return Pointer;
+	}
+
+	void TrackedFree(void* Pointer)
+	{
+		if (Pointer)
+		{
+			GLiveBytes.fetch_sub(malloc_usable_size(Pointer), std::memory_order_relaxed);
+			std::free(Pointer);
+		}
+	}
+
+	// Same list as UResourceRouletteUtility::UpdateValidResourceClasses
+	const std::set<std::string> ValidResourceClasses = {
+		"Desc_LiquidOil_C", "Desc_SAM_C", "Desc_Stone_C", "Desc_OreIron_C", "Desc_OreCopper_C", "Desc_OreGold_C",
+		"Desc_Coal_C", "Desc_RawQuartz_C", "Desc_Sulfur_C", "Desc_OreBauxite_C", "Desc_OreUranium_C",
+		"Desc_FF_Dirt_Fertilized_C", "Desc_FF_Dirt_C", "Desc_FF_Dirt_Wet_C", "Desc_RP_Thorium_C"
+	};
+
+	// Same list as UResourceRouletteUtility::UpdateNonGroupableResources with the default settings
+	const std::set<std::string> NonGroupableResources = {
+		"Desc_LiquidOil_C", "Desc_SAM_C", "Desc_OreBauxite_C", "Desc_OreUranium_C", "Desc_FF_Dirt_Fertilized_C",
+		"Desc_FF_Dirt_C", "Desc_FF_Dirt_Wet_C", "Desc_RP_Thorium_C"
+	};
+
+	std::vector<std::string> Split(const std::string& Line, const char Delimiter)
+	{
+		std::vector<std::string> Fields;
+		std::stringstream Stream(Line);
+		std::string Field;
+		while (std::getline(Stream, Field, Delimiter))
+		{
+			Fields.push_back(Field);
+		}
+		return Fields;
+	}
+
+	/// Strips the "[timestamp][frame][time] " log prefix off a node name
+	std::string StripLogPrefix(const std::string& Field)
+	{
+		const size_t LastSpace = Field.find_last_of(' ');
+		return LastSpace == std::string::npos ? Field : Field.substr(LastSpace + 1);
+	}
+}
+
+void* operator new(const std::size_t Size)
+{
+	return TrackedAllocate(Size);
+}
+
+void* operator new[](const std::size_t Size)
+{
+	return TrackedAllocate(Size);
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	TrackedFree(Pointer);
+}
+
+void operator delete[](void* Pointer) noexcept
+{
+	TrackedFree(Pointer);
+}
+
+void operator delete(void* Pointer, std::size_t) noexcept
+{
+	TrackedFree(Pointer);
+}
+
+void operator delete[](void* Pointer, std::size_t) noexcept
+{
+	TrackedFree(Pointer);
+}
+
+namespace ResourceRouletteBenchmark
+{
+	FScopedAllocationTracker::FScopedAllocationTracker()
+	{
+		StartStats.NumAllocations = GNumAllocations.load();
+		StartStats.BytesAllocated = GBytesAllocated.load();
+		StartLiveBytes = GLiveBytes.load();
+		GPeakLiveBytes.store(StartLiveBytes);
+	}
+
+	FScopedAllocationTracker::~FScopedAllocationTracker() = default;
+
+	FAllocationStats FScopedAllocationTracker::GetStats() const
+	{
+		FAllocationStats Stats;
+		Stats.NumAllocations = GNumAllocations.load() - StartStats.NumAllocations;
+		Stats.BytesAllocated = GBytesAllocated.load() - StartStats.BytesAllocated;
+		const uint64_t Peak = GPeakLiveBytes.load();
+		Stats.PeakLiveBytes = Peak > StartLiveBytes ? Peak - StartLiveBytes : 0;
+		return Stats;
+	}
+
+	long GetPeakResidentKiB()
+	{
+		rusage Usage{};
+		getrusage(RUSAGE_SELF, &Usage);
+		return Usage.ru_maxrss;
+	}
+
+	std::vector<FDumpNode> LoadNodeDump(const std::string& Path)
+	{
+		std::vector<FDumpNode> Nodes;
+		std::ifstream File(Path);
+		std::string Line;
+		while (std::getline(File, Line))
+		{
+			if (!Line.empty() && Line.back() == '\r')
+			{
+				Line.pop_back();
+			}
+
+			std::vector<std::string> Fields;
+			if (Line.find('|') != std::string::npos)
+			{
+				Fields = Split(Line, '|');
+			}
+			else
+			{
+				Fields = Split(Line, ',');
+				if (!Fields.empty())
+				{
+					Fields.erase(Fields.begin());
+				}
+			}
+			if (Fields.size() < 4 || Fields[3] != "Infinite" || !ValidResourceClasses.count(Fields[1]))
+			{
+				continue;
+			}
+
+			FDumpNode& Node = Nodes.emplace_back();
+			Node.Name = StripLogPrefix(Fields[0]);
+			Node.ResourceClass = Fields[1];
+			Node.bIsFracking = Node.Name.find("Fracking") != std::string::npos;
+		}
+		return Nodes;
+	}
+
+	FSyntheticWorld BuildSyntheticWorld(const std::vector<FDumpNode>& DumpNodes, const int32_t Scale,
+	                                    const int32_t Seed)
+	{
+		FSyntheticWorld World;
+
+		// Class table, sorted the same way the adapter sorts FNames
+		std::set<std::string> UniqueClasses(ValidResourceClasses);
+		World.ClassNames.assign(UniqueClasses.begin(), UniqueClasses.end());
+		std::map<std::string, int32_t> ClassIndexes;
+		for (int32_t i = 0; i < static_cast<int32_t>(World.ClassNames.size()); ++i)
+		{
+			ClassIndexes[World.ClassNames[i]] = i;
+			FResourceClassInfo& ClassInfo = World.Options.Classes.emplace_back();
+			ClassInfo.bRandomize = true;
+			ClassInfo.bGroupable = !NonGroupableResources.count(World.ClassNames[i]);
+			World.Options.FullRandomizationClasses.push_back(i);
+		}
+
+		World.Options.Seed = Seed;
+		World.Options.GroupingRadius = 4000.0;
+		World.Options.MaxNodesPerGroup = 5;
+		World.Options.PurityZones = {
+			{-50000.0, 240000.0, 80000.0, EPurity::Impure},
+			{50000.0, -90000.0, 80000.0, EPurity::Impure},
+			{300000.0, -175000.0, 120000.0, EPurity::Impure},
+			{-220000.0, -35000.0, 80000.0, EPurity::Impure}
+		};
+
+		// Vanilla nodes sit in small clumps, so drop consecutive dump entries around shared cluster centres
+		const double MapHalfExtent = 350000.0 * std::sqrt(static_cast<double>(Scale));
+		FSeededRandomStream RandomStream(Seed ^ 0x5EED);
+		auto RandomIn = [&RandomStream](const double Min, const double Max)
+		{
+			return Min + (Max - Min) * RandomStream.GetFraction();
+		};
+
+		World.Budget = FPurityBudget(static_cast<int32_t>(World.ClassNames.size()));
+		World.Nodes.reserve(DumpNodes.size() * Scale);
+		for (int32_t Copy = 0; Copy < Scale; ++Copy)
+		{
+			FVec3 ClusterCenter;
+			for (size_t i = 0; i < DumpNodes.size(); ++i)
+			{
+				if (i % 4 == 0)
+				{
+					ClusterCenter = {
+						RandomIn(-MapHalfExtent, MapHalfExtent), RandomIn(-MapHalfExtent, MapHalfExtent),
+						RandomIn(-2000.0, 6000.0)
+					};
+				}
+
+				FNodeEntry& Node = World.Nodes.emplace_back();
+				Node.ClassIndex = ClassIndexes[DumpNodes[i].ResourceClass];
+				Node.Location = {
+					ClusterCenter.X + RandomIn(-3000.0, 3000.0), ClusterCenter.Y + RandomIn(-3000.0, 3000.0),
+					ClusterCenter.Z + RandomIn(-300.0, 300.0)
+				};
+				const float PurityRoll = RandomStream.GetFraction();
+				Node.Purity = PurityRoll < 0.3f ? EPurity::Impure : PurityRoll < 0.75f ? EPurity::Normal : EPurity::Pure;
+				Node.bExcluded = DumpNodes[i].bIsFracking && DumpNodes[i].ResourceClass == "Desc_LiquidOil_C";
+
+				// Budget mirrors CollectWorldPurities, which skips the fracking oil nodes
+				if (!Node.bExcluded)
+				{
+					++World.Budget.At(Node.ClassIndex, Node.Purity);
+				}
+			}
+		}
+		return World;
+	}
+
+	FParallelForFunction MakeThreadParallelFor(const int32_t NumThreads)
+	{
+		return [NumThreads](const int32_t NumTasks, const std::function<void(int32_t)>& Task)
+		{
+			std::atomic<int32_t> NextTask{0};
+			auto Worker = [&]
+			{
+				for (int32_t TaskIndex = NextTask++; TaskIndex < NumTasks; TaskIndex = NextTask++)
+				{
+					Task(TaskIndex);
+				}
+			};
+			std::vector<std::thread> Threads;
+			for (int32_t i = 1; i < NumThreads; ++i)
+			{
+				Threads.emplace_back(Worker);
+			}
+			Worker();
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+		};
+	}
+
+	uint64_t HashAssignments(const std::vector<FNodeAssignment>& Assignments)
+	{
+		uint64_t Hash = 14695981039346656037ULL;
+		auto HashBytes = [&Hash](const void* Data, const size_t Size)
+		{
+			const auto* Bytes = static_cast<const uint8_t*>(Data);
+			for (size_t i = 0; i < Size; ++i)
+			{
+				Hash = (Hash ^ Bytes[i]) * 1099511628211ULL;
+			}
+		};
+		for (const FNodeAssignment& Assignment : Assignments)
+		{
+			HashBytes(&Assignment.SourceNode, sizeof(Assignment.SourceNode));
+			HashBytes(&Assignment.Location, sizeof(Assignment.Location));
+			HashBytes(&Assignment.Purity, sizeof(Assignment.Purity));
+		}
+		return Hash;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Shared helpers for the headless benchmarks: allocation tracking, timing and loading the node dumps
+// from NumberCrunching/ into something the randomizer core can chew on
+
+#include "RandomizerCore/ResourceRandomizerCore.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ResourceRouletteBenchmark
+{
+	/// Counts every heap allocation made through global operator new while it's alive
+	struct FAllocationStats
+	{
+		uint64_t NumAllocations = 0;
+		uint64_t BytesAllocated = 0;
+		// Highest live heap size above what was live when tracking started
+		uint64_t PeakLiveBytes = 0;
+	};
+
+	class FScopedAllocationTracker
+	{
+	public:
+		FScopedAllocationTracker();
+		~FScopedAllocationTracker();
+		FAllocationStats GetStats() const;
+
+	private:
+		FAllocationStats StartStats;
+		uint64_t StartLiveBytes;
+	};
+
+	/// Peak resident set size of the whole process so far, in KiB
+	long GetPeakResidentKiB();
+
+	class FStopwatch
+	{
+	public:
+		FStopwatch() : Start(std::chrono::steady_clock::now())
+		{
+		}
+
+		double GetElapsedMilliseconds() const
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point Start;
+	};
+
+	/// One node from a dump. The dumps only carry names and classes, locations are synthesized
+	struct FDumpNode
+	{
+		std::string Name;
+		std::string ResourceClass;
+		bool bIsFracking = false;
+	};
+
+	/// Reads either resource_nodes_log.txt style (Name|Class|Form|Amount) or Out_*.csv style
+	/// (Index,Name,Class,Form,Amount) dumps, keeping only infinite nodes of classes the mod collects
+	std::vector<FDumpNode> LoadNodeDump(const std::string& Path);
+
+	/// Everything the randomizer core needs for one run
+	struct FSyntheticWorld
+	{
+		std::vector<std::string> ClassNames;
+		std::vector<ResourceRouletteCore::FNodeEntry> Nodes;
+		ResourceRouletteCore::FPurityBudget Budget;
+		ResourceRouletteCore::FRandomizerOptions Options;
+	};
+
+	/// Replicates the dump Scale times over a map whose area grows with the scale, so node density
+	/// (and with it the grouping behaviour) stays roughly the same as the real map
+	FSyntheticWorld BuildSyntheticWorld(const std::vector<FDumpNode>& DumpNodes, int32_t Scale, int32_t Seed);
+
+	/// ParallelFor for the core's parallel mode, spreads the tasks over NumThreads plain threads
+	ResourceRouletteCore::FParallelForFunction MakeThreadParallelFor(int32_t NumThreads);
+
+	/// FNV-1a over the assignments, handy to check two runs produced the same layout
+	uint64_t HashAssignments(const std::vector<ResourceRouletteCore::FNodeAssignment>& Assignments);
+}
@@ -0,0 +1,214 @@
+// Compares the old brute force extractor/portable miner to node matching in
+// UResourceRouletteUtility::AssociateExtractorsWithNodes against the FResourceLocationGrid version on
+// synthetic saves with 1k extractors, and checks both pick the same nodes.
+//
+// Usage: ExtractorAssociationBenchmark [Extractors] [PortableMiners] [Seed]
+
+#include "BenchmarkCommon.h"
+#include "RandomizerCore/ResourceLocationGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	constexpr double MinerAssociationRadius = 700.0;
+	constexpr double PortableMinerRadius = 1500.0;
+
+	struct FSyntheticMiner
+	{
+		FVec3 Location;
+		// Stand-in for IsAllowedOnResource, miners can't go on nodes of this class
+		int32_t DisallowedClass = -1;
+	};
+
+	struct FSyntheticSave
+	{
+		std::vector<FVec3> NodeLocations;
+		std::vector<int32_t> NodeClasses;
+		std::vector<FSyntheticMiner> Extractors;
+		std::vector<FSyntheticMiner> PortableMiners;
+	};
+
+	/// Most miners sit on top of a node like they would in a real save, the rest are orphans left over
+	/// from a reroll that shouldn't find anything
+	std::vector<FSyntheticMiner> PlaceMiners(const FSyntheticSave& Save, const int32_t NumMiners, const double ZOffset,
+	                                         FSeededRandomStream& RandomStream)
+	{
+		std::vector<FSyntheticMiner> Miners;
+		Miners.reserve(NumMiners);
+		const int32_t NumNodes = static_cast<int32_t>(Save.NodeLocations.size());
+		for (int32_t i = 0; i < NumMiners; ++i)
+		{
+			FSyntheticMiner& Miner = Miners.emplace_back();
+			const FVec3& Node = Save.NodeLocations[RandomStream.RandHelper(NumNodes)];
+			if (RandomStream.GetFraction() < 0.85f)
+			{
+				Miner.Location = {
+					Node.X + (RandomStream.GetFraction() - 0.5) * 400.0,
+					Node.Y + (RandomStream.GetFraction() - 0.5) * 400.0, Node.Z + ZOffset
+				};
+			}
+			else
+			{
+				Miner.Location = {Node.X + 20000.0, Node.Y - 20000.0, Node.Z};
+			}
+			Miner.DisallowedClass = RandomStream.GetFraction() < 0.1f ? RandomStream.RandHelper(15) : -1;
+		}
+		return Miners;
+	}
+
+	FSyntheticSave BuildSave(const std::vector<FDumpNode>& DumpNodes, const int32_t Scale, const int32_t NumExtractors,
+	                         const int32_t NumPortableMiners, const int32_t Seed)
+	{
+		const FSyntheticWorld World = BuildSyntheticWorld(DumpNodes, Scale, Seed);
+		FSyntheticSave Save;
+		for (const FNodeEntry& Node : World.Nodes)
+		{
+			Save.NodeLocations.push_back(Node.Location);
+			Save.NodeClasses.push_back(Node.ClassIndex);
+		}
+		FSeededRandomStream RandomStream(Seed + 1);
+		Save.Extractors = PlaceMiners(Save, NumExtractors, 150.0, RandomStream);
+		Save.PortableMiners = PlaceMiners(Save, NumPortableMiners, 0.0, RandomStream);
+		return Save;
+	}
+
+	/// The old loops, every miner against every node
+	std::vector<int32_t> AssociateBruteForce(const FSyntheticSave& Save)
+	{
+		std::vector<int32_t> Matches;
+		std::vector<uint8_t> Occupied(Save.NodeLocations.size(), 0);
+		for (const FSyntheticMiner& Extractor : Save.Extractors)
+		{
+			const FVec3 ExtractorLocation{Extractor.Location.X, Extractor.Location.Y, Extractor.Location.Z - 150.0};
+			int32_t ClosestIndex = -1;
+			double ClosestDistance = MinerAssociationRadius;
+			for (int32_t i = 0; i < static_cast<int32_t>(Save.NodeLocations.size()); ++i)
+			{
+				if (Occupied[i] || Save.NodeClasses[i] == Extractor.DisallowedClass)
+				{
+					continue;
+				}
+				const double Distance = std::sqrt(DistSquared(ExtractorLocation, Save.NodeLocations[i]));
+				if (Distance < ClosestDistance)
+				{
+					ClosestIndex = i;
+					ClosestDistance = Distance;
+				}
+			}
+			if (ClosestIndex != -1)
+			{
+				Occupied[ClosestIndex] = 1;
+			}
+			Matches.push_back(ClosestIndex);
+		}
+		for (const FSyntheticMiner& PortableMiner : Save.PortableMiners)
+		{
+			int32_t ClosestIndex = -1;
+			double ClosestDistance = PortableMinerRadius;
+			for (int32_t i = 0; i < static_cast<int32_t>(Save.NodeLocations.size()); ++i)
+			{
+				const double Distance = std::sqrt(DistSquared(PortableMiner.Location, Save.NodeLocations[i]));
+				if (Distance < ClosestDistance)
+				{
+					ClosestIndex = i;
+					ClosestDistance = Distance;
+				}
+			}
+			Matches.push_back(ClosestIndex);
+		}
+		return Matches;
+	}
+
+	/// Same matching through the grid, like AssociateExtractorsWithNodes does now
+	std::vector<int32_t> AssociateWithGrid(const FSyntheticSave& Save)
+	{
+		std::vector<int32_t> Matches;
+		std::vector<uint8_t> Occupied(Save.NodeLocations.size(), 0);
+		const FResourceLocationGrid NodeGrid(Save.NodeLocations, PortableMinerRadius);
+		for (const FSyntheticMiner& Extractor : Save.Extractors)
+		{
+			const FVec3 ExtractorLocation{Extractor.Location.X, Extractor.Location.Y, Extractor.Location.Z - 150.0};
+			const int32_t ClosestIndex = NodeGrid.FindNearest(ExtractorLocation, MinerAssociationRadius,
+			                                                  [&](const int32_t Index)
+			                                                  {
+				                                                  return !Occupied[Index] && Save.NodeClasses[Index]
+					                                                  != Extractor.DisallowedClass;
+			                                                  });
+			if (ClosestIndex != -1)
+			{
+				Occupied[ClosestIndex] = 1;
+			}
+			Matches.push_back(ClosestIndex);
+		}
+		for (const FSyntheticMiner& PortableMiner : Save.PortableMiners)
+		{
+			Matches.push_back(NodeGrid.FindNearest(PortableMiner.Location, PortableMinerRadius,
+			                                       [](int32_t) { return true; }));
+		}
+		return Matches;
+	}
+
+	template <typename FunctionType>
+	double TimeBest(const int32_t Iterations, FunctionType&& Function, std::vector<int32_t>& OutMatches)
+	{
+		double BestMilliseconds = 0.0;
+		for (int32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const FStopwatch Stopwatch;
+			OutMatches = Function();
+			const double Milliseconds = Stopwatch.GetElapsedMilliseconds();
+			BestMilliseconds = Iteration == 0 ? Milliseconds : std::min(BestMilliseconds, Milliseconds);
+		}
+		return BestMilliseconds;
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t NumExtractors = Argc > 1 ? std::atoi(Argv[1]) : 1000;
+	const int32_t NumPortableMiners = Argc > 2 ? std::atoi(Argv[2]) : 200;
+	const int32_t Seed = Argc > 3 ? std::atoi(Argv[3]) : 1337;
+
+	const std::vector<FDumpNode> DumpNodes = LoadNodeDump(RR_NUMBER_CRUNCHING_DIR "/resource_nodes_log.txt");
+	if (DumpNodes.empty())
+	{
+		std::fprintf(stderr, "Couldn't load any nodes from resource_nodes_log.txt\n");
+		return 1;
+	}
+
+	std::printf("Extractor association benchmark, %d extractors, %d portable miners, seed %d\n", NumExtractors,
+	            NumPortableMiners, Seed);
+	std::printf("%6s %8s %14s %12s %9s %8s %10s\n", "Scale", "Nodes", "Brute force ms", "Grid ms", "Speedup",
+	            "Matched", "Mismatches");
+	bool bAllMatch = true;
+	for (const int32_t Scale : {1, 10, 100})
+	{
+		const FSyntheticSave Save = BuildSave(DumpNodes, Scale, NumExtractors, NumPortableMiners, Seed);
+		const int32_t Iterations = Scale >= 100 ? 1 : 5;
+
+		std::vector<int32_t> BruteForceMatches;
+		std::vector<int32_t> GridMatches;
+		const double BruteForceMilliseconds = TimeBest(Iterations, [&] { return AssociateBruteForce(Save); },
+		                                               BruteForceMatches);
+		const double GridMilliseconds = TimeBest(Iterations, [&] { return AssociateWithGrid(Save); }, GridMatches);
+
+		int32_t NumMatched = 0;
+		int32_t NumMismatches = 0;
+		for (size_t i = 0; i < BruteForceMatches.size(); ++i)
+		{
+			NumMatched += BruteForceMatches[i] != -1;
+			NumMismatches += BruteForceMatches[i] != GridMatches[i];
+		}
+		bAllMatch &= NumMismatches == 0;
+		std::printf("%5dx %8zu %14.3f %12.3f %8.1fx %8d %10d\n", Scale, Save.NodeLocations.size(),
+		            BruteForceMilliseconds, GridMilliseconds, BruteForceMilliseconds / GridMilliseconds, NumMatched,
+		            NumMismatches);
+	}
+	return bAllMatch ? 0 : 1;
+}
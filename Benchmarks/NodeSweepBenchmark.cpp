@@ -0,0 +1,222 @@
+// Compares the player radius sweep over the full per-node structs (how UResourceRouletteManager used to find nodes
+// to settle) against FResourceNodeTable::QueryUnsettledInRadius, on the synthetic worlds RandomizerBenchmark uses.
+// Also runs 4 player queries through one sweep per player merged afterwards against the batched
+// QueryUnsettledNearCenters, which is what a multiplayer server settles with.
+//
+// Usage: NodeSweepBenchmark [Queries] [Seed]
+
+#include "BenchmarkCommon.h"
+#include "RandomizerCore/ResourceNodeTable.h"
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	// Same radius the manager settles nodes in
+	constexpr double NodeUpdateRadius = 25000.0;
+
+	/// Laid out like FResourceNodeData, FString and FName stand-ins included, so the sweep strides the same
+	struct FFatNodeData
+	{
+		std::string Classname;
+		FVec3 Location;
+		FVec3 Rotation;
+		FVec3 Offset;
+		FVec3 Scale;
+		uint8_t Purity = 0;
+		uint8_t Amount = 0;
+		uint8_t ResourceNodeType = 0;
+		uint64_t ResourceClass = 0;
+		uint8_t ResourceForm = 0;
+		bool bCanPlaceResourceExtractor = false;
+		bool bIsOccupied = false;
+		bool IsRayCasted = false;
+		int32_t NumSettleTraces = 0;
+		uint8_t NodeGUID[16] = {};
+	};
+
+	constexpr int32_t NumPlayers = 4;
+
+	/// Squared distance in floats with the radius kernels' operation order, so both paths sort nodes the same way
+	float KernelDistSquared(const FVec3& Location, const FVec3& Center)
+	{
+		const float DX = static_cast<float>(Location.X) - static_cast<float>(Center.X);
+		const float DY = static_cast<float>(Location.Y) - static_cast<float>(Center.Y);
+		const float DZ = static_cast<float>(Location.Z) - static_cast<float>(Center.Z);
+		return DX * DX + DY * DY + DZ * DZ;
+	}
+
+	/// One table sweep per player, merged and ordered by distance to the nearest player
+	void QueryPerPlayer(const FResourceNodeTable& Table, const std::vector<FVec3>& Players,
+	                    std::vector<int32_t>& OutIndexes)
+	{
+		std::vector<int32_t> PlayerIndexes;
+		std::vector<std::pair<float, int32_t>> Found;
+		for (const FVec3& Player : Players)
+		{
+			Table.QueryUnsettledInRadius(Player, NodeUpdateRadius, PlayerIndexes);
+			for (const int32_t Index : PlayerIndexes)
+			{
+				float NearestDistSquared = KernelDistSquared(Table.GetLocation(Index), Players[0]);
+				for (const FVec3& Other : Players)
+				{
+					NearestDistSquared = std::min(NearestDistSquared,
+					                              KernelDistSquared(Table.GetLocation(Index), Other));
+				}
+				Found.emplace_back(NearestDistSquared, Index);
+			}
+		}
+		std::sort(Found.begin(), Found.end());
+		Found.erase(std::unique(Found.begin(), Found.end()), Found.end());
+		OutIndexes.clear();
+		for (const std::pair<float, int32_t>& Entry : Found)
+		{
+			OutIndexes.push_back(Entry.second);
+		}
+	}
+
+	void QueryFatNodes(const std::vector<FFatNodeData>& Nodes, const FVec3& Center, std::vector<int32_t>& OutIndexes)
+	{
+		OutIndexes.clear();
+		for (int32_t i = 0; i < static_cast<int32_t>(Nodes.size()); ++i)
+		{
+			if (!Nodes[i].IsRayCasted && DistSquared(Nodes[i].Location, Center) <= NodeUpdateRadius * NodeUpdateRadius)
+			{
+				OutIndexes.push_back(i);
+			}
+		}
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t NumQueries = Argc > 1 ? std::max(1, std::atoi(Argv[1])) : 20000;
+	const int32_t Seed = Argc > 2 ? std::atoi(Argv[2]) : 1337;
+
+	const std::vector<FDumpNode> DumpNodes = LoadNodeDump(RR_NUMBER_CRUNCHING_DIR "/resource_nodes_log.txt");
+	if (DumpNodes.empty())
+	{
+		std::fprintf(stderr, "Couldn't load any nodes from resource_nodes_log.txt\n");
+		return 1;
+	}
+
+	std::printf("Node sweep benchmark, %d player radius queries per scale, seed %d\n", NumQueries, Seed);
+	std::printf("%-6s %8s %-10s %10s %10s %12s %10s\n", "Scale", "Nodes", "Layout", "Bytes", "Total ms", "ns/query",
+	            "Found");
+
+	bool bAllMatch = true;
+	for (const int32_t Scale : {1, 10, 100})
+	{
+		const FSyntheticWorld World = BuildSyntheticWorld(DumpNodes, Scale, Seed);
+		FSeededRandomStream RandomStream(Seed);
+
+		// About half the nodes already settled, like a while into a session
+		std::vector<FFatNodeData> FatNodes(World.Nodes.size());
+		FResourceNodeTable Table;
+		Table.Reset(World.Nodes.size());
+		for (size_t i = 0; i < World.Nodes.size(); ++i)
+		{
+			FatNodes[i].Classname = "BP_ResourceNode_C";
+			FatNodes[i].Location = World.Nodes[i].Location;
+			FatNodes[i].Purity = static_cast<uint8_t>(World.Nodes[i].Purity);
+			FatNodes[i].IsRayCasted = RandomStream.GetFraction() < 0.5f;
+			Table.Add(World.Nodes[i].Location, FatNodes[i].IsRayCasted);
+		}
+
+		// Players stand next to nodes, that's where the interesting queries are
+		std::vector<FVec3> Centers(NumQueries);
+		for (FVec3& Center : Centers)
+		{
+			Center = World.Nodes[RandomStream.RandHelper(static_cast<int32_t>(World.Nodes.size()))].Location;
+		}
+
+		std::vector<int32_t> FatIndexes;
+		int64_t NumFatFound = 0;
+		const FStopwatch FatStopwatch;
+		for (const FVec3& Center : Centers)
+		{
+			QueryFatNodes(FatNodes, Center, FatIndexes);
+			NumFatFound += static_cast<int64_t>(FatIndexes.size());
+		}
+		const double FatMilliseconds = FatStopwatch.GetElapsedMilliseconds();
+
+		std::vector<int32_t> TableIndexes;
+		int64_t NumTableFound = 0;
+		const FStopwatch TableStopwatch;
+		for (const FVec3& Center : Centers)
+		{
+			Table.QueryUnsettledInRadius(Center, NodeUpdateRadius, TableIndexes);
+			NumTableFound += static_cast<int64_t>(TableIndexes.size());
+		}
+		const double TableMilliseconds = TableStopwatch.GetElapsedMilliseconds();
+
+		// Float positions can only disagree right on the edge of the radius, count any query that differs
+		int32_t NumMismatchedQueries = 0;
+		for (const FVec3& Center : Centers)
+		{
+			QueryFatNodes(FatNodes, Center, FatIndexes);
+			Table.QueryUnsettledInRadius(Center, NodeUpdateRadius, TableIndexes);
+			NumMismatchedQueries += FatIndexes != TableIndexes;
+		}
+		bAllMatch &= NumMismatchedQueries == 0;
+
+		const size_t TableBytes = World.Nodes.size() * 3 * sizeof(float) + (World.Nodes.size() + 63) / 64 * 8;
+		std::printf("%-6d %8zu %-10s %10zu %10.3f %12.1f %10lld\n", Scale, World.Nodes.size(), "Structs",
+		            World.Nodes.size() * sizeof(FFatNodeData), FatMilliseconds, FatMilliseconds * 1e6 / NumQueries,
+		            static_cast<long long>(NumFatFound));
+		std::printf("%-6d %8zu %-10s %10zu %10.3f %12.1f %10lld%s\n", Scale, World.Nodes.size(), "Table",
+		            TableBytes, TableMilliseconds, TableMilliseconds * 1e6 / NumQueries,
+		            static_cast<long long>(NumTableFound),
+		            NumMismatchedQueries == 0 ? "" : " (MISMATCH)");
+
+		// Groups of players spread over the map, ns/query is per group
+		const int32_t NumGroups = NumQueries / NumPlayers;
+		std::vector<std::vector<FVec3>> Groups(NumGroups);
+		for (int32_t i = 0; i < NumGroups; ++i)
+		{
+			Groups[i].assign(Centers.begin() + i * NumPlayers, Centers.begin() + (i + 1) * NumPlayers);
+		}
+
+		std::vector<int32_t> PerPlayerIndexes;
+		int64_t NumPerPlayerFound = 0;
+		const FStopwatch PerPlayerStopwatch;
+		for (const std::vector<FVec3>& Players : Groups)
+		{
+			QueryPerPlayer(Table, Players, PerPlayerIndexes);
+			NumPerPlayerFound += static_cast<int64_t>(PerPlayerIndexes.size());
+		}
+		const double PerPlayerMilliseconds = PerPlayerStopwatch.GetElapsedMilliseconds();
+
+		std::vector<int32_t> BatchedIndexes;
+		int64_t NumBatchedFound = 0;
+		const FStopwatch BatchedStopwatch;
+		for (const std::vector<FVec3>& Players : Groups)
+		{
+			Table.QueryUnsettledNearCenters(Players, NodeUpdateRadius, BatchedIndexes);
+			NumBatchedFound += static_cast<int64_t>(BatchedIndexes.size());
+		}
+		const double BatchedMilliseconds = BatchedStopwatch.GetElapsedMilliseconds();
+
+		int32_t NumMismatchedGroups = 0;
+		for (const std::vector<FVec3>& Players : Groups)
+		{
+			QueryPerPlayer(Table, Players, PerPlayerIndexes);
+			Table.QueryUnsettledNearCenters(Players, NodeUpdateRadius, BatchedIndexes);
+			NumMismatchedGroups += PerPlayerIndexes != BatchedIndexes;
+		}
+		bAllMatch &= NumMismatchedGroups == 0;
+
+		std::printf("%-6d %8zu %-10s %10zu %10.3f %12.1f %10lld\n", Scale, World.Nodes.size(), "PerPlayer",
+		            TableBytes, PerPlayerMilliseconds, PerPlayerMilliseconds * 1e6 / std::max(NumGroups, 1),
+		            static_cast<long long>(NumPerPlayerFound));
+		std::printf("%-6d %8zu %-10s %10zu %10.3f %12.1f %10lld%s\n", Scale, World.Nodes.size(), "Batched",
+		            TableBytes, BatchedMilliseconds, BatchedMilliseconds * 1e6 / std::max(NumGroups, 1),
+		            static_cast<long long>(NumBatchedFound), NumMismatchedGroups == 0 ? "" : " (MISMATCH)");
+	}
+	return bAllMatch ? 0 : 1;
+}
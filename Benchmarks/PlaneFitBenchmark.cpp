@@ -0,0 +1,283 @@
+// Fits planes to synthetic settle hits (the same Vogel disk the node settle traces, on a tilted slope with noise
+// and a share of points landing on rocks) and compares the old RANSAC fit against FitPlaneNormal, both for speed
+// and for how far the normal ends up from the real slope. Fails if the least squares fit misses the accuracy bar or
+// is slower than RANSAC on any scenario.
+//
+// Usage: PlaneFitBenchmark [Cases] [Seed]
+
+#include "BenchmarkCommon.h"
+#include "RandomizerCore/ResourcePlaneFit.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	constexpr int32_t NumSettleTracePoints = 50;
+	constexpr double SettleRadius = 800.0;
+	constexpr double DistanceThreshold = 50.0;
+	constexpr double Pi = 3.14159265358979323846;
+
+	// Largest average and 99th percentile error FitPlaneNormal may have before the run counts as failed. Its worst case
+	// also can't be worse than RANSAC's, unless both are within the 99th percentile bar
+	constexpr double MaxMeanErrorDegrees = 0.5;
+	constexpr double MaxP99ErrorDegrees = 1.0;
+
+	struct FPlaneFitCase
+	{
+		FVec3 Normal;
+		std::vector<FVec3> Points;
+	};
+
+	double Dot(const FVec3& A, const FVec3& B)
+	{
+		return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+	}
+
+	double AngleDegrees(const FVec3& A, const FVec3& B)
+	{
+		return std::acos(std::clamp(Dot(A, B), -1.0, 1.0)) * 180.0 / Pi;
+	}
+
+	double Gaussian(FSeededRandomStream& RandomStream)
+	{
+		const double U1 = 1.0 - RandomStream.GetFraction();
+		const double U2 = RandomStream.GetFraction();
+		return std::sqrt(-2.0 * std::log(U1)) * std::cos(2.0 * Pi * U2);
+	}
+
+	/// Slope up to 35 degrees in any direction, hits at the Vogel disk positions with a few cm of noise and
+	/// OutlierFraction of them raised 1-4m like they hit a rock or a foundation
+	FPlaneFitCase MakeCase(FSeededRandomStream& RandomStream, const double NoiseSigma, const double OutlierFraction)
+	{
+		const double Tilt = RandomStream.GetFraction() * 35.0 * Pi / 180.0;
+		const double Azimuth = RandomStream.GetFraction() * 2.0 * Pi;
+		FPlaneFitCase Case;
+		Case.Normal = {std::sin(Tilt) * std::cos(Azimuth), std::sin(Tilt) * std::sin(Azimuth), std::cos(Tilt)};
+		const FVec3 Origin{
+			(RandomStream.GetFraction() - 0.5) * 600000.0, (RandomStream.GetFraction() - 0.5) * 600000.0,
+			RandomStream.GetFraction() * 40000.0
+		};
+
+		constexpr double GoldenAngle = 2.39996;
+		for (int32_t i = 0; i < NumSettleTracePoints; ++i)
+		{
+			const double Distance = SettleRadius * std::sqrt(static_cast<double>(i) / NumSettleTracePoints);
+			const double X = std::cos(i * GoldenAngle) * Distance;
+			const double Y = std::sin(i * GoldenAngle) * Distance;
+			double Z = -(Case.Normal.X * X + Case.Normal.Y * Y) / Case.Normal.Z + Gaussian(RandomStream) * NoiseSigma;
+			if (RandomStream.GetFraction() < OutlierFraction)
+			{
+				Z += 100.0 + RandomStream.GetFraction() * 300.0;
+			}
+			Case.Points.push_back({Origin.X + X, Origin.Y + Y, Origin.Z + Z});
+		}
+		return Case;
+	}
+
+	/// UResourceRouletteUtility::CalculateBestFitPlaneNormal before it moved to FitPlaneNormal, with FMath::RandRange
+	/// swapped for a seeded stream
+	FVec3 FitPlaneNormalRansac(const std::vector<FVec3>& Points, FSeededRandomStream& RandomStream)
+	{
+		const int32_t MaxIterations = 50;
+		const int32_t NumPoints = static_cast<int32_t>(Points.size());
+		int32_t BestInlierCount = 0;
+		FVec3 BestPlaneNormal{0.0, 0.0, 1.0};
+		for (int32_t i = 0; i < MaxIterations; ++i)
+		{
+			const int32_t Index1 = RandomStream.RandRange(0, NumPoints - 1);
+			int32_t Index2 = RandomStream.RandRange(0, NumPoints - 1);
+			int32_t Index3 = RandomStream.RandRange(0, NumPoints - 1);
+			while (Index2 == Index1)
+			{
+				Index2 = RandomStream.RandRange(0, NumPoints - 1);
+			}
+			while (Index3 == Index1 || Index3 == Index2)
+			{
+				Index3 = RandomStream.RandRange(0, NumPoints - 1);
+			}
+			const FVec3& P1 = Points[Index1];
+			const FVec3 A{Points[Index2].X - P1.X, Points[Index2].Y - P1.Y, Points[Index2].Z - P1.Z};
+			const FVec3 B{Points[Index3].X - P1.X, Points[Index3].Y - P1.Y, Points[Index3].Z - P1.Z};
+			FVec3 PlaneNormal{A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X};
+			const double Length = std::sqrt(Dot(PlaneNormal, PlaneNormal));
+			if (Length <= 1e-8)
+			{
+				continue;
+			}
+			PlaneNormal = {PlaneNormal.X / Length, PlaneNormal.Y / Length, PlaneNormal.Z / Length};
+
+			int32_t InlierCount = 0;
+			for (const FVec3& Point : Points)
+			{
+				const FVec3 Offset{Point.X - P1.X, Point.Y - P1.Y, Point.Z - P1.Z};
+				InlierCount += std::abs(Dot(Offset, PlaneNormal)) < DistanceThreshold;
+			}
+			if (InlierCount > BestInlierCount)
+			{
+				BestInlierCount = InlierCount;
+				BestPlaneNormal = PlaneNormal;
+			}
+		}
+		if (BestPlaneNormal.Z < 0.0)
+		{
+			BestPlaneNormal = {-BestPlaneNormal.X, -BestPlaneNormal.Y, -BestPlaneNormal.Z};
+		}
+		return BestPlaneNormal;
+	}
+
+	/// Fixed inputs with whole centimetre coordinates so building them can't round differently anywhere: a 7x7 grid
+	/// on a slope far from the origin, then the same with a few cm of bumps, then with about one in five points
+	/// raised 1.5-3m like rocks
+	constexpr int32_t NumGoldenCases = 3;
+
+	std::vector<FVec3> MakeGoldenPoints(const int32_t Variant)
+	{
+		std::vector<FVec3> Points;
+		for (int32_t i = -3; i <= 3; ++i)
+		{
+			for (int32_t j = -3; j <= 3; ++j)
+			{
+				const int32_t X = i * 150 + (j * 37) % 50;
+				const int32_t Y = j * 150;
+				int32_t Z = (3 * X - 2 * Y) / 10;
+				if (Variant >= 1)
+				{
+					Z += (i * 7 + j * 3 + 100) % 5 - 2;
+				}
+				if (Variant >= 2 && (i * 5 + j * 3 + 100) % 5 == 0)
+				{
+					Z += 150 + 50 * ((i + j + 100) % 4);
+				}
+				Points.push_back({123456.0 + X, -65432.0 + Y, 9000.0 + Z});
+			}
+		}
+		return Points;
+	}
+
+	// Bit patterns of FitPlaneNormal's X, Y and Z for each golden case
+	constexpr uint64_t GoldenNormalBits[NumGoldenCases][3] = {
+		{0xbfd2024cc5d91026ULL, 0x3fc7eeff76552186ULL, 0x3fee1e4f8aca7a77ULL},
+		{0xbfd20118e958c006ULL, 0x3fc7e989fd0d8a6eULL, 0x3fee1ec2edcaf51bULL},
+		{0xbfd201e2b7ddcc54ULL, 0x3fc7e9d5c391a878ULL, 0x3fee1ea10235a4a7ULL},
+	};
+
+	uint64_t ToBits(const double Value)
+	{
+		uint64_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	struct FFitStats
+	{
+		double Milliseconds = 0.0;
+		double MeanErrorDegrees = 0.0;
+		double P99ErrorDegrees = 0.0;
+		double MaxErrorDegrees = 0.0;
+	};
+
+	template <typename FitFunction>
+	FFitStats MeasureFit(const std::vector<FPlaneFitCase>& Cases, FitFunction&& Fit)
+	{
+		std::vector<FVec3> Normals(Cases.size());
+		const FStopwatch Stopwatch;
+		for (size_t i = 0; i < Cases.size(); ++i)
+		{
+			Normals[i] = Fit(Cases[i].Points);
+		}
+		FFitStats Stats;
+		Stats.Milliseconds = Stopwatch.GetElapsedMilliseconds();
+		std::vector<double> Errors(Cases.size());
+		for (size_t i = 0; i < Cases.size(); ++i)
+		{
+			Errors[i] = AngleDegrees(Normals[i], Cases[i].Normal);
+			Stats.MeanErrorDegrees += Errors[i] / static_cast<double>(Cases.size());
+		}
+		std::sort(Errors.begin(), Errors.end());
+		Stats.P99ErrorDegrees = Errors[std::min(Errors.size() - 1, Errors.size() * 99 / 100)];
+		Stats.MaxErrorDegrees = Errors.back();
+		return Stats;
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t NumCases = Argc > 1 ? std::max(1, std::atoi(Argv[1])) : 20000;
+	const int32_t Seed = Argc > 2 ? std::atoi(Argv[2]) : 1337;
+
+	std::printf("Plane fit benchmark, %d cases of %d points per scenario, seed %d\n", NumCases, NumSettleTracePoints,
+	            Seed);
+	std::printf("%-22s %-8s %10s %8s %9s %9s %9s\n", "Scenario", "Fit", "Total ms", "us/fit", "Mean deg",
+	            "P99 deg", "Max deg");
+
+	struct FScenario
+	{
+		const char* Name;
+		double NoiseSigma;
+		double OutlierFraction;
+	};
+	const FScenario Scenarios[] = {
+		{"Clean slope", 0.0, 0.0},
+		{"Noisy slope", 8.0, 0.0},
+		{"Noisy, 10% outliers", 8.0, 0.1},
+		{"Noisy, 20% outliers", 8.0, 0.2},
+	};
+
+	bool bPassed = true;
+	for (const FScenario& Scenario : Scenarios)
+	{
+		FSeededRandomStream CaseStream(Seed);
+		std::vector<FPlaneFitCase> Cases;
+		Cases.reserve(NumCases);
+		for (int32_t i = 0; i < NumCases; ++i)
+		{
+			Cases.push_back(MakeCase(CaseStream, Scenario.NoiseSigma, Scenario.OutlierFraction));
+		}
+
+		FSeededRandomStream RansacStream(Seed);
+		const FFitStats RansacStats = MeasureFit(Cases, [&](const std::vector<FVec3>& Points)
+		{
+			return FitPlaneNormalRansac(Points, RansacStream);
+		});
+		const FFitStats LeastSquaresStats = MeasureFit(Cases, [&](const std::vector<FVec3>& Points)
+		{
+			return FitPlaneNormal(Points.data(), static_cast<int32_t>(Points.size()));
+		});
+
+		const bool bAccurate = LeastSquaresStats.MeanErrorDegrees <= MaxMeanErrorDegrees &&
+			LeastSquaresStats.P99ErrorDegrees <= MaxP99ErrorDegrees &&
+			LeastSquaresStats.MaxErrorDegrees <= std::max(RansacStats.MaxErrorDegrees, MaxP99ErrorDegrees);
+		// The point of the change was faster settles, so it can't cost more than what it replaced
+		const bool bFaster = LeastSquaresStats.Milliseconds <= RansacStats.Milliseconds;
+		bPassed &= bAccurate && bFaster;
+
+		std::printf("%-22s %-8s %10.3f %8.3f %9.4f %9.4f %9.4f\n", Scenario.Name, "RANSAC", RansacStats.Milliseconds,
+		            RansacStats.Milliseconds * 1000.0 / NumCases, RansacStats.MeanErrorDegrees,
+		            RansacStats.P99ErrorDegrees, RansacStats.MaxErrorDegrees);
+		std::printf("%-22s %-8s %10.3f %8.3f %9.4f %9.4f %9.4f%s%s\n", Scenario.Name, "LeastSq",
+		            LeastSquaresStats.Milliseconds, LeastSquaresStats.Milliseconds * 1000.0 / NumCases,
+		            LeastSquaresStats.MeanErrorDegrees, LeastSquaresStats.P99ErrorDegrees,
+		            LeastSquaresStats.MaxErrorDegrees, bAccurate ? "" : " (INACCURATE)", bFaster ? "" : " (SLOWER)");
+	}
+
+	// Same input has to give the same bits on every machine, that's the point of dropping RANSAC. Fitting twice in
+	// one process can't show that, so the golden cases are checked against normals recorded once
+	for (int32_t Variant = 0; Variant < NumGoldenCases; ++Variant)
+	{
+		const std::vector<FVec3> Points = MakeGoldenPoints(Variant);
+		const FVec3 Normal = FitPlaneNormal(Points.data(), static_cast<int32_t>(Points.size()));
+		const uint64_t Bits[3] = {ToBits(Normal.X), ToBits(Normal.Y), ToBits(Normal.Z)};
+		const bool bMatches = std::equal(Bits, Bits + 3, GoldenNormalBits[Variant]);
+		bPassed &= bMatches;
+		std::printf("Golden case %d: %016llx %016llx %016llx%s\n", Variant, static_cast<unsigned long long>(Bits[0]),
+		            static_cast<unsigned long long>(Bits[1]), static_cast<unsigned long long>(Bits[2]),
+		            bMatches ? "" : " (DOESN'T MATCH THE RECORDED NORMAL)");
+	}
+	return bPassed ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Compares the nested map purity budget UResourcePurityManager used to keep against the flat FPurityBudget,
+// then drains a budget from several threads with TryDecrementAtomic to check it never overdraws.
+//
+// Usage: PurityBudgetBenchmark [Lookups] [Threads] [Seed]
+
+#include "BenchmarkCommon.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unordered_map>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	struct FPurityQuery
+	{
+		int32_t ClassIndex;
+		EPurity Purity;
+	};
+
+	/// Stand-in for TMap<FName, TMap<EResourcePurity, int32>>, FName compares and hashes as an integer
+	using FNestedPurityCounts = std::unordered_map<int32_t, std::unordered_map<EPurity, int32_t>>;
+
+	/// Same lookups the old UResourcePurityManager::IsPurityAvailable did, two Contains and two operator[]
+	bool IsPurityAvailableNested(FNestedPurityCounts& Counts, const int32_t ClassIndex, const EPurity Purity)
+	{
+		if (Counts.count(ClassIndex))
+		{
+			auto& PurityCounts = Counts[ClassIndex];
+			return PurityCounts.count(Purity) && PurityCounts[Purity] > 0;
+		}
+		return false;
+	}
+
+	FNestedPurityCounts ToNested(const FPurityBudget& Budget)
+	{
+		FNestedPurityCounts Counts;
+		for (int32_t ClassIndex = 0; ClassIndex < Budget.GetNumClasses(); ++ClassIndex)
+		{
+			for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+			{
+				if (Budget.At(ClassIndex, Purity) > 0)
+				{
+					Counts[ClassIndex][Purity] = Budget.At(ClassIndex, Purity);
+				}
+			}
+		}
+		return Counts;
+	}
+
+	int64_t SumBudget(const FPurityBudget& Budget)
+	{
+		int64_t Sum = 0;
+		for (int32_t ClassIndex = 0; ClassIndex < Budget.GetNumClasses(); ++ClassIndex)
+		{
+			for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+			{
+				Sum += Budget.At(ClassIndex, Purity);
+			}
+		}
+		return Sum;
+	}
+
+	/// Every thread walks the same queries from a different offset and takes whatever is left
+	void RunAtomicDrain(const FPurityBudget& InitialBudget, const std::vector<FPurityQuery>& Queries,
+	                    const int32_t NumThreads)
+	{
+		FPurityBudget Budget = InitialBudget;
+		std::vector<int64_t> NumTaken(NumThreads, 0);
+		const FStopwatch Stopwatch;
+		std::vector<std::thread> Threads;
+		for (int32_t ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+		{
+			Threads.emplace_back([&, ThreadIndex]
+			{
+				const size_t Offset = Queries.size() * ThreadIndex / NumThreads;
+				for (size_t i = 0; i < Queries.size(); ++i)
+				{
+					const FPurityQuery& Query = Queries[(Offset + i) % Queries.size()];
+					NumTaken[ThreadIndex] += Budget.TryDecrementAtomic(Query.ClassIndex, Query.Purity);
+				}
+			});
+		}
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+		const double Milliseconds = Stopwatch.GetElapsedMilliseconds();
+
+		int64_t TotalTaken = 0;
+		for (const int64_t Taken : NumTaken)
+		{
+			TotalTaken += Taken;
+		}
+		const int64_t Initial = SumBudget(InitialBudget);
+		const int64_t Remaining = SumBudget(Budget);
+		bool bNeverNegative = true;
+		for (int32_t ClassIndex = 0; ClassIndex < Budget.GetNumClasses(); ++ClassIndex)
+		{
+			for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+			{
+				bNeverNegative &= Budget.At(ClassIndex, Purity) >= 0;
+			}
+		}
+		std::printf("Atomic drain, %d threads x %zu attempts: %.3f ms, took %lld of %lld, %lld left%s\n", NumThreads,
+		            Queries.size(), Milliseconds, static_cast<long long>(TotalTaken), static_cast<long long>(Initial),
+		            static_cast<long long>(Remaining),
+		            bNeverNegative && TotalTaken + Remaining == Initial ? "" : " (OVERDRAWN)");
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t NumLookups = Argc > 1 ? std::max(1, std::atoi(Argv[1])) : 10000000;
+	const int32_t NumThreads = Argc > 2 ? std::max(1, std::atoi(Argv[2])) : 8;
+	const int32_t Seed = Argc > 3 ? std::atoi(Argv[3]) : 1337;
+
+	const std::vector<FDumpNode> DumpNodes = LoadNodeDump(RR_NUMBER_CRUNCHING_DIR "/resource_nodes_log.txt");
+	if (DumpNodes.empty())
+	{
+		std::fprintf(stderr, "Couldn't load any nodes from resource_nodes_log.txt\n");
+		return 1;
+	}
+
+	// Query the classes and purities the randomizer would ask for, in node order like ProcessNodes does
+	const FSyntheticWorld World = BuildSyntheticWorld(DumpNodes, 1, Seed);
+	FSeededRandomStream RandomStream(Seed);
+	std::vector<FPurityQuery> Queries;
+	Queries.reserve(NumLookups);
+	for (int32_t i = 0; i < NumLookups; ++i)
+	{
+		const FNodeEntry& Node = World.Nodes[i % World.Nodes.size()];
+		Queries.push_back({Node.ClassIndex, static_cast<EPurity>(RandomStream.RandHelper(3))});
+	}
+
+	std::printf("Purity budget benchmark, %d lookups over %d classes, seed %d\n", NumLookups,
+	            World.Budget.GetNumClasses(), Seed);
+
+	FNestedPurityCounts NestedCounts = ToNested(World.Budget);
+	int64_t NumNestedAvailable = 0;
+	const FStopwatch NestedStopwatch;
+	for (const FPurityQuery& Query : Queries)
+	{
+		NumNestedAvailable += IsPurityAvailableNested(NestedCounts, Query.ClassIndex, Query.Purity);
+	}
+	const double NestedMilliseconds = NestedStopwatch.GetElapsedMilliseconds();
+
+	int64_t NumFlatAvailable = 0;
+	const FStopwatch FlatStopwatch;
+	for (const FPurityQuery& Query : Queries)
+	{
+		NumFlatAvailable += IsPurityAvailable(World.Budget, Query.ClassIndex, Query.Purity);
+	}
+	const double FlatMilliseconds = FlatStopwatch.GetElapsedMilliseconds();
+
+	std::printf("%-14s %10s %12s %12s\n", "Layout", "Total ms", "ns/lookup", "Available");
+	std::printf("%-14s %10.3f %12.3f %12lld\n", "Nested maps", NestedMilliseconds,
+	            NestedMilliseconds * 1e6 / NumLookups, static_cast<long long>(NumNestedAvailable));
+	std::printf("%-14s %10.3f %12.3f %12lld\n", "Flat table", FlatMilliseconds, FlatMilliseconds * 1e6 / NumLookups,
+	            static_cast<long long>(NumFlatAvailable));
+
+	RunAtomicDrain(World.Budget, Queries, NumThreads);
+	return NumNestedAvailable == NumFlatAvailable ? 0 : 1;
+}
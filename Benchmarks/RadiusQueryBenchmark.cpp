@@ -0,0 +1,134 @@
+// Throughput of the radius query kernels (scalar, SSE, AVX2) over packed node positions, in nodes checked per
+// nanosecond, and a check that every kernel returns exactly the same mask as the scalar one.
+//
+// Usage: RadiusQueryBenchmark [NodesPerSet] [Seed]
+
+#include "BenchmarkCommon.h"
+#include "RandomizerCore/ResourceRadiusQuery.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	struct FPositionSet
+	{
+		const char* Name;
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+		double Radius;
+
+		FPackedPositions GetPacked() const { return {X.data(), Y.data(), Z.data(), X.size()}; }
+	};
+
+	FPositionSet FromWorld(const char* Name, const FSyntheticWorld& World, const double Radius)
+	{
+		FPositionSet Set{Name, {}, {}, {}, Radius};
+		for (const FNodeEntry& Node : World.Nodes)
+		{
+			Set.X.push_back(static_cast<float>(Node.Location.X));
+			Set.Y.push_back(static_cast<float>(Node.Location.Y));
+			Set.Z.push_back(static_cast<float>(Node.Location.Z));
+		}
+		return Set;
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t NumUniformNodes = Argc > 1 ? std::max(1, std::atoi(Argv[1])) : 1000000;
+	const int32_t Seed = Argc > 2 ? std::atoi(Argv[2]) : 1337;
+
+	const std::vector<FDumpNode> DumpNodes = LoadNodeDump(RR_NUMBER_CRUNCHING_DIR "/resource_nodes_log.txt");
+	if (DumpNodes.empty())
+	{
+		std::fprintf(stderr, "Couldn't load any nodes from resource_nodes_log.txt\n");
+		return 1;
+	}
+
+	// Player radius on the real map sizes, extractor radius on the big one and a plain uniform cloud
+	std::vector<FPositionSet> Sets;
+	Sets.push_back(FromWorld("Map 1x, 250m", BuildSyntheticWorld(DumpNodes, 1, Seed), 25000.0));
+	Sets.push_back(FromWorld("Map 10x, 250m", BuildSyntheticWorld(DumpNodes, 10, Seed), 25000.0));
+	Sets.push_back(FromWorld("Map 100x, 7m", BuildSyntheticWorld(DumpNodes, 100, Seed), 700.0));
+	{
+		FPositionSet Uniform{"Uniform, 250m", {}, {}, {}, 25000.0};
+		FSeededRandomStream RandomStream(Seed);
+		for (int32_t i = 0; i < NumUniformNodes; ++i)
+		{
+			Uniform.X.push_back((RandomStream.GetFraction() - 0.5f) * 800000.0f);
+			Uniform.Y.push_back((RandomStream.GetFraction() - 0.5f) * 800000.0f);
+			Uniform.Z.push_back(RandomStream.GetFraction() * 60000.0f);
+		}
+		Sets.push_back(std::move(Uniform));
+	}
+
+	std::printf("Radius query benchmark, best kernel here is %s, seed %d\n",
+	            GetRadiusQueryKernelName(ERadiusQueryKernel::Best), Seed);
+	std::printf("%-16s %9s %-8s %8s %12s %12s %10s\n", "Set", "Nodes", "Kernel", "Queries", "ns/query", "Nodes/ns",
+	            "Hits");
+
+	bool bAllMatch = true;
+	for (const FPositionSet& Set : Sets)
+	{
+		const FPackedPositions Positions = Set.GetPacked();
+		// Roughly 200M node checks per kernel, enough to time even the smallest set
+		const int32_t NumQueries = static_cast<int32_t>(std::clamp<size_t>(200000000 / Positions.Num, 16, 200000));
+		FSeededRandomStream RandomStream(Seed);
+		std::vector<FVec3> Centers(NumQueries);
+		for (FVec3& Center : Centers)
+		{
+			const size_t Index = RandomStream.RandHelper(static_cast<int32_t>(Positions.Num));
+			Center = {Positions.X[Index], Positions.Y[Index], Positions.Z[Index]};
+		}
+
+		std::vector<uint64_t> ScalarMask((Positions.Num + 63) / 64);
+		std::vector<uint64_t> Mask(ScalarMask.size());
+		for (const ERadiusQueryKernel Kernel : {ERadiusQueryKernel::Scalar, ERadiusQueryKernel::SSE,
+		                                        ERadiusQueryKernel::AVX2})
+		{
+			if (!IsRadiusQueryKernelSupported(Kernel))
+			{
+				std::printf("%-16s %9zu %-8s %8s\n", Set.Name, Positions.Num, GetRadiusQueryKernelName(Kernel),
+				            "n/a");
+				continue;
+			}
+
+			int64_t NumHits = 0;
+			const FStopwatch Stopwatch;
+			for (const FVec3& Center : Centers)
+			{
+				QueryRadiusMask(Positions, Center, Set.Radius, Mask.data(), Kernel);
+				NumHits += Mask[0] & 1;
+			}
+			const double Milliseconds = Stopwatch.GetElapsedMilliseconds();
+
+			// Every kernel has to agree with scalar on every bit
+			bool bMatches = true;
+			NumHits = 0;
+			for (const FVec3& Center : Centers)
+			{
+				QueryRadiusMask(Positions, Center, Set.Radius, ScalarMask.data(), ERadiusQueryKernel::Scalar);
+				QueryRadiusMask(Positions, Center, Set.Radius, Mask.data(), Kernel);
+				bMatches &= Mask == ScalarMask;
+				for (const uint64_t Word : Mask)
+				{
+					NumHits += static_cast<int64_t>(std::bitset<64>(Word).count());
+				}
+			}
+			bAllMatch &= bMatches;
+
+			const double Nanoseconds = Milliseconds * 1e6;
+			std::printf("%-16s %9zu %-8s %8d %12.1f %12.3f %10lld%s\n", Set.Name, Positions.Num,
+			            GetRadiusQueryKernelName(Kernel), NumQueries, Nanoseconds / NumQueries,
+			            static_cast<double>(Positions.Num) * NumQueries / Nanoseconds,
+			            static_cast<long long>(NumHits), bMatches ? "" : " (MISMATCH)");
+		}
+	}
+	return bAllMatch ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Replays the node dumps in NumberCrunching/ through the randomizer core at 1x, 10x and 100x the
+// vanilla node count and reports wall time, heap traffic, peak memory and purity shortfalls per run. The parallel
+// by class mode is run with 1, 2, 4 and 8 threads and must give the same layout for all of them.
+//
+// Usage: RandomizerBenchmark [Iterations] [Seed]
+
+#include "BenchmarkCommon.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+
+using namespace ResourceRouletteBenchmark;
+using namespace ResourceRouletteCore;
+
+namespace
+{
+	/// @return Layout hash of the last iteration
+	uint64_t RunScenario(const char* DumpName, const std::vector<FDumpNode>& DumpNodes, const int32_t Scale,
+	                     const int32_t Iterations, const int32_t Seed, const int32_t NumThreads = 0)
+	{
+		FSyntheticWorld World = BuildSyntheticWorld(DumpNodes, Scale, Seed);
+		// With one thread each task is timed on its own. The serial part plus the longest task is what the run
+		// comes down to with a core per task, which a machine with fewer cores than threads can't show in the wall
+		// time. More threads than cores would time the tasks sharing a core, so those runs don't report it
+		std::vector<double> TaskMilliseconds;
+		if (NumThreads > 0)
+		{
+			World.Options.bParallelByClass = true;
+			World.Options.ParallelFor = [ThreadParallelFor = MakeThreadParallelFor(NumThreads), &TaskMilliseconds](
+				const int32_t NumTasks, const std::function<void(int32_t)>& Task)
+			{
+				TaskMilliseconds.assign(NumTasks, 0.0);
+				ThreadParallelFor(NumTasks, [&Task, &TaskMilliseconds](const int32_t TaskIndex)
+				{
+					const FStopwatch TaskStopwatch;
+					Task(TaskIndex);
+					TaskMilliseconds[TaskIndex] = TaskStopwatch.GetElapsedMilliseconds();
+				});
+			};
+		}
+
+		std::vector<double> Timings;
+		std::vector<double> CriticalPathTimings;
+		FAllocationStats AllocationStats;
+		uint64_t LayoutHash = 0;
+		size_t NumAssignments = 0;
+		int32_t NumPurityShortfalls = 0;
+		bool bDeterministic = true;
+		for (int32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			FPurityBudget Budget = World.Budget;
+
+			FScopedAllocationTracker AllocationTracker;
+			const FStopwatch Stopwatch;
+			const FRandomizerResult Result = RandomizeNodes(World.Nodes, Budget, World.Options);
+			Timings.push_back(Stopwatch.GetElapsedMilliseconds());
+			AllocationStats = AllocationTracker.GetStats();
+			if (NumThreads == 1 && !TaskMilliseconds.empty())
+			{
+				CriticalPathTimings.push_back(
+					Timings.back() - std::accumulate(TaskMilliseconds.begin(), TaskMilliseconds.end(), 0.0) +
+					*std::max_element(TaskMilliseconds.begin(), TaskMilliseconds.end()));
+			}
+
+			const uint64_t Hash = HashAssignments(Result.Assignments);
+			bDeterministic &= Iteration == 0 || Hash == LayoutHash;
+			LayoutHash = Hash;
+			NumAssignments = Result.Assignments.size();
+			NumPurityShortfalls = Result.NumPurityShortfalls;
+		}
+
+		std::sort(Timings.begin(), Timings.end());
+		std::sort(CriticalPathTimings.begin(), CriticalPathTimings.end());
+		const std::string CriticalPath = CriticalPathTimings.empty()
+			                                 ? "-"
+			                                 : std::to_string(CriticalPathTimings.front()).substr(0, 8);
+		std::printf("%-24s %5dx %7s %8zu %8zu %8d %10.3f %10.3f %10s %10llu %12llu %10llu %10ld  %016llx%s\n",
+		            DumpName, Scale, NumThreads > 0 ? std::to_string(NumThreads).c_str() : "-", World.Nodes.size(),
+		            NumAssignments, NumPurityShortfalls, Timings.front(), Timings[Timings.size() / 2],
+		            CriticalPath.c_str(), static_cast<unsigned long long>(AllocationStats.NumAllocations),
+		            static_cast<unsigned long long>(AllocationStats.BytesAllocated),
+		            static_cast<unsigned long long>(AllocationStats.PeakLiveBytes / 1024), GetPeakResidentKiB(),
+		            static_cast<unsigned long long>(LayoutHash), bDeterministic ? "" : " (NOT DETERMINISTIC)");
+		return LayoutHash;
+	}
+}
+
+int main(const int Argc, char** Argv)
+{
+	const int32_t Iterations = Argc > 1 ? std::max(1, std::atoi(Argv[1])) : 5;
+	const int32_t Seed = Argc > 2 ? std::atoi(Argv[2]) : 1337;
+
+	const std::pair<const char*, const char*> Dumps[] = {
+		{"resource_nodes_log.txt", RR_NUMBER_CRUNCHING_DIR "/resource_nodes_log.txt"},
+		{"Out_31.csv", RR_NUMBER_CRUNCHING_DIR "/Out_31.csv"},
+	};
+
+	std::printf("Randomizer core benchmark, %d iterations per scenario, seed %d\n", Iterations, Seed);
+	std::printf("%-24s %6s %7s %8s %8s %8s %10s %10s %10s %10s %12s %10s %10s  %s\n", "Dump", "Scale", "Threads",
+	            "Nodes", "Placed", "Short", "Best ms", "Median ms", "Bound ms", "Allocs", "Bytes", "Heap KiB",
+	            "RSS KiB", "Layout hash");
+	bool bParallelMatches = true;
+	for (const auto& [DumpName, DumpPath] : Dumps)
+	{
+		const std::vector<FDumpNode> DumpNodes = LoadNodeDump(DumpPath);
+		if (DumpNodes.empty())
+		{
+			std::fprintf(stderr, "Couldn't load any nodes from %s\n", DumpPath);
+			return 1;
+		}
+		for (const int32_t Scale : {1, 10, 100})
+		{
+			RunScenario(DumpName, DumpNodes, Scale, Iterations, Seed);
+		}
+		for (const int32_t Scale : {1, 10, 100})
+		{
+			uint64_t SingleThreadHash = 0;
+			for (const int32_t NumThreads : {1, 2, 4, 8})
+			{
+				const uint64_t Hash = RunScenario(DumpName, DumpNodes, Scale, Iterations, Seed, NumThreads);
+				SingleThreadHash = NumThreads == 1 ? Hash : SingleThreadHash;
+				if (Hash != SingleThreadHash)
+				{
+					std::printf("  Layout differs from the single thread run\n");
+					bParallelMatches = false;
+				}
+			}
+		}
+	}
+	return bParallelMatches ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+﻿#include "RandomizerCore/ResourceLocationGrid.h"
+#include <algorithm>
+#include <utility>
+
+namespace ResourceRouletteCore
+{
+	/// Buckets every location into a cell. Cell size should be the radius we query with most so
+	/// a query only has to touch the 3x3x3 block of cells around it
+	/// @param InLocations Candidate locations, their indexes are kept as-is
+	/// @param InCellSize Size of a grid cell in world units
+	FResourceLocationGrid::FResourceLocationGrid(std::vector<FVec3> InLocations, const double InCellSize)
+		: Locations(std::move(InLocations)),
+		  CellSize(std::max(InCellSize, 1.0)),
+		  NumRemaining(static_cast<int32_t>(Locations.size())),
+		  LastRemainingIndex(static_cast<int32_t>(Locations.size()) - 1)
+	{
+		RemainingFlags.assign(Locations.size(), 1);
+
+		std::vector<std::pair<uint64_t, int32_t>> KeyedIndexes;
+		KeyedIndexes.reserve(Locations.size());
+		for (int32_t i = 0; i < NumRemaining; ++i)
+		{
+			const FVec3& Location = Locations[i];
+			KeyedIndexes.emplace_back(
+				MakeCellKey(GetCellCoord(Location.X), GetCellCoord(Location.Y), GetCellCoord(Location.Z)), i);
+		}
+		std::sort(KeyedIndexes.begin(), KeyedIndexes.end());
+
+		CellIndexes.reserve(KeyedIndexes.size());
+		Cells.reserve(KeyedIndexes.size());
+		for (const auto& [Key, Index] : KeyedIndexes)
+		{
+			const auto It = Cells.try_emplace(Key, FCellRange{static_cast<int32_t>(CellIndexes.size()), 0}).first;
+			++It->second.Count;
+			CellIndexes.push_back(Index);
+		}
+	}
+
+	/// Marks a location as consumed. Doesn't touch the cells, queries just skip consumed locations
+	/// @param Index Index of the location to remove
+	void FResourceLocationGrid::Remove(const int32_t Index)
+	{
+		if (Index < 0 || Index >= static_cast<int32_t>(Locations.size()) || !RemainingFlags[Index])
+		{
+			return;
+		}
+		RemainingFlags[Index] = 0;
+		--NumRemaining;
+
+		// Walk the cursor down past anything consumed so the "last" location stays cheap to grab
+		while (LastRemainingIndex >= 0 && !RemainingFlags[LastRemainingIndex])
+		{
+			--LastRemainingIndex;
+		}
+	}
+
+	/// Finds every remaining location within Radius of Center
+	/// @param Center Location to search around
+	/// @param Radius Search radius
+	/// @param OutIndexes Indexes of the locations found, in no particular order
+	void FResourceLocationGrid::QueryRadius(const FVec3& Center, const double Radius,
+	                                        std::vector<int32_t>& OutIndexes) const
+	{
+		OutIndexes.clear();
+		ForEachInRadius(Center, Radius, [&OutIndexes](const int32_t Index, double)
+		{
+			OutIndexes.push_back(Index);
+		});
+	}
+
+	/// Appends every location that hasn't been removed yet, in their original order
+	/// @param OutLocations Array to append to
+	void FResourceLocationGrid::GetRemainingLocations(std::vector<FVec3>& OutLocations) const
+	{
+		OutLocations.reserve(OutLocations.size() + NumRemaining);
+		for (size_t i = 0; i < Locations.size(); ++i)
+		{
+			if (RemainingFlags[i])
+			{
+				OutLocations.push_back(Locations[i]);
+			}
+		}
+	}
+
+	int64_t FResourceLocationGrid::GetCellCoord(const double Value) const
+	{
+		return static_cast<int64_t>(std::floor(Value / CellSize));
+	}
+
+	/// Packs 21 bits per axis. Far away cells can wrap onto the same key, which only costs a few
+	/// extra distance checks since every candidate is distance tested anyway
+	uint64_t FResourceLocationGrid::MakeCellKey(const int64_t X, const int64_t Y, const int64_t Z)
+	{
+		constexpr uint64_t Mask = (1ULL << 21) - 1;
+		return ((static_cast<uint64_t>(X) & Mask) << 42) | ((static_cast<uint64_t>(Y) & Mask) << 21) |
+			(static_cast<uint64_t>(Z) & Mask);
+	}
+}
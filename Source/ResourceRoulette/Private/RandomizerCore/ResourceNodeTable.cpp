@@ -0,0 +1,232 @@
+﻿#include "RandomizerCore/ResourceNodeTable.h"
+#include "RandomizerCore/ResourceRadiusQuery.h"
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <utility>
+
+namespace ResourceRouletteCore
+{
+	/// Empties the table and makes room for NumNodes
+	/// @param NumNodes How many nodes are about to be added
+	void FResourceNodeTable::Reset(const size_t NumNodes)
+	{
+		X.clear();
+		Y.clear();
+		Z.clear();
+		SettledBits.clear();
+		NumUnsettledNodes = 0;
+		DirtyBits.clear();
+		DirtyIndexes.clear();
+		ActiveBits.clear();
+		NumActiveNodes = 0;
+		X.reserve(NumNodes);
+		Y.reserve(NumNodes);
+		Z.reserve(NumNodes);
+		SettledBits.reserve((NumNodes + 63) / 64);
+		DirtyBits.reserve((NumNodes + 63) / 64);
+		ActiveBits.reserve((NumNodes + 63) / 64);
+	}
+
+	/// @param Location Node location
+	/// @param bSettled true for nodes that never need settling, or already have been
+	void FResourceNodeTable::Add(const FVec3& Location, const bool bSettled)
+	{
+		const size_t Index = X.size();
+		X.push_back(static_cast<float>(Location.X));
+		Y.push_back(static_cast<float>(Location.Y));
+		Z.push_back(static_cast<float>(Location.Z));
+
+		if (Index % 64 == 0)
+		{
+			SettledBits.push_back(0);
+			DirtyBits.push_back(0);
+			ActiveBits.push_back(0);
+		}
+		SettledBits.back() |= static_cast<uint64_t>(bSettled) << (Index % 64);
+		NumUnsettledNodes += bSettled ? 0 : 1;
+		ActiveBits.back() |= uint64_t{1} << (Index % 64);
+		NumActiveNodes++;
+	}
+
+	/// Settling only ever moves a node up or down. Also marks it dirty
+	/// @param Index Node that got settled
+	/// @param SettledZ Where it ended up
+	void FResourceNodeTable::MarkSettled(const int32_t Index, const double SettledZ)
+	{
+		Z[Index] = static_cast<float>(SettledZ);
+		const uint64_t Bit = uint64_t{1} << (Index % 64);
+		if (!(SettledBits[Index / 64] & Bit))
+		{
+			SettledBits[Index / 64] |= Bit;
+			NumUnsettledNodes--;
+		}
+		MarkDirty(Index);
+	}
+
+	/// @param Index Node whose data changed, marking it twice before it's taken only lists it once
+	void FResourceNodeTable::MarkDirty(const int32_t Index)
+	{
+		const uint64_t Bit = uint64_t{1} << (Index % 64);
+		if (!(DirtyBits[Index / 64] & Bit))
+		{
+			DirtyBits[Index / 64] |= Bit;
+			DirtyIndexes.push_back(Index);
+		}
+	}
+
+	/// Hands over the dirty nodes and clears them. Only touches the dirty entries, so it costs nothing when
+	/// nothing changed no matter how big the table is
+	/// @param OutIndexes Cleared and filled with the dirty node indexes, in the order they got dirty
+	void FResourceNodeTable::TakeDirtyIndexes(std::vector<int32_t>& OutIndexes)
+	{
+		OutIndexes.clear();
+		OutIndexes.swap(DirtyIndexes);
+		for (const int32_t Index : OutIndexes)
+		{
+			DirtyBits[Index / 64] &= ~(uint64_t{1} << (Index % 64));
+		}
+	}
+
+	/// Every node that still needs settling within Radius of Center, in index order. Goes 64 nodes at a time so
+	/// blocks that are all settled get skipped without looking at their positions, the rest go through the SIMD
+	/// radius kernel. Once everything is settled it returns straight away
+	/// @param Center Location to search around
+	/// @param Radius Search radius
+	/// @param OutIndexes Cleared and filled with the node indexes
+	void FResourceNodeTable::QueryUnsettledInRadius(const FVec3& Center, const double Radius,
+	                                                std::vector<int32_t>& OutIndexes) const
+	{
+		OutIndexes.clear();
+		if (NumUnsettledNodes == 0)
+		{
+			return;
+		}
+		const size_t NumNodes = X.size();
+		for (size_t WordIndex = 0; WordIndex < SettledBits.size(); ++WordIndex)
+		{
+			const size_t Start = WordIndex * 64;
+			const size_t Count = std::min<size_t>(64, NumNodes - Start);
+			// Bits past the last node are never set, so the last word is only compared on the bits that are nodes
+			const uint64_t AllBits = Count == 64 ? ~uint64_t{0} : (uint64_t{1} << Count) - 1;
+			if ((SettledBits[WordIndex] & AllBits) == AllBits)
+			{
+				continue;
+			}
+			const FPackedPositions Block{X.data() + Start, Y.data() + Start, Z.data() + Start, Count};
+			uint64_t Mask = 0;
+			QueryRadiusMask(Block, Center, Radius, &Mask);
+
+			for (Mask &= ~SettledBits[WordIndex]; Mask != 0; Mask &= Mask - 1)
+			{
+				OutIndexes.push_back(static_cast<int32_t>(Start + std::countr_zero(Mask)));
+			}
+		}
+	}
+
+	/// Every node that still needs settling within Radius of any of the centers, nearest to its closest center
+	/// first. One kernel pass per block checks all the centers and keeps the distance to the nearest, which is
+	/// also the sort key, so more players don't mean more passes
+	/// @param Centers Player locations
+	/// @param Radius Search radius around each of them
+	/// @param OutIndexes Cleared and filled with the node indexes, ties go to the lower index
+	void FResourceNodeTable::QueryUnsettledNearCenters(const std::vector<FVec3>& Centers, const double Radius,
+	                                                   std::vector<int32_t>& OutIndexes) const
+	{
+		OutIndexes.clear();
+		if (NumUnsettledNodes == 0 || Centers.empty())
+		{
+			return;
+		}
+		// One pass over the whole table, words with every node settled are skipped inside the kernel
+		const size_t NumNodes = X.size();
+		std::vector<uint64_t> InsideAny(SettledBits.size());
+		const std::unique_ptr<float[]> NearestDistSquared(new float[NumNodes]);
+		QueryNearestRadiusMask({X.data(), Y.data(), Z.data(), NumNodes}, Centers.data(), Centers.size(), Radius,
+		                       InsideAny.data(), NearestDistSquared.get(), SettledBits.data());
+
+		std::vector<std::pair<float, int32_t>> Found;
+		for (size_t WordIndex = 0; WordIndex < InsideAny.size(); ++WordIndex)
+		{
+			for (uint64_t Word = InsideAny[WordIndex] & ~SettledBits[WordIndex]; Word != 0; Word &= Word - 1)
+			{
+				const size_t Index = WordIndex * 64 + std::countr_zero(Word);
+				Found.emplace_back(NearestDistSquared[Index], static_cast<int32_t>(Index));
+			}
+		}
+
+		std::sort(Found.begin(), Found.end());
+		OutIndexes.reserve(Found.size());
+		for (const std::pair<float, int32_t>& Entry : Found)
+		{
+			OutIndexes.push_back(Entry.second);
+		}
+	}
+
+	/// Works out which nodes should be active. A node switches on within ActivateRadius of any center and only
+	/// switches off again once it's past DeactivateRadius of all of them, so a player walking along the edge
+	/// doesn't flip it back and forth every update
+	/// @param Centers Player locations, with none everything ends up inactive
+	/// @param ActivateRadius Radius nodes switch on within
+	/// @param DeactivateRadius Radius nodes switch off past, should be at least ActivateRadius
+	/// @param OutActivated Cleared and filled with the nodes that just switched on
+	/// @param OutDeactivated Cleared and filled with the nodes that just switched off
+	void FResourceNodeTable::UpdateActiveNodes(const std::vector<FVec3>& Centers, const double ActivateRadius,
+	                                           const double DeactivateRadius, std::vector<int32_t>& OutActivated,
+	                                           std::vector<int32_t>& OutDeactivated)
+	{
+		OutActivated.clear();
+		OutDeactivated.clear();
+		const size_t NumNodes = X.size();
+		for (size_t WordIndex = 0; WordIndex < ActiveBits.size(); ++WordIndex)
+		{
+			const size_t Start = WordIndex * 64;
+			const FPackedPositions Block{
+				X.data() + Start, Y.data() + Start, Z.data() + Start, std::min<size_t>(64, NumNodes - Start)
+			};
+			uint64_t InsideActivate = 0;
+			uint64_t InsideDeactivate = 0;
+			for (const FVec3& Center : Centers)
+			{
+				uint64_t Mask = 0;
+				QueryRadiusMask(Block, Center, ActivateRadius, &Mask);
+				InsideActivate |= Mask;
+				QueryRadiusMask(Block, Center, DeactivateRadius, &Mask);
+				InsideDeactivate |= Mask;
+			}
+
+			const uint64_t WasActive = ActiveBits[WordIndex];
+			const uint64_t IsActiveNow = InsideActivate | (WasActive & InsideDeactivate);
+			for (uint64_t Mask = IsActiveNow & ~WasActive; Mask != 0; Mask &= Mask - 1)
+			{
+				OutActivated.push_back(static_cast<int32_t>(Start + std::countr_zero(Mask)));
+			}
+			for (uint64_t Mask = WasActive & ~IsActiveNow; Mask != 0; Mask &= Mask - 1)
+			{
+				OutDeactivated.push_back(static_cast<int32_t>(Start + std::countr_zero(Mask)));
+			}
+			ActiveBits[WordIndex] = IsActiveNow;
+		}
+		NumActiveNodes += static_cast<int32_t>(OutActivated.size()) - static_cast<int32_t>(OutDeactivated.size());
+	}
+
+	/// Switches every node back on, e.g. when activation gets turned off
+	/// @param OutActivated Cleared and filled with the nodes that were inactive
+	void FResourceNodeTable::ActivateAll(std::vector<int32_t>& OutActivated)
+	{
+		OutActivated.clear();
+		const size_t NumNodes = X.size();
+		for (size_t WordIndex = 0; WordIndex < ActiveBits.size(); ++WordIndex)
+		{
+			const size_t Start = WordIndex * 64;
+			const size_t Count = std::min<size_t>(64, NumNodes - Start);
+			const uint64_t AllBits = Count == 64 ? ~uint64_t{0} : (uint64_t{1} << Count) - 1;
+			for (uint64_t Mask = AllBits & ~ActiveBits[WordIndex]; Mask != 0; Mask &= Mask - 1)
+			{
+				OutActivated.push_back(static_cast<int32_t>(Start + std::countr_zero(Mask)));
+			}
+			ActiveBits[WordIndex] = AllBits;
+		}
+		NumActiveNodes = static_cast<int32_t>(NumNodes);
+	}
+}
@@ -0,0 +1,307 @@
+﻿#include "RandomizerCore/ResourcePlaneFit.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// The same hits have to give the same normal on every machine. Fused multiply-adds round differently from a multiply
+// and an add, and whether the compiler emits them depends on its defaults and the CPU it targets, which the mod's
+// Build.cs can't pin for the game. Fast math reordering sums would change the bits as well, so this file opts out
+// of both itself
+#if defined(__clang__)
+#pragma float_control(precise, on)
+#pragma clang fp contract(off)
+#elif defined(_MSC_VER)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off", "no-fast-math")
+#endif
+
+namespace ResourceRouletteCore
+{
+	namespace
+	{
+		// Fixed point triples the seed plane is picked from, so there's no randomness to differ between machines
+		constexpr int32_t NumSeedTriples = 16;
+		// Points this close to a seed plane count as on it, same threshold the old RANSAC used
+		constexpr double SeedInlierBand = 50.0;
+		// Tukey biweight cutoff in RMS distances of the seed plane's inliers, capped at SeedInlierBand
+		constexpr double TukeyConstant = 3.0;
+		// The cutoff is set once, so every pass is plain sums. A second pass pulls in the seeds that started a few
+		// degrees off
+		constexpr int32_t NumTukeyPasses = 2;
+
+		/// Weighted centroid and covariance of the points, relative to the first point to keep precision with
+		/// world sized coordinates
+		struct FPlaneMoments
+		{
+			double Centroid[3] = {0.0, 0.0, 0.0};
+			// XX, XY, XZ, YY, YZ, ZZ
+			double Covariance[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+		};
+
+		/// Points are kept as separate X/Y/Z/weight arrays so these loops are plain multiply-adds over
+		/// contiguous doubles, which compilers turn into SIMD on their own
+		bool AccumulateMoments(const std::vector<double>& X, const std::vector<double>& Y,
+		                       const std::vector<double>& Z, const std::vector<double>& Weights,
+		                       FPlaneMoments& OutMoments)
+		{
+			const size_t NumPoints = X.size();
+			double SumW = 0.0, SumX = 0.0, SumY = 0.0, SumZ = 0.0;
+			for (size_t i = 0; i < NumPoints; ++i)
+			{
+				SumW += Weights[i];
+				SumX += Weights[i] * X[i];
+				SumY += Weights[i] * Y[i];
+				SumZ += Weights[i] * Z[i];
+			}
+			if (SumW <= 0.0)
+			{
+				return false;
+			}
+			const double CX = SumX / SumW;
+			const double CY = SumY / SumW;
+			const double CZ = SumZ / SumW;
+
+			double XX = 0.0, XY = 0.0, XZ = 0.0, YY = 0.0, YZ = 0.0, ZZ = 0.0;
+			for (size_t i = 0; i < NumPoints; ++i)
+			{
+				const double DX = X[i] - CX;
+				const double DY = Y[i] - CY;
+				const double DZ = Z[i] - CZ;
+				XX += Weights[i] * DX * DX;
+				XY += Weights[i] * DX * DY;
+				XZ += Weights[i] * DX * DZ;
+				YY += Weights[i] * DY * DY;
+				YZ += Weights[i] * DY * DZ;
+				ZZ += Weights[i] * DZ * DZ;
+			}
+
+			OutMoments.Centroid[0] = CX;
+			OutMoments.Centroid[1] = CY;
+			OutMoments.Centroid[2] = CZ;
+			const double Covariance[6] = {XX / SumW, XY / SumW, XZ / SumW, YY / SumW, YZ / SumW, ZZ / SumW};
+			std::copy(Covariance, Covariance + 6, OutMoments.Covariance);
+			return true;
+		}
+
+		FVec3 Cross(const FVec3& A, const FVec3& B)
+		{
+			return {A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X};
+		}
+
+		double LengthSquared(const FVec3& Vector)
+		{
+			return Vector.X * Vector.X + Vector.Y * Vector.Y + Vector.Z * Vector.Z;
+		}
+
+		/// Eigenvector of the smallest eigenvalue of the symmetric covariance matrix, which is the plane normal.
+		/// The eigenvalue is the smallest root of the characteristic cubic, found with Newton's method, and the
+		/// vector is the best cross product of two rows of (A - Lambda * I). Only + - * / and sqrt, which IEEE
+		/// rounds the same everywhere, so the bits don't depend on whose acos/cos the game was built against
+		/// @return false if the points are degenerate (a line, a single spot) and don't have one normal
+		bool SmallestEigenvector(const double (&Covariance)[6], FVec3& OutNormal)
+		{
+			const double XX = Covariance[0], XY = Covariance[1], XZ = Covariance[2];
+			const double YY = Covariance[3], YZ = Covariance[4], ZZ = Covariance[5];
+
+			const double Q = (XX + YY + ZZ) / 3.0;
+			const double OffDiagonal = XY * XY + XZ * XZ + YZ * YZ;
+			const double P2 = (XX - Q) * (XX - Q) + (YY - Q) * (YY - Q) + (ZZ - Q) * (ZZ - Q) + 2.0 * OffDiagonal;
+			const double P = std::sqrt(P2 / 6.0);
+			if (P <= 1e-12 * std::max(1.0, std::abs(Q)))
+			{
+				// Isotropic, every direction is as good as any other
+				return false;
+			}
+
+			// B = (A - Q * I) / P has its eigenvalues in [-2, 2] and the characteristic polynomial
+			// Beta^3 - 3 * Beta - det(B). That's increasing and concave left of its smallest root, so Newton from -2
+			// walks up to the root without ever passing it and stops once the steps run out of precision
+			const double BXX = (XX - Q) / P, BYY = (YY - Q) / P, BZZ = (ZZ - Q) / P;
+			const double BXY = XY / P, BXZ = XZ / P, BYZ = YZ / P;
+			const double DetB = BXX * (BYY * BZZ - BYZ * BYZ) - BXY * (BXY * BZZ - BYZ * BXZ) +
+				BXZ * (BXY * BYZ - BYY * BXZ);
+			double Beta = -2.0;
+			for (int32_t Iteration = 0; Iteration < 64; ++Iteration)
+			{
+				const double NextBeta = Beta - (Beta * Beta * Beta - 3.0 * Beta - DetB) / (3.0 * Beta * Beta - 3.0);
+				if (!(NextBeta > Beta))
+				{
+					break;
+				}
+				Beta = NextBeta;
+			}
+			const double SmallestEigenvalue = Q + P * Beta;
+
+			const FVec3 Row0{XX - SmallestEigenvalue, XY, XZ};
+			const FVec3 Row1{XY, YY - SmallestEigenvalue, YZ};
+			const FVec3 Row2{XZ, YZ, ZZ - SmallestEigenvalue};
+			const FVec3 Candidates[3] = {Cross(Row0, Row1), Cross(Row0, Row2), Cross(Row1, Row2)};
+			int32_t Best = 0;
+			for (int32_t i = 1; i < 3; ++i)
+			{
+				if (LengthSquared(Candidates[i]) > LengthSquared(Candidates[Best]))
+				{
+					Best = i;
+				}
+			}
+			const double BestLengthSquared = LengthSquared(Candidates[Best]);
+			if (BestLengthSquared <= 1e-24 * P2 * P2)
+			{
+				// Two smallest eigenvalues match, the points are on a line
+				return false;
+			}
+
+			const double InverseLength = 1.0 / std::sqrt(BestLengthSquared);
+			OutNormal = {
+				Candidates[Best].X * InverseLength, Candidates[Best].Y * InverseLength,
+				Candidates[Best].Z * InverseLength
+			};
+			return true;
+		}
+	}
+
+	FVec3 FitPlaneNormal(const FVec3* Points, const int32_t NumPoints, const double MinCutoff)
+	{
+		const FVec3 Up{0.0, 0.0, 1.0};
+		if (!Points || NumPoints < 3)
+		{
+			return Up;
+		}
+
+		std::vector<double> X(NumPoints), Y(NumPoints), Z(NumPoints), Weights(NumPoints, 1.0);
+		for (int32_t i = 0; i < NumPoints; ++i)
+		{
+			X[i] = Points[i].X - Points[0].X;
+			Y[i] = Points[i].Y - Points[0].Y;
+			Z[i] = Points[i].Z - Points[0].Z;
+		}
+
+		// Seed plane through the triple with the most points near it. A least squares start gets pulled up by rocks
+		// far enough that no reweighting brings it back once a node has a lot of them, a triple on the ground doesn't.
+		// Triples are a third of the points apart, so they span the disk instead of sitting in one spot
+		int32_t BestInlierCount = 0;
+		FVec3 SeedNormal = Up;
+		int32_t SeedIndex = 0;
+		int32_t PreviousFirst = -1;
+		for (int32_t Triple = 0; Triple < NumSeedTriples; ++Triple)
+		{
+			const int32_t First = Triple * NumPoints / (3 * NumSeedTriples);
+			const int32_t Second = First + NumPoints / 3;
+			const int32_t Third = First + 2 * (NumPoints / 3);
+			if (First == PreviousFirst || Third >= NumPoints)
+			{
+				continue;
+			}
+			PreviousFirst = First;
+
+			const FVec3 Normal = Cross({X[Second] - X[First], Y[Second] - Y[First], Z[Second] - Z[First]},
+			                           {X[Third] - X[First], Y[Third] - Y[First], Z[Third] - Z[First]});
+			const double NormalLengthSquared = LengthSquared(Normal);
+			if (NormalLengthSquared <= 1e-12)
+			{
+				continue;
+			}
+			const double InverseLength = 1.0 / std::sqrt(NormalLengthSquared);
+			int32_t InlierCount = 0;
+			for (int32_t i = 0; i < NumPoints; ++i)
+			{
+				const double Offset = ((X[i] - X[First]) * Normal.X + (Y[i] - Y[First]) * Normal.Y +
+					(Z[i] - Z[First]) * Normal.Z) * InverseLength;
+				InlierCount += std::abs(Offset) < SeedInlierBand;
+			}
+			if (InlierCount > BestInlierCount)
+			{
+				BestInlierCount = InlierCount;
+				SeedNormal = {Normal.X * InverseLength, Normal.Y * InverseLength, Normal.Z * InverseLength};
+				SeedIndex = First;
+			}
+		}
+		if (BestInlierCount >= 3)
+		{
+			for (int32_t i = 0; i < NumPoints; ++i)
+			{
+				const double Offset = (X[i] - X[SeedIndex]) * SeedNormal.X + (Y[i] - Y[SeedIndex]) * SeedNormal.Y +
+					(Z[i] - Z[SeedIndex]) * SeedNormal.Z;
+				Weights[i] = std::abs(Offset) < SeedInlierBand ? 1.0 : 0.0;
+			}
+		}
+
+		FPlaneMoments Moments;
+		FVec3 Normal;
+		if (!AccumulateMoments(X, Y, Z, Weights, Moments) || !SmallestEigenvector(Moments.Covariance, Normal))
+		{
+			return Up;
+		}
+
+		// Tukey biweight around the least squares plane of the seed's inliers. The cutoff comes from how far those
+		// inliers are from it, so it's a plain sum instead of a median, and never goes past the band so a rock can't
+		// buy its way back in. MinCutoff only keeps an exact plane from dividing by zero
+		std::vector<double> Offsets(NumPoints);
+		double Cutoff = 0.0;
+		for (int32_t Pass = 0; Pass < NumTukeyPasses; ++Pass)
+		{
+			double SumWeights = 0.0, SumSquares = 0.0;
+			for (int32_t i = 0; i < NumPoints; ++i)
+			{
+				Offsets[i] = (X[i] - Moments.Centroid[0]) * Normal.X + (Y[i] - Moments.Centroid[1]) * Normal.Y +
+					(Z[i] - Moments.Centroid[2]) * Normal.Z;
+				SumWeights += Weights[i];
+				SumSquares += Weights[i] * Offsets[i] * Offsets[i];
+			}
+			if (Pass == 0)
+			{
+				Cutoff = std::clamp(TukeyConstant * std::sqrt(SumSquares / SumWeights), MinCutoff,
+				                    std::max(MinCutoff, SeedInlierBand));
+			}
+			for (int32_t i = 0; i < NumPoints; ++i)
+			{
+				const double Scaled = Offsets[i] / Cutoff;
+				Weights[i] = std::abs(Scaled) < 1.0 ? (1.0 - Scaled * Scaled) * (1.0 - Scaled * Scaled) : 0.0;
+			}
+
+			FVec3 ReweightedNormal;
+			if (!AccumulateMoments(X, Y, Z, Weights, Moments) ||
+				!SmallestEigenvector(Moments.Covariance, ReweightedNormal))
+			{
+				break;
+			}
+			Normal = ReweightedNormal;
+		}
+
+		if (Normal.Z < 0.0)
+		{
+			Normal = {-Normal.X, -Normal.Y, -Normal.Z};
+		}
+		return Normal;
+	}
+
+	double GetPlaneRmsDistance(const FVec3* Points, const int32_t NumPoints, const FVec3& Normal)
+	{
+		if (!Points || NumPoints <= 0)
+		{
+			return 0.0;
+		}
+
+		double CX = 0.0, CY = 0.0, CZ = 0.0;
+		for (int32_t i = 0; i < NumPoints; ++i)
+		{
+			CX += Points[i].X - Points[0].X;
+			CY += Points[i].Y - Points[0].Y;
+			CZ += Points[i].Z - Points[0].Z;
+		}
+		CX /= NumPoints;
+		CY /= NumPoints;
+		CZ /= NumPoints;
+
+		double SumSquares = 0.0;
+		for (int32_t i = 0; i < NumPoints; ++i)
+		{
+			const double Distance = (Points[i].X - Points[0].X - CX) * Normal.X +
+				(Points[i].Y - Points[0].Y - CY) * Normal.Y + (Points[i].Z - Points[0].Z - CZ) * Normal.Z;
+			SumSquares += Distance * Distance;
+		}
+		return std::sqrt(SumSquares / NumPoints);
+	}
+}
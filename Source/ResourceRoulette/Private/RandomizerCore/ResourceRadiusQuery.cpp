@@ -0,0 +1,422 @@
+﻿#include "RandomizerCore/ResourceRadiusQuery.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RR_RADIUS_QUERY_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC lets any function use AVX2 intrinsics, the CPU check decides whether they run
+#define RR_TARGET_AVX2
+#else
+#define RR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define RR_RADIUS_QUERY_X64 0
+#endif
+
+namespace ResourceRouletteCore
+{
+	namespace
+	{
+		// A handful of players in practice, more centers than this go through in chunks
+		constexpr size_t MaxQueriesPerPass = 16;
+
+		struct FRadiusQuery
+		{
+			float CenterX;
+			float CenterY;
+			float CenterZ;
+			float RadiusSquared;
+		};
+
+		bool IsInRadius(const FPackedPositions& Positions, const size_t Index, const FRadiusQuery& Query)
+		{
+			const float DX = Positions.X[Index] - Query.CenterX;
+			const float DY = Positions.Y[Index] - Query.CenterY;
+			const float DZ = Positions.Z[Index] - Query.CenterZ;
+			return DX * DX + DY * DY + DZ * DZ <= Query.RadiusSquared;
+		}
+
+		float DistSquaredTo(const FPackedPositions& Positions, const size_t Index, const FRadiusQuery& Query)
+		{
+			const float DX = Positions.X[Index] - Query.CenterX;
+			const float DY = Positions.Y[Index] - Query.CenterY;
+			const float DZ = Positions.Z[Index] - Query.CenterZ;
+			return DX * DX + DY * DY + DZ * DZ;
+		}
+
+		/// Positions [Start, End) within one mask word, for the scalar kernel and the tails of the SIMD ones
+		uint64_t QueryWordScalar(const FPackedPositions& Positions, const size_t Start, const size_t End,
+		                         const FRadiusQuery& Query)
+		{
+			uint64_t Word = 0;
+			for (size_t i = Start; i < End; ++i)
+			{
+				Word |= static_cast<uint64_t>(IsInRadius(Positions, i, Query)) << (i % 64);
+			}
+			return Word;
+		}
+
+		void QueryRadiusMaskScalar(const FPackedPositions& Positions, const FRadiusQuery& Query, uint64_t* OutMask)
+		{
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				OutMask[Start / 64] = QueryWordScalar(Positions, Start, std::min(Start + 64, Positions.Num), Query);
+			}
+		}
+
+		/// Multi-center version of QueryWordScalar, Queries all share the radius
+		uint64_t QueryNearestWordScalar(const FPackedPositions& Positions, const size_t Start, const size_t End,
+		                                const FRadiusQuery* Queries, const size_t NumQueries,
+		                                float* OutNearestDistSquared)
+		{
+			uint64_t Word = 0;
+			for (size_t i = Start; i < End; ++i)
+			{
+				float Nearest = DistSquaredTo(Positions, i, Queries[0]);
+				for (size_t Q = 1; Q < NumQueries; ++Q)
+				{
+					Nearest = std::min(Nearest, DistSquaredTo(Positions, i, Queries[Q]));
+				}
+				OutNearestDistSquared[i] = Nearest;
+				Word |= static_cast<uint64_t>(Nearest <= Queries[0].RadiusSquared) << (i % 64);
+			}
+			return Word;
+		}
+
+		/// Whether every position in the word [Start, End) has its SkipMask bit set
+		bool IsWordSkipped(const uint64_t* SkipMask, const size_t Start, const size_t End)
+		{
+			if (SkipMask == nullptr)
+			{
+				return false;
+			}
+			const uint64_t UsedBits = End - Start == 64 ? ~uint64_t{0} : (uint64_t{1} << (End - Start)) - 1;
+			return (SkipMask[Start / 64] & UsedBits) == UsedBits;
+		}
+
+		void QueryNearestRadiusMaskScalar(const FPackedPositions& Positions, const FRadiusQuery* Queries,
+		                                  const size_t NumQueries, const uint64_t* SkipMask, uint64_t* OutMask,
+		                                  float* OutNearestDistSquared)
+		{
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				if (IsWordSkipped(SkipMask, Start, std::min(Start + 64, Positions.Num)))
+				{
+					OutMask[Start / 64] = 0;
+					continue;
+				}
+				OutMask[Start / 64] = QueryNearestWordScalar(Positions, Start, std::min(Start + 64, Positions.Num),
+				                                             Queries, NumQueries, OutNearestDistSquared);
+			}
+		}
+
+#if RR_RADIUS_QUERY_X64
+		void QueryRadiusMaskSSE(const FPackedPositions& Positions, const FRadiusQuery& Query, uint64_t* OutMask)
+		{
+			const __m128 CenterX = _mm_set1_ps(Query.CenterX);
+			const __m128 CenterY = _mm_set1_ps(Query.CenterY);
+			const __m128 CenterZ = _mm_set1_ps(Query.CenterZ);
+			const __m128 RadiusSquared = _mm_set1_ps(Query.RadiusSquared);
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				const size_t End = std::min(Start + 64, Positions.Num);
+				const size_t VectorEnd = Start + (End - Start) / 4 * 4;
+				uint64_t Word = 0;
+				for (size_t i = Start; i < VectorEnd; i += 4)
+				{
+					const __m128 DX = _mm_sub_ps(_mm_loadu_ps(Positions.X + i), CenterX);
+					const __m128 DY = _mm_sub_ps(_mm_loadu_ps(Positions.Y + i), CenterY);
+					const __m128 DZ = _mm_sub_ps(_mm_loadu_ps(Positions.Z + i), CenterZ);
+					const __m128 DistSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(DX, DX), _mm_mul_ps(DY, DY)),
+					                                      _mm_mul_ps(DZ, DZ));
+					const uint64_t Bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(DistSquared, RadiusSquared)));
+					Word |= Bits << (i - Start);
+				}
+				OutMask[Start / 64] = Word | QueryWordScalar(Positions, VectorEnd, End, Query);
+			}
+		}
+
+		RR_TARGET_AVX2 void QueryRadiusMaskAVX2(const FPackedPositions& Positions, const FRadiusQuery& Query,
+		                                       uint64_t* OutMask)
+		{
+			const __m256 CenterX = _mm256_set1_ps(Query.CenterX);
+			const __m256 CenterY = _mm256_set1_ps(Query.CenterY);
+			const __m256 CenterZ = _mm256_set1_ps(Query.CenterZ);
+			const __m256 RadiusSquared = _mm256_set1_ps(Query.RadiusSquared);
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				const size_t End = std::min(Start + 64, Positions.Num);
+				const size_t VectorEnd = Start + (End - Start) / 8 * 8;
+				uint64_t Word = 0;
+				for (size_t i = Start; i < VectorEnd; i += 8)
+				{
+					// Same operation order as the scalar and SSE kernels so all three agree bit for bit
+					const __m256 DX = _mm256_sub_ps(_mm256_loadu_ps(Positions.X + i), CenterX);
+					const __m256 DY = _mm256_sub_ps(_mm256_loadu_ps(Positions.Y + i), CenterY);
+					const __m256 DZ = _mm256_sub_ps(_mm256_loadu_ps(Positions.Z + i), CenterZ);
+					const __m256 DistSquared = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(DX, DX), _mm256_mul_ps(DY, DY)), _mm256_mul_ps(DZ, DZ));
+					const uint64_t Bits = static_cast<uint32_t>(
+						_mm256_movemask_ps(_mm256_cmp_ps(DistSquared, RadiusSquared, _CMP_LE_OQ)));
+					Word |= Bits << (i - Start);
+				}
+				OutMask[Start / 64] = Word | QueryWordScalar(Positions, VectorEnd, End, Query);
+			}
+		}
+
+		void QueryNearestRadiusMaskSSE(const FPackedPositions& Positions, const FRadiusQuery* Queries,
+		                               const size_t NumQueries, const uint64_t* SkipMask, uint64_t* OutMask,
+		                               float* OutNearestDistSquared)
+		{
+			__m128 CenterX[MaxQueriesPerPass];
+			__m128 CenterY[MaxQueriesPerPass];
+			__m128 CenterZ[MaxQueriesPerPass];
+			for (size_t Q = 0; Q < NumQueries; ++Q)
+			{
+				CenterX[Q] = _mm_set1_ps(Queries[Q].CenterX);
+				CenterY[Q] = _mm_set1_ps(Queries[Q].CenterY);
+				CenterZ[Q] = _mm_set1_ps(Queries[Q].CenterZ);
+			}
+			const __m128 RadiusSquared = _mm_set1_ps(Queries[0].RadiusSquared);
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				const size_t End = std::min(Start + 64, Positions.Num);
+				if (IsWordSkipped(SkipMask, Start, End))
+				{
+					OutMask[Start / 64] = 0;
+					continue;
+				}
+				const size_t VectorEnd = Start + (End - Start) / 4 * 4;
+				uint64_t Word = 0;
+				for (size_t i = Start; i < VectorEnd; i += 4)
+				{
+					const __m128 X = _mm_loadu_ps(Positions.X + i);
+					const __m128 Y = _mm_loadu_ps(Positions.Y + i);
+					const __m128 Z = _mm_loadu_ps(Positions.Z + i);
+					__m128 Nearest = _mm_set1_ps(std::numeric_limits<float>::infinity());
+					for (size_t Q = 0; Q < NumQueries; ++Q)
+					{
+						const __m128 DX = _mm_sub_ps(X, CenterX[Q]);
+						const __m128 DY = _mm_sub_ps(Y, CenterY[Q]);
+						const __m128 DZ = _mm_sub_ps(Z, CenterZ[Q]);
+						Nearest = _mm_min_ps(Nearest, _mm_add_ps(_mm_add_ps(_mm_mul_ps(DX, DX), _mm_mul_ps(DY, DY)),
+						                                         _mm_mul_ps(DZ, DZ)));
+					}
+					_mm_storeu_ps(OutNearestDistSquared + i, Nearest);
+					const uint64_t Bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(Nearest, RadiusSquared)));
+					Word |= Bits << (i - Start);
+				}
+				OutMask[Start / 64] = Word | QueryNearestWordScalar(Positions, VectorEnd, End, Queries, NumQueries,
+				                                                    OutNearestDistSquared);
+			}
+		}
+
+		RR_TARGET_AVX2 void QueryNearestRadiusMaskAVX2(const FPackedPositions& Positions, const FRadiusQuery* Queries,
+		                                               const size_t NumQueries, const uint64_t* SkipMask,
+		                                               uint64_t* OutMask, float* OutNearestDistSquared)
+		{
+			__m256 CenterX[MaxQueriesPerPass];
+			__m256 CenterY[MaxQueriesPerPass];
+			__m256 CenterZ[MaxQueriesPerPass];
+			for (size_t Q = 0; Q < NumQueries; ++Q)
+			{
+				CenterX[Q] = _mm256_set1_ps(Queries[Q].CenterX);
+				CenterY[Q] = _mm256_set1_ps(Queries[Q].CenterY);
+				CenterZ[Q] = _mm256_set1_ps(Queries[Q].CenterZ);
+			}
+			const __m256 RadiusSquared = _mm256_set1_ps(Queries[0].RadiusSquared);
+			for (size_t Start = 0; Start < Positions.Num; Start += 64)
+			{
+				const size_t End = std::min(Start + 64, Positions.Num);
+				if (IsWordSkipped(SkipMask, Start, End))
+				{
+					OutMask[Start / 64] = 0;
+					continue;
+				}
+				const size_t VectorEnd = Start + (End - Start) / 8 * 8;
+				uint64_t Word = 0;
+				for (size_t i = Start; i < VectorEnd; i += 8)
+				{
+					const __m256 X = _mm256_loadu_ps(Positions.X + i);
+					const __m256 Y = _mm256_loadu_ps(Positions.Y + i);
+					const __m256 Z = _mm256_loadu_ps(Positions.Z + i);
+					__m256 Nearest = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+					for (size_t Q = 0; Q < NumQueries; ++Q)
+					{
+						const __m256 DX = _mm256_sub_ps(X, CenterX[Q]);
+						const __m256 DY = _mm256_sub_ps(Y, CenterY[Q]);
+						const __m256 DZ = _mm256_sub_ps(Z, CenterZ[Q]);
+						Nearest = _mm256_min_ps(Nearest, _mm256_add_ps(
+							                        _mm256_add_ps(_mm256_mul_ps(DX, DX), _mm256_mul_ps(DY, DY)),
+							                        _mm256_mul_ps(DZ, DZ)));
+					}
+					_mm256_storeu_ps(OutNearestDistSquared + i, Nearest);
+					const uint64_t Bits = static_cast<uint32_t>(
+						_mm256_movemask_ps(_mm256_cmp_ps(Nearest, RadiusSquared, _CMP_LE_OQ)));
+					Word |= Bits << (i - Start);
+				}
+				OutMask[Start / 64] = Word | QueryNearestWordScalar(Positions, VectorEnd, End, Queries, NumQueries,
+				                                                    OutNearestDistSquared);
+			}
+		}
+
+		bool DetectAVX2()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			int CpuInfo[4];
+			__cpuid(CpuInfo, 0);
+			if (CpuInfo[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(CpuInfo, 1);
+			// OSXSAVE and AVX, then the OS has to actually save the YMM registers
+			const bool bOsSavesAVX = (CpuInfo[2] & (1 << 27)) && (CpuInfo[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+			__cpuidex(CpuInfo, 7, 0);
+			return bOsSavesAVX && (CpuInfo[1] & (1 << 5));
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif
+
+		ERadiusQueryKernel ResolveKernel(const ERadiusQueryKernel Kernel)
+		{
+			if (Kernel != ERadiusQueryKernel::Best)
+			{
+				return IsRadiusQueryKernelSupported(Kernel) ? Kernel : ERadiusQueryKernel::Scalar;
+			}
+			static const ERadiusQueryKernel BestKernel = IsRadiusQueryKernelSupported(ERadiusQueryKernel::AVX2)
+				                                             ? ERadiusQueryKernel::AVX2
+				                                             : IsRadiusQueryKernelSupported(ERadiusQueryKernel::SSE)
+				                                             ? ERadiusQueryKernel::SSE
+				                                             : ERadiusQueryKernel::Scalar;
+			return BestKernel;
+		}
+	}
+
+	bool IsRadiusQueryKernelSupported(const ERadiusQueryKernel Kernel)
+	{
+		switch (Kernel)
+		{
+		case ERadiusQueryKernel::Best:
+		case ERadiusQueryKernel::Scalar:
+			return true;
+#if RR_RADIUS_QUERY_X64
+		case ERadiusQueryKernel::SSE:
+			// Part of x64
+			return true;
+		case ERadiusQueryKernel::AVX2:
+			{
+				static const bool bHasAVX2 = DetectAVX2();
+				return bHasAVX2;
+			}
+#endif
+		default:
+			return false;
+		}
+	}
+
+	const char* GetRadiusQueryKernelName(const ERadiusQueryKernel Kernel)
+	{
+		switch (ResolveKernel(Kernel))
+		{
+		case ERadiusQueryKernel::SSE: return "SSE";
+		case ERadiusQueryKernel::AVX2: return "AVX2";
+		default: return "Scalar";
+		}
+	}
+
+	void QueryRadiusMask(const FPackedPositions& Positions, const FVec3& Center, const double Radius,
+	                     uint64_t* OutMask, const ERadiusQueryKernel Kernel)
+	{
+		const FRadiusQuery Query{
+			static_cast<float>(Center.X), static_cast<float>(Center.Y), static_cast<float>(Center.Z),
+			static_cast<float>(Radius * Radius)
+		};
+		switch (ResolveKernel(Kernel))
+		{
+#if RR_RADIUS_QUERY_X64
+		case ERadiusQueryKernel::AVX2:
+			QueryRadiusMaskAVX2(Positions, Query, OutMask);
+			break;
+		case ERadiusQueryKernel::SSE:
+			QueryRadiusMaskSSE(Positions, Query, OutMask);
+			break;
+#endif
+		default:
+			QueryRadiusMaskScalar(Positions, Query, OutMask);
+			break;
+		}
+	}
+
+	void QueryNearestRadiusMask(const FPackedPositions& Positions, const FVec3* Centers, const size_t NumCenters,
+	                            const double Radius, uint64_t* OutMask, float* OutNearestDistSquared,
+	                            const uint64_t* SkipMask, const ERadiusQueryKernel Kernel)
+	{
+		if (NumCenters == 0)
+		{
+			std::fill(OutMask, OutMask + (Positions.Num + 63) / 64, uint64_t{0});
+			std::fill(OutNearestDistSquared, OutNearestDistSquared + Positions.Num,
+			          std::numeric_limits<float>::infinity());
+			return;
+		}
+		FRadiusQuery Queries[MaxQueriesPerPass];
+		const size_t NumQueries = std::min(NumCenters, MaxQueriesPerPass);
+		for (size_t Q = 0; Q < NumQueries; ++Q)
+		{
+			Queries[Q] = {
+				static_cast<float>(Centers[Q].X), static_cast<float>(Centers[Q].Y), static_cast<float>(Centers[Q].Z),
+				static_cast<float>(Radius * Radius)
+			};
+		}
+		switch (ResolveKernel(Kernel))
+		{
+#if RR_RADIUS_QUERY_X64
+		case ERadiusQueryKernel::AVX2:
+			QueryNearestRadiusMaskAVX2(Positions, Queries, NumQueries, SkipMask, OutMask, OutNearestDistSquared);
+			break;
+		case ERadiusQueryKernel::SSE:
+			QueryNearestRadiusMaskSSE(Positions, Queries, NumQueries, SkipMask, OutMask, OutNearestDistSquared);
+			break;
+#endif
+		default:
+			QueryNearestRadiusMaskScalar(Positions, Queries, NumQueries, SkipMask, OutMask, OutNearestDistSquared);
+			break;
+		}
+		if (NumCenters > NumQueries)
+		{
+			std::vector<uint64_t> RestMask((Positions.Num + 63) / 64);
+			std::vector<float> RestNearest(Positions.Num);
+			QueryNearestRadiusMask(Positions, Centers + NumQueries, NumCenters - NumQueries, Radius, RestMask.data(),
+			                       RestNearest.data(), SkipMask, Kernel);
+			for (size_t i = 0; i < RestMask.size(); ++i)
+			{
+				OutMask[i] |= RestMask[i];
+			}
+			for (size_t i = 0; i < Positions.Num; ++i)
+			{
+				OutNearestDistSquared[i] = std::min(OutNearestDistSquared[i], RestNearest[i]);
+			}
+		}
+	}
+
+	void QueryRadiusIndexes(const FPackedPositions& Positions, const FVec3& Center, const double Radius,
+	                        std::vector<int32_t>& OutIndexes)
+	{
+		OutIndexes.clear();
+		std::vector<uint64_t> Mask((Positions.Num + 63) / 64);
+		QueryRadiusMask(Positions, Center, Radius, Mask.data());
+		for (size_t WordIndex = 0; WordIndex < Mask.size(); ++WordIndex)
+		{
+			for (uint64_t Word = Mask[WordIndex]; Word != 0; Word &= Word - 1)
+			{
+				OutIndexes.push_back(static_cast<int32_t>(WordIndex * 64 + std::countr_zero(Word)));
+			}
+		}
+	}
+}
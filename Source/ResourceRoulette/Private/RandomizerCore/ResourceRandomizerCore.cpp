@@ -0,0 +1,551 @@
+﻿#include "RandomizerCore/ResourceRandomizerCore.h"
+#include "RandomizerCore/ResourceLocationGrid.h"
+
+namespace ResourceRouletteCore
+{
+	namespace
+	{
+		bool IsValidClass(const FRandomizerOptions& Options, const int32_t ClassIndex)
+		{
+			return ClassIndex >= 0 && ClassIndex < static_cast<int32_t>(Options.Classes.size());
+		}
+
+		/// Splits off nodes we don't randomize. Those keep their spot and are appended as-is later
+		/// @param Nodes Node table
+		/// @param Options Class info
+		/// @param OutNotTouchedNodes Indexes of nodes that stay where they are
+		/// @param OutNodesToProcess Indexes of nodes to randomize
+		void FilterNodes(const std::vector<FNodeEntry>& Nodes, const FRandomizerOptions& Options,
+		                 std::vector<int32_t>& OutNotTouchedNodes, std::vector<int32_t>& OutNodesToProcess)
+		{
+			for (int32_t i = 0; i < static_cast<int32_t>(Nodes.size()); ++i)
+			{
+				const FNodeEntry& Node = Nodes[i];
+				if (!IsValidClass(Options, Node.ClassIndex) || !Options.Classes[Node.ClassIndex].bRandomize)
+				{
+					OutNotTouchedNodes.push_back(i);
+					continue;
+				}
+				if (Node.bExcluded)
+				{
+					continue;
+				}
+				OutNodesToProcess.push_back(i);
+			}
+		}
+
+		/// Sorts primarily by class and secondarily by purity in Pure/Normal/Impure order. Ties fall back
+		/// to table order so the result doesn't depend on the sort implementation
+		void SortNodes(const std::vector<FNodeEntry>& Nodes, std::vector<int32_t>& NodeIndexes)
+		{
+			std::sort(NodeIndexes.begin(), NodeIndexes.end(), [&Nodes](const int32_t A, const int32_t B)
+			{
+				const FNodeEntry& NodeA = Nodes[A];
+				const FNodeEntry& NodeB = Nodes[B];
+				if (NodeA.ClassIndex != NodeB.ClassIndex)
+				{
+					return NodeA.ClassIndex < NodeB.ClassIndex;
+				}
+				if (NodeA.Purity != NodeB.Purity)
+				{
+					return NodeA.Purity > NodeB.Purity;
+				}
+				return A < B;
+			});
+		}
+
+		void PseudorandomizeLocations(std::vector<FVec3>& Locations, const int32_t Seed)
+		{
+			FSeededRandomStream RandomStream(Seed);
+			for (int32_t i = static_cast<int32_t>(Locations.size()) - 1; i > 0; --i)
+			{
+				const int32_t j = RandomStream.RandRange(0, i);
+				std::swap(Locations[i], Locations[j]);
+			}
+		}
+
+		EPurity GetZonePurity(const FRandomizerOptions& Options, const FVec3& Location)
+		{
+			for (const FPurityZone& Zone : Options.PurityZones)
+			{
+				const double DX = Location.X - Zone.CenterX;
+				const double DY = Location.Y - Zone.CenterY;
+				if (DX * DX + DY * DY <= Zone.Radius * Zone.Radius)
+				{
+					return Zone.Purity;
+				}
+			}
+			return EPurity::Max;
+		}
+
+		EPurity AssignPurity(const FPurityBudget& Budget, const FRandomizerOptions& Options, const int32_t ClassIndex,
+		                     const FVec3& NodeLocation)
+		{
+			// Check if the location falls within a purity zone
+			if (Options.bUsePurityExclusion)
+			{
+				const EPurity ZonePurity = GetZonePurity(Options, NodeLocation);
+				if (ZonePurity != EPurity::Max && IsPurityAvailable(Budget, ClassIndex, ZonePurity))
+				{
+					return ZonePurity;
+				}
+			}
+
+			// Fallback to general purity assignment if no zone or unavailable zone purity
+			for (const EPurity Purity : {EPurity::Pure, EPurity::Normal, EPurity::Impure})
+			{
+				if (IsPurityAvailable(Budget, ClassIndex, Purity))
+				{
+					return Purity;
+				}
+			}
+			return EPurity::Max;
+		}
+
+		/// Flood fills outwards from the starting location, grabbing every remaining location within the grouping
+		/// radius of a location already in the group until we hit MaxNodesPerGroup. Neighbours are walked depth
+		/// first in index order, each frame owns a run of the shared neighbour buffer on top of its parent's
+		void GroupLocations(const int32_t StartingIndex, const FResourceLocationGrid& LocationGrid,
+		                    const FRandomizerOptions& Options, std::vector<int32_t>& OutGroupedIndexes)
+		{
+			struct FGroupFrame
+			{
+				size_t Begin;
+				size_t Next;
+			};
+
+			std::vector<int32_t> Neighbours;
+			std::vector<int32_t> QueryScratch;
+			std::vector<FGroupFrame> Stack;
+
+			auto VisitLocation = [&](const int32_t Index)
+			{
+				OutGroupedIndexes.push_back(Index);
+				LocationGrid.QueryRadius(LocationGrid.GetLocation(Index), Options.GroupingRadius, QueryScratch);
+				std::sort(QueryScratch.begin(), QueryScratch.end());
+				Stack.push_back({Neighbours.size(), Neighbours.size()});
+				Neighbours.insert(Neighbours.end(), QueryScratch.begin(), QueryScratch.end());
+			};
+
+			VisitLocation(StartingIndex);
+			while (!Stack.empty() && static_cast<int32_t>(OutGroupedIndexes.size()) < Options.MaxNodesPerGroup)
+			{
+				FGroupFrame& Frame = Stack.back();
+				if (Frame.Next >= Neighbours.size())
+				{
+					Neighbours.resize(Frame.Begin);
+					Stack.pop_back();
+					continue;
+				}
+
+				const int32_t NeighbourIndex = Neighbours[Frame.Next++];
+				// Groups are tiny (MaxNodesPerGroup), so the grouped list doubles as the visited set
+				if (std::find(OutGroupedIndexes.begin(), OutGroupedIndexes.end(), NeighbourIndex) ==
+					OutGroupedIndexes.end())
+				{
+					VisitLocation(NeighbourIndex);
+				}
+			}
+		}
+
+		/// Nodes still waiting for a location. The main loop takes them from the back of the sorted list and
+		/// grouped locations take the first remaining node of their class, so every class gets its own ascending
+		/// bucket of positions and taken nodes are only flagged, nothing is ever erased or shifted
+		class FPendingNodes
+		{
+		public:
+			FPendingNodes(const std::vector<FNodeEntry>& Nodes, const std::vector<int32_t>& InSortedNodes,
+			              const size_t NumClasses)
+				: SortedNodes(InSortedNodes), Taken(InSortedNodes.size(), 0), BucketStarts(NumClasses + 1, 0),
+				  BucketPositions(InSortedNodes.size()), BackPosition(static_cast<int32_t>(InSortedNodes.size())),
+				  NumRemaining(static_cast<int32_t>(InSortedNodes.size()))
+			{
+				for (const int32_t NodeIndex : SortedNodes)
+				{
+					++BucketStarts[Nodes[NodeIndex].ClassIndex + 1];
+				}
+				for (size_t ClassIndex = 0; ClassIndex < NumClasses; ++ClassIndex)
+				{
+					BucketStarts[ClassIndex + 1] += BucketStarts[ClassIndex];
+				}
+				BucketCursors.assign(BucketStarts.begin(), BucketStarts.end() - 1);
+
+				std::vector<int32_t> BucketFill = BucketCursors;
+				for (int32_t Position = 0; Position < static_cast<int32_t>(SortedNodes.size()); ++Position)
+				{
+					BucketPositions[BucketFill[Nodes[SortedNodes[Position]].ClassIndex]++] = Position;
+				}
+			}
+
+			bool IsEmpty() const { return NumRemaining == 0; }
+
+			/// Last node in sorted order that hasn't been taken yet, caller makes sure we're not empty
+			int32_t GetBack()
+			{
+				while (Taken[BackPosition - 1])
+				{
+					--BackPosition;
+				}
+				return SortedNodes[BackPosition - 1];
+			}
+
+			void PopBack()
+			{
+				GetBack();
+				Take(--BackPosition);
+			}
+
+			/// First node of the class in sorted order that hasn't been taken yet
+			/// @return Node index or -1 if the class has none left
+			int32_t GetFirstOfClass(const int32_t ClassIndex)
+			{
+				int32_t& Cursor = BucketCursors[ClassIndex];
+				while (Cursor < BucketStarts[ClassIndex + 1] && Taken[BucketPositions[Cursor]])
+				{
+					++Cursor;
+				}
+				return Cursor < BucketStarts[ClassIndex + 1] ? SortedNodes[BucketPositions[Cursor]] : -1;
+			}
+
+			/// Takes what GetFirstOfClass just returned
+			void PopFirstOfClass(const int32_t ClassIndex)
+			{
+				Take(BucketPositions[BucketCursors[ClassIndex]++]);
+			}
+
+			/// Everything not taken, still in sorted order
+			void GetRemaining(std::vector<int32_t>& OutNodes) const
+			{
+				for (int32_t Position = 0; Position < BackPosition; ++Position)
+				{
+					if (!Taken[Position])
+					{
+						OutNodes.push_back(SortedNodes[Position]);
+					}
+				}
+			}
+
+		private:
+			void Take(const int32_t Position)
+			{
+				Taken[Position] = 1;
+				--NumRemaining;
+			}
+
+			const std::vector<int32_t>& SortedNodes;
+			std::vector<uint8_t> Taken;
+			// Class buckets laid out back to back, BucketStarts[ClassIndex] is where each one begins
+			std::vector<int32_t> BucketStarts;
+			std::vector<int32_t> BucketPositions;
+			std::vector<int32_t> BucketCursors;
+			int32_t BackPosition;
+			int32_t NumRemaining;
+		};
+
+		/// Full Randomization - mostly ignores everything and just splatters nodes down like jackson pollock
+		void ProcessNodesFullRandom(const std::vector<FNodeEntry>& Nodes, const std::vector<int32_t>& NodesToProcess,
+		                            const std::vector<FVec3>& Locations, const FRandomizerOptions& Options,
+		                            FRandomizerResult& Result)
+		{
+			const int32_t NumClasses = static_cast<int32_t>(Options.FullRandomizationClasses.size());
+			if (NumClasses == 0 || Locations.empty())
+			{
+				return;
+			}
+
+			// First node of each class in sorted order is the one we copy from
+			std::vector<int32_t> SourceNodeByClass(Options.Classes.size(), -1);
+			for (const int32_t NodeIndex : NodesToProcess)
+			{
+				int32_t& SourceNode = SourceNodeByClass[Nodes[NodeIndex].ClassIndex];
+				if (SourceNode == -1)
+				{
+					SourceNode = NodeIndex;
+				}
+			}
+
+			FSeededRandomStream RandomStream(Options.Seed);
+			for (const FVec3& Location : Locations)
+			{
+				const int32_t RandomClass = Options.FullRandomizationClasses[RandomStream.RandRange(0, NumClasses - 1)];
+				const int32_t SourceNode = IsValidClass(Options, RandomClass) ? SourceNodeByClass[RandomClass] : -1;
+				if (SourceNode == -1)
+				{
+					++Result.NumMissingSourceNodes;
+					continue;
+				}
+				const EPurity RandomPurity = static_cast<EPurity>(RandomStream.RandRange(
+					0, static_cast<int32_t>(EPurity::Max) - 1));
+				Result.Assignments.push_back({SourceNode, Location, RandomPurity});
+			}
+		}
+
+		/// Processes nodes and randomize their location given an overly complex set of rules
+		/// @param Nodes Node table
+		/// @param NodesToProcess Sorted indexes of the nodes to place, processed from the back
+		/// @param Locations Shuffled candidate locations, processed from the back
+		/// @param Budget Purity budget
+		/// @param Options Settings
+		/// @param Result Result to add placed nodes to
+		void ProcessNodes(const std::vector<FNodeEntry>& Nodes, const std::vector<int32_t>& NodesToProcess,
+		                  std::vector<FVec3> Locations, FPurityBudget& Budget, const FRandomizerOptions& Options,
+		                  FRandomizerResult& Result)
+		{
+			std::vector<int32_t> SingleNodes;
+			std::vector<FVec3> SingleLocations;
+			int32_t SingleNodeCounter = 0;
+
+			FPendingNodes PendingNodes(Nodes, NodesToProcess, Options.Classes.size());
+
+			// Locations are never shifted around, consumed ones are just removed from the grid
+			FResourceLocationGrid LocationGrid(std::move(Locations), Options.GroupingRadius);
+			std::vector<int32_t> GroupedLocationIndexes;
+
+			while (!PendingNodes.IsEmpty() && LocationGrid.Num() > 0)
+			{
+				const int32_t CurrentNodeIndex = PendingNodes.GetBack();
+				const int32_t ClassIndex = Nodes[CurrentNodeIndex].ClassIndex;
+
+				// Non-groupable nodes are all placed on single locations at the end
+				if (!Options.Classes[ClassIndex].bGroupable)
+				{
+					SingleNodes.push_back(CurrentNodeIndex);
+					PendingNodes.PopBack();
+					continue;
+				}
+
+				const int32_t StartingIndex = LocationGrid.GetLastRemainingIndex();
+				GroupedLocationIndexes.clear();
+				GroupLocations(StartingIndex, LocationGrid, Options, GroupedLocationIndexes);
+
+				if (GroupedLocationIndexes.size() == 1)
+				{
+					SingleNodeCounter++;
+					// 25% chance, process it anyways, or 75% chance we do inside the if statement.
+					// It's not "really" random but its repeatable
+					if (SingleNodeCounter % 4 != 0)
+					{
+						SingleLocations.push_back(LocationGrid.GetLocation(StartingIndex));
+						LocationGrid.Remove(StartingIndex);
+						continue;
+					}
+				}
+
+				// Assign the first location to the node, also assign purity stuff
+				const FVec3 StartingLocation = LocationGrid.GetLocation(StartingIndex);
+				EPurity AssignedPurity = AssignPurity(Budget, Options, ClassIndex, StartingLocation);
+				if (AssignedPurity == EPurity::Max)
+				{
+					// Budget for this class ran dry, leave it to the single node pass instead of spinning on it
+					++Result.NumPurityShortfalls;
+					SingleNodes.push_back(CurrentNodeIndex);
+					PendingNodes.PopBack();
+					continue;
+				}
+				DecrementAvailablePurity(Budget, ClassIndex, AssignedPurity);
+				Result.Assignments.push_back({CurrentNodeIndex, StartingLocation, AssignedPurity});
+				LocationGrid.Remove(StartingIndex);
+				PendingNodes.PopBack();
+
+				// Process additional locations in the group, each one takes the first remaining node of the class
+				for (size_t i = 1; i < GroupedLocationIndexes.size(); ++i)
+				{
+					const int32_t LocationIndex = GroupedLocationIndexes[i];
+					const FVec3 GroupedLocation = LocationGrid.GetLocation(LocationIndex);
+					const int32_t MatchingNodeIndex = PendingNodes.GetFirstOfClass(ClassIndex);
+					if (MatchingNodeIndex != -1)
+					{
+						AssignedPurity = AssignPurity(Budget, Options, ClassIndex, GroupedLocation);
+					}
+
+					if (MatchingNodeIndex == -1 || !IsPurityAvailable(Budget, ClassIndex, AssignedPurity))
+					{
+						SingleLocations.push_back(GroupedLocation);
+						LocationGrid.Remove(LocationIndex);
+						continue;
+					}
+
+					Result.Assignments.push_back({MatchingNodeIndex, GroupedLocation, AssignedPurity});
+					DecrementAvailablePurity(Budget, ClassIndex, AssignedPurity);
+					LocationGrid.Remove(LocationIndex);
+					PendingNodes.PopFirstOfClass(ClassIndex);
+				}
+			}
+
+			// Add remaining locations and nodes to the singles
+			LocationGrid.GetRemainingLocations(SingleLocations);
+			PendingNodes.GetRemaining(SingleNodes);
+
+			// Assign remaining single locations to non-groupable nodes
+			const size_t NumSingles = std::min(SingleLocations.size(), SingleNodes.size());
+			for (size_t i = 0; i < NumSingles; ++i)
+			{
+				const int32_t ClassIndex = Nodes[SingleNodes[i]].ClassIndex;
+				const EPurity AssignedPurity = AssignPurity(Budget, Options, ClassIndex, SingleLocations[i]);
+				DecrementAvailablePurity(Budget, ClassIndex, AssignedPurity);
+				Result.Assignments.push_back({SingleNodes[i], SingleLocations[i], AssignedPurity});
+			}
+		}
+
+		/// Parallel mode. Every class gets dealt its own share of the locations first, after that a class only ever
+		/// touches its own nodes, locations, random stream and a private copy of its budget row, so they can all run
+		/// at once. Each class builds its location grid from just its own locations. Results are merged in class
+		/// order, which keeps the layout independent of thread count and scheduling
+		/// @param Nodes Node table
+		/// @param NodesToProcess Sorted indexes of the nodes to place
+		/// @param Locations Shuffled candidate locations
+		/// @param Budget Purity budget, every class's row is written back once its task is done
+		/// @param Options Settings
+		/// @param Result Result to add placed nodes to
+		void ProcessNodesByClass(const std::vector<FNodeEntry>& Nodes, const std::vector<int32_t>& NodesToProcess,
+		                         const std::vector<FVec3>& Locations, FPurityBudget& Budget,
+		                         const FRandomizerOptions& Options, FRandomizerResult& Result)
+		{
+			const int32_t NumClasses = static_cast<int32_t>(Options.Classes.size());
+			std::vector<int32_t> NumNeeded(NumClasses, 0);
+			for (const int32_t NodeIndex : NodesToProcess)
+			{
+				++NumNeeded[Nodes[NodeIndex].ClassIndex];
+			}
+			// NodesToProcess is sorted by class, so every class's nodes are one run of it and stay sorted
+			std::vector<std::vector<int32_t>> ClassNodes(NumClasses);
+			for (int32_t ClassIndex = 0, Begin = 0; ClassIndex < NumClasses; Begin += NumNeeded[ClassIndex++])
+			{
+				ClassNodes[ClassIndex].assign(NodesToProcess.begin() + Begin,
+				                              NodesToProcess.begin() + Begin + NumNeeded[ClassIndex]);
+			}
+
+			// Deal locations out weighted by how many each class still needs, so every class ends up with one
+			// location per node and the classes stay mixed across the map
+			std::vector<std::vector<FVec3>> ClassLocations(NumClasses);
+			int32_t TotalNeeded = 0;
+			for (int32_t ClassIndex = 0; ClassIndex < NumClasses; ++ClassIndex)
+			{
+				ClassLocations[ClassIndex].reserve(NumNeeded[ClassIndex]);
+				TotalNeeded += NumNeeded[ClassIndex];
+			}
+			FCounterRandomStream DealStream(Options.Seed, 0);
+			for (const FVec3& Location : Locations)
+			{
+				if (TotalNeeded == 0)
+				{
+					break;
+				}
+				int32_t Pick = DealStream.RandRange(0, TotalNeeded - 1);
+				int32_t ClassIndex = 0;
+				while (Pick >= NumNeeded[ClassIndex])
+				{
+					Pick -= NumNeeded[ClassIndex++];
+				}
+				ClassLocations[ClassIndex].push_back(Location);
+				--NumNeeded[ClassIndex];
+				--TotalNeeded;
+			}
+
+			// A class can only ever draw from its own row, a budget holding just that row makes sure of it and keeps
+			// the tasks from sharing any memory they write to
+			const int32_t NumBudgetClasses = Budget.GetNumClasses();
+			std::vector<FRandomizerResult> ClassResults(NumClasses);
+			std::vector<FPurityBudget> ClassBudgets(NumClasses);
+			auto ProcessClass = [&](const int32_t ClassIndex)
+			{
+				if (ClassNodes[ClassIndex].empty())
+				{
+					return;
+				}
+				FPurityBudget& ClassBudget = ClassBudgets[ClassIndex];
+				ClassBudget = FPurityBudget(NumBudgetClasses);
+				if (ClassIndex < NumBudgetClasses)
+				{
+					for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+					{
+						ClassBudget.At(ClassIndex, Purity) = Budget.At(ClassIndex, Purity);
+					}
+				}
+
+				std::vector<FVec3>& ClassLocationList = ClassLocations[ClassIndex];
+				FCounterRandomStream ClassStream(Options.Seed, static_cast<uint32_t>(ClassIndex) + 1);
+				for (int32_t i = static_cast<int32_t>(ClassLocationList.size()) - 1; i > 0; --i)
+				{
+					std::swap(ClassLocationList[i], ClassLocationList[ClassStream.RandRange(0, i)]);
+				}
+				ClassResults[ClassIndex].Assignments.reserve(ClassNodes[ClassIndex].size());
+				ProcessNodes(Nodes, ClassNodes[ClassIndex], std::move(ClassLocationList), ClassBudget, Options,
+				             ClassResults[ClassIndex]);
+			};
+			if (Options.ParallelFor)
+			{
+				Options.ParallelFor(NumClasses, ProcessClass);
+			}
+			else
+			{
+				for (int32_t ClassIndex = 0; ClassIndex < NumClasses; ++ClassIndex)
+				{
+					ProcessClass(ClassIndex);
+				}
+			}
+
+			for (int32_t ClassIndex = 0; ClassIndex < NumClasses; ++ClassIndex)
+			{
+				if (!ClassNodes[ClassIndex].empty() && ClassIndex < NumBudgetClasses)
+				{
+					for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+					{
+						Budget.At(ClassIndex, Purity) = ClassBudgets[ClassIndex].At(ClassIndex, Purity);
+					}
+				}
+				const FRandomizerResult& ClassResult = ClassResults[ClassIndex];
+				Result.Assignments.insert(Result.Assignments.end(), ClassResult.Assignments.begin(),
+				                          ClassResult.Assignments.end());
+				Result.NumMissingSourceNodes += ClassResult.NumMissingSourceNodes;
+				Result.NumPurityShortfalls += ClassResult.NumPurityShortfalls;
+			}
+		}
+	}
+
+	FRandomizerResult RandomizeNodes(const std::vector<FNodeEntry>& Nodes, FPurityBudget& Budget,
+	                                 const FRandomizerOptions& Options)
+	{
+		FRandomizerResult Result;
+		Result.Assignments.reserve(Nodes.size());
+
+		// Not touched nodes are the "vanilla" locations that go in first
+		std::vector<int32_t> NotTouchedNodes;
+		std::vector<int32_t> NodesToProcess;
+		FilterNodes(Nodes, Options, NotTouchedNodes, NodesToProcess);
+		SortNodes(Nodes, NodesToProcess);
+
+		std::vector<FVec3> Locations;
+		Locations.reserve(NodesToProcess.size());
+		for (const int32_t NodeIndex : NodesToProcess)
+		{
+			Locations.push_back(Nodes[NodeIndex].Location);
+		}
+		std::stable_sort(Locations.begin(), Locations.end(), [](const FVec3& A, const FVec3& B)
+		{
+			return A.X < B.X;
+		});
+		PseudorandomizeLocations(Locations, Options.Seed);
+
+		for (const int32_t NodeIndex : NotTouchedNodes)
+		{
+			const FNodeEntry& Node = Nodes[NodeIndex];
+			DecrementAvailablePurity(Budget, Node.ClassIndex, Node.Purity);
+			Result.Assignments.push_back({NodeIndex, Node.Location, Node.Purity});
+		}
+
+		if (Options.bUseFullRandomization)
+		{
+			ProcessNodesFullRandom(Nodes, NodesToProcess, Locations, Options, Result);
+		}
+		else if (Options.bParallelByClass)
+		{
+			ProcessNodesByClass(Nodes, NodesToProcess, Locations, Budget, Options, Result);
+		}
+		else
+		{
+			ProcessNodes(Nodes, NodesToProcess, std::move(Locations), Budget, Options, Result);
+		}
+		return Result;
+	}
+}
@@ -18,14 +18,6 @@ UResourceCollectionManager::UResourceCollectionManager()
 	CollectedResourceNodes.Empty();
 }
 
-
-/// /// Sets the array of collected resource nodes externally
-/// @param InCollectedResourceNodes - to save
-void UResourceCollectionManager::SetCollectedResourcesNodes(const TArray<FResourceNodeData>& InCollectedResourceNodes)
-{
-	CollectedResourceNodes = InCollectedResourceNodes;
-}
-
 /// Collects all the resources in the world and their basic information
 /// @param World World Context
 void UResourceCollectionManager::CollectWorldResources(const UWorld* World)
@@ -6,402 +6,197 @@
 #include "ResourceRouletteSubsystem.h"
 #include "SessionSettings/SessionSettingsManager.h"
 #include "ResourceRouletteProfiler.h"
+#include "RandomizerCore/ResourceRandomizerCore.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+/// Changes the layout a seed produces, so only flip it before a reroll or a new game
+static TAutoConsoleVariable<int32> CVarParallelRandomization(
+	TEXT("ResourceRoulette.ParallelRandomization"), 0,
+	TEXT("Randomize every resource class as its own parallel task: 0 = single pass (default layout), 1 = per class"),
+	ECVF_Default
+);
+
+namespace
+{
+	ResourceRouletteCore::FVec3 ToCoreVector(const FVector& Vector)
+	{
+		return {Vector.X, Vector.Y, Vector.Z};
+	}
+
+	/// Builds the class table for the core. Classes are sorted lexically so the core's index sort
+	/// gives the same order the old FName sort did
+	/// @param Nodes Collected nodes
+	/// @param OutClassNames Sorted class names, index is the core class index
+	/// @param OutClassIndexes Reverse lookup of OutClassNames
+	void BuildClassTable(const TArray<FResourceNodeData>& Nodes, TArray<FName>& OutClassNames,
+	                     TMap<FName, int32>& OutClassIndexes)
+	{
+		TSet<FName> UniqueClassNames;
+		for (const FResourceNodeData& Node : Nodes)
+		{
+			UniqueClassNames.Add(Node.ResourceClass);
+		}
+		// Full randomization can pick classes that have no nodes so they need an index too
+		UniqueClassNames.Append(UResourceRouletteUtility::GetFilteredValidResourceClasses());
+
+		OutClassNames = UniqueClassNames.Array();
+		OutClassNames.Sort([](const FName& A, const FName& B) { return A.LexicalLess(B); });
+		for (int32 i = 0; i < OutClassNames.Num(); ++i)
+		{
+			OutClassIndexes.Add(OutClassNames[i], i);
+		}
+	}
+}
 
 UResourceNodeRandomizer::UResourceNodeRandomizer()
 {
-	CollectionManager = nullptr;
 	PurityManager = nullptr;
 	SeedManager = nullptr;
 	GroupingRadius = 4000; //7000 is equivalent to 70m
 }
 
-/// Parent method to randomize World resources
+/// Parent method to randomize World resources. The actual randomization lives in the engine-free
+/// RandomizerCore, this just translates our node data and settings in and out of it. Reads the subsystem's
+/// original nodes and hands it the randomized ones
 /// @param World World context
-/// @param InCollectionManager Collection manager instance 
 /// @param InPurityManager Purity Manager instance
 /// @param InSeedManager Seed manager instance
-void UResourceNodeRandomizer::RandomizeWorldResources(const UWorld* World,
-                                                      UResourceCollectionManager* InCollectionManager,
-                                                      UResourcePurityManager* InPurityManager,
+void UResourceNodeRandomizer::RandomizeWorldResources(const UWorld* World, UResourcePurityManager* InPurityManager,
                                                       AResourceRouletteSeedManager* InSeedManager)
 {
 	RR_PROFILE();
-	CollectionManager = InCollectionManager;
+	using namespace ResourceRouletteCore;
+
 	PurityManager = InPurityManager;
 	SeedManager = InSeedManager;
-	if (!CollectionManager || !PurityManager || !SeedManager)
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
+	if (!ResourceRouletteSubsystem || !PurityManager || !SeedManager)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage("RandomizeWorldResources can't find managers", ELogLevel::Error);
 		return;
 	}
 
-	NotTouchedResourceNodes.Empty();
-	NotProcessedSinglePossibleLocations.Empty();
-	NotProcessedSingleResourceNodes.Empty();
-	ProcessedResourceNodes.Empty();
-
-	// Oops, not init to zero resulting in some variance when re-rolling and init.
-	SingleNodeCounter = 0;
-
 	// Get config options
 	USessionSettingsManager* SessionSettings = GetWorld()->GetSubsystem<USessionSettingsManager>();
-	bool bUsePurityExclusion = SessionSettings->GetBoolOptionValue("ResourceRoulette.RandOpt.UsePurityExclusion");
-	bool bUseFullRandomization = SessionSettings->GetBoolOptionValue("ResourceRoulette.RandOpt.UseFullRandomization");
-	int32 MaxNodesPerGroup = SessionSettings->GetIntOptionValue("ResourceRoulette.GroupOpt.MaxNumPerGroup");
-	const int32 Seed = SeedManager->GetGlobalSeed();
-	TArray<FResourceNodeData> NotProcessedResourceNodes = CollectionManager->GetCollectedResourceNodes();
-
-	// These NotTouchedResourceNodes are the "vanilla" locations that we'll append later
-	NotTouchedResourceNodes = FilterNodes(NotProcessedResourceNodes);
-	SortNodes(NotProcessedResourceNodes);
-
-	TArray<FVector> NotProcessedPossibleLocations;
-	for (const FResourceNodeData& Node : NotProcessedResourceNodes)
-	{
-		if (UResourceRouletteUtility::IsValidFilteredResourceClass(Node.ResourceClass))
-		{
-			NotProcessedPossibleLocations.Add(Node.Location);
-		}
+	const TArray<FResourceNodeData>& CollectedNodes = ResourceRouletteSubsystem->GetOriginalResourceNodes();
+
+	TArray<FName> ClassNames;
+	TMap<FName, int32> ClassIndexes;
+	BuildClassTable(CollectedNodes, ClassNames, ClassIndexes);
+
+	FRandomizerOptions Options;
+	Options.Seed = SeedManager->GetGlobalSeed();
+	Options.GroupingRadius = GroupingRadius;
+	Options.MaxNodesPerGroup = SessionSettings->GetIntOptionValue("ResourceRoulette.GroupOpt.MaxNumPerGroup");
+	Options.bUsePurityExclusion = SessionSettings->GetBoolOptionValue("ResourceRoulette.RandOpt.UsePurityExclusion");
+	Options.bUseFullRandomization = SessionSettings->GetBoolOptionValue(
+		"ResourceRoulette.RandOpt.UseFullRandomization");
+	Options.bParallelByClass = CVarParallelRandomization.GetValueOnGameThread() != 0;
+	Options.ParallelFor = [](const int32 NumTasks, const std::function<void(int32_t)>& Task)
+	{
+		ParallelFor(NumTasks, [&Task](const int32 TaskIndex) { Task(TaskIndex); });
+	};
+
+	const TArray<FName>& NonGroupableResources = UResourceRouletteUtility::GetNonGroupableResources();
+	for (const FName& ClassName : ClassNames)
+	{
+		FResourceClassInfo& ClassInfo = Options.Classes.emplace_back();
+		ClassInfo.bRandomize = UResourceRouletteUtility::IsValidFilteredResourceClass(ClassName);
+		ClassInfo.bGroupable = !NonGroupableResources.Contains(ClassName);
 	}
-
-	NotProcessedPossibleLocations.Sort([](const FVector& A, const FVector& B) { return A.X < B.X; });
-	PseudorandomizeLocations(NotProcessedPossibleLocations, Seed);
-
-	ProcessedResourceNodes.Empty();
-
-	for (int32 i = 0; i < NotTouchedResourceNodes.Num(); ++i)
+	for (const FName& ClassName : UResourceRouletteUtility::GetFilteredValidResourceClasses())
 	{
-		PurityManager->DecrementAvailablePurities(NotTouchedResourceNodes[i].ResourceClass,
-		                                          NotTouchedResourceNodes[i].Purity);
-		ProcessedResourceNodes.Add(NotTouchedResourceNodes[i]);
+		Options.FullRandomizationClasses.push_back(ClassIndexes.FindChecked(ClassName));
 	}
-
-	ProcessNodes(NotProcessedResourceNodes, NotProcessedPossibleLocations, bUsePurityExclusion, bUseFullRandomization, MaxNodesPerGroup);
-
-	if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World))
+	for (const FResourcePurityZone& Zone : PurityManager->GetPurityZones())
 	{
-		ResourceRouletteSubsystem->SetSessionRandomizedResourceNodes(ProcessedResourceNodes);
+		Options.PurityZones.push_back({
+			Zone.Center.X, Zone.Center.Y, Zone.Radius, static_cast<EPurity>(Zone.DesiredPurity.GetValue())
+		});
 	}
-}
 
-/// Processes nodes and randomize their location given an overly complex set of rules
-/// There's probably a way to simplify this and get what I want
-/// @param NotProcessedResourceNodes List of resource node structs to process
-/// @param NotProcessedPossibleLocations and the list of locations
-/// @param bUseFullRandomization
-void UResourceNodeRandomizer::ProcessNodes(TArray<FResourceNodeData>& NotProcessedResourceNodes,
-                                           TArray<FVector>& NotProcessedPossibleLocations, bool
-                                           bUsePurityExclusion, bool bUseFullRandomization, int32 MaxNodesPerGroup)
-{
-	RR_PROFILE();
-	// Get list of resources we shouldn't group
-	static const TArray<FName> NonGroupableResources = UResourceRouletteUtility::GetNonGroupableResources();
-
-	// Full Randomization - mostly ignores everything and just splatters nodes down like jackson pollock
-	if (bUseFullRandomization)
+	if (Options.bUseFullRandomization && Options.FullRandomizationClasses.empty())
 	{
-		TArray<FName> ValidResourceClasses = UResourceRouletteUtility::GetFilteredValidResourceClasses();
-		if (ValidResourceClasses.Num() == 0 || NotProcessedPossibleLocations.Num() == 0)
-		{
-			FResourceRouletteUtilityLog::Get().LogMessage(
-				"No valid resources or locations available for full randomization", ELogLevel::Error);
-			return;
-		}
-		FRandomStream RandomStream(SeedManager->GetGlobalSeed());
-		for (FVector Location : NotProcessedPossibleLocations)
-		{
-			FName RandomResourceClass = ValidResourceClasses[RandomStream.RandRange(0, ValidResourceClasses.Num() - 1)];
-			FResourceNodeData* SourceNode = NotProcessedResourceNodes.FindByPredicate(
-				[RandomResourceClass](const FResourceNodeData& Node)
-				{
-					return Node.ResourceClass == RandomResourceClass;
-				});
-
-			if (!SourceNode)
-			{
-				FResourceRouletteUtilityLog::Get().LogMessage(
-					FString::Printf(
-						TEXT("No source node available for resource class: %s"), *RandomResourceClass.ToString()),
-					ELogLevel::Warning);
-				continue;
-			}
-			FResourceNodeData NewNode = *SourceNode;
-			NewNode.Location = Location;
-			EResourcePurity RandomPurity = static_cast<EResourcePurity>(RandomStream.RandRange(
-				0, static_cast<int32>(EResourcePurity::RP_MAX) - 1));
-			NewNode.Purity = RandomPurity;
-			ProcessedResourceNodes.Add(NewNode);
-		}
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			"No valid resources or locations available for full randomization", ELogLevel::Error);
+	}
 
-		return;
+	// Node table
+	std::vector<FNodeEntry> NodeTable;
+	NodeTable.reserve(CollectedNodes.Num());
+	for (const FResourceNodeData& Node : CollectedNodes)
+	{
+		FNodeEntry& Entry = NodeTable.emplace_back();
+		Entry.Location = ToCoreVector(Node.Location);
+		Entry.ClassIndex = ClassIndexes.FindChecked(Node.ResourceClass);
+		Entry.Purity = static_cast<EPurity>(Node.Purity.GetValue());
+		// Liquid oilfracking satellites have the right class but wrong resource type
+		Entry.bExcluded = Node.ResourceClass == FName("Desc_LiquidOil_C") && (Node.ResourceNodeType ==
+			EResourceNodeType::FrackingSatellite || Node.ResourceNodeType == EResourceNodeType::FrackingCore);
 	}
 
-	while (NotProcessedResourceNodes.Num() > 0 && NotProcessedPossibleLocations.Num() > 0)
+	// Purity budget, the purity manager interned its classes in scan order so map them onto ours once per class
+	const FPurityBudget& RemainingPurities = PurityManager->GetRemainingPurities();
+	TArray<int32> PurityClassIndexes;
+	PurityClassIndexes.Reserve(ClassNames.Num());
+	FPurityBudget Budget(ClassNames.Num());
+	for (int32 ClassIndex = 0; ClassIndex < ClassNames.Num(); ++ClassIndex)
 	{
-		if (NotProcessedResourceNodes.Num() == 0 || NotProcessedPossibleLocations.Num() == 0)
-		{
-			break;
-		}
-		FResourceNodeData CurrentNodeToProcess = NotProcessedResourceNodes.Last();
-
-		// If it shouldn't be grouped, then:
-		if (NonGroupableResources.Contains(CurrentNodeToProcess.ResourceClass))
-		{
-			// Remove this node from the list to group and add it to single nodes
-			NotProcessedSingleResourceNodes.Add(CurrentNodeToProcess);
-			NotProcessedResourceNodes.Pop();
-			continue;
-		}
-
-		FVector StartingLocation = NotProcessedPossibleLocations.Last();
-
-		// recursively find all the node locations next to this location
-		TArray<FVector> GroupedLocations;
-		TArray<int32> GroupedLocationIndexes;
-		TSet<int32> VisitedIndexes;
-		GroupedLocations.Empty();
-		GroupedLocationIndexes.Empty();
-		VisitedIndexes.Empty();
-
-		GroupLocations(StartingLocation, NotProcessedPossibleLocations, GroupedLocations, GroupedLocationIndexes,
-		               VisitedIndexes, MaxNodesPerGroup);
-
-		if (GroupedLocations.Num() == 1)
+		const int32 PurityClassIndex = PurityManager->GetResourceClassIndex(ClassNames[ClassIndex]);
+		PurityClassIndexes.Add(PurityClassIndex);
+		if (PurityClassIndex != INDEX_NONE)
 		{
-			SingleNodeCounter++;
-			// 25% chance, process it anyways, or 75% chance we do inside the if statement.
-			// It's not "really" random but its repeatable
-			if (SingleNodeCounter % 4 != 0)
+			for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
 			{
-				NotProcessedSinglePossibleLocations.Add(GroupedLocations[0]);
-				NotProcessedPossibleLocations.Pop(); // we processed the last location so this should work
-				continue;
+				Budget.At(ClassIndex, Purity) = RemainingPurities.At(PurityClassIndex, Purity);
 			}
 		}
-
-		// Assign the first location to the node and add it to ProcessedResourceNodes, also assign purity stuff
-		EResourcePurity AssignedPurity = AssignPurity(CurrentNodeToProcess.ResourceClass, GroupedLocations[0],
-		                                              bUsePurityExclusion);
-		if (AssignedPurity == EResourcePurity::RP_MAX)
-		{
-			// If no purity is available, skip this node ... something is wrong
-			FResourceRouletteUtilityLog::Get().LogMessage(	
-				FString::Printf(
-					TEXT("No purity is available for node at location: %s"), *CurrentNodeToProcess.Location.ToString()),
-				ELogLevel::Warning);
-			continue;
-		}
-		CurrentNodeToProcess.Purity = AssignedPurity;
-		PurityManager->DecrementAvailablePurities(CurrentNodeToProcess.ResourceClass, AssignedPurity);
-		CurrentNodeToProcess.Location = GroupedLocations[0];
-		ProcessedResourceNodes.Add(CurrentNodeToProcess);
-		NotProcessedPossibleLocations.Pop();
-		NotProcessedResourceNodes.Pop();
-
-		// Process additional locations in the group
-		for (int32 i = 1; i < GroupedLocations.Num(); ++i)
-		{
-			int32 MatchingNodeIndex = INDEX_NONE;
-			for (int32 NodeIndex = 0; NodeIndex < NotProcessedResourceNodes.Num(); ++NodeIndex)
-			{
-				const FResourceNodeData& Node = NotProcessedResourceNodes[NodeIndex];
-				if (Node.ResourceClass == CurrentNodeToProcess.ResourceClass)
-				{
-					// 		bool bPurityCheckPassed = 
-					// (CurrentNodeToProcess.Purity == EResourcePurity::RP_Pure && Node.Purity != EResourcePurity::RP_Inpure) ||
-					// (CurrentNodeToProcess.Purity == EResourcePurity::RP_Inpure && Node.Purity != EResourcePurity::RP_Pure) ||
-					// (CurrentNodeToProcess.Purity == EResourcePurity::RP_Normal && Node.Purity == EResourcePurity::RP_Inpure) ||
-					// (CurrentNodeToProcess.Purity == Node.Purity);
-					AssignedPurity = AssignPurity(CurrentNodeToProcess.ResourceClass, GroupedLocations[i],
-					                              bUsePurityExclusion);
-					bool bPurityCheckPassed = PurityManager->IsPurityAvailable(
-						CurrentNodeToProcess.ResourceClass, AssignedPurity);
-
-					if (bPurityCheckPassed)
-					{
-						MatchingNodeIndex = NodeIndex;
-						break;
-					}
-				}
-			}
-
-			if (MatchingNodeIndex == INDEX_NONE)
-			{
-				NotProcessedSinglePossibleLocations.Add(GroupedLocations[i]);
-
-				int32 LocationIndex = GroupedLocationIndexes[i];
-
-				// Same gross TODO: stuff here as below, but ... it will work for now
-				for (int32& Index : GroupedLocationIndexes)
-				{
-					if (Index > LocationIndex && Index < NotProcessedPossibleLocations.Num())
-					{
-						--Index;
-					}
-				}
-
-
-				NotProcessedPossibleLocations.RemoveAt(LocationIndex);
-				continue;
-			}
-
-			FResourceNodeData& MatchingNode = NotProcessedResourceNodes[MatchingNodeIndex];
-			MatchingNode.Purity = AssignedPurity;
-			MatchingNode.Location = GroupedLocations[i];
-			ProcessedResourceNodes.Add(MatchingNode);
-			PurityManager->DecrementAvailablePurities(MatchingNode.ResourceClass, AssignedPurity);
-
-			int32 LocationIndex = GroupedLocationIndexes[i];
-
-			// To resolve an issue from removing this NotProcessedPossibleLocation, the disgusting way to fix it
-			// is to do this ... maybe it's better just to search and remove the location rather than this nonsense
-			// but that's another TODO: item
-			for (int32& Index : GroupedLocationIndexes)
-			{
-				if (Index > LocationIndex && Index < NotProcessedPossibleLocations.Num())
-				{
-					--Index;
-				}
-			}
-
-			NotProcessedPossibleLocations.RemoveAt(LocationIndex);
-			NotProcessedResourceNodes.RemoveAt(MatchingNodeIndex);
-
-
-		}
 	}
 
-	// Add remaining locations to NotProcessedSinglePossibleLocations
-	NotProcessedSinglePossibleLocations.Append(NotProcessedPossibleLocations);
-	NotProcessedSingleResourceNodes.Append(NotProcessedResourceNodes);
+	const FRandomizerResult Result = RandomizeNodes(NodeTable, Budget, Options);
 
-	// Assign remaining single locations to non-groupable nodes
-	for (int32 i = 0; i < NotProcessedSinglePossibleLocations.Num() && i < NotProcessedSingleResourceNodes.Num(); ++i)
+	// Built here and moved into the subsystem, which keeps the only copy
+	TArray<FResourceNodeData> ProcessedNodes;
+	ProcessedNodes.Reserve(Result.Assignments.size());
+	for (const FNodeAssignment& Assignment : Result.Assignments)
 	{
-		NotProcessedSingleResourceNodes[i].Location = NotProcessedSinglePossibleLocations[i];
-		NotProcessedSingleResourceNodes[i].Purity = AssignPurity(NotProcessedSingleResourceNodes[i].ResourceClass,
-		                                                         NotProcessedSingleResourceNodes[i].Location,
-		                                                         bUsePurityExclusion);
-		PurityManager->DecrementAvailablePurities(NotProcessedSingleResourceNodes[i].ResourceClass,
-		                                          NotProcessedSingleResourceNodes[i].Purity);
-		ProcessedResourceNodes.Add(NotProcessedSingleResourceNodes[i]);
+		FResourceNodeData& Node = ProcessedNodes.Add_GetRef(CollectedNodes[Assignment.SourceNode]);
+		Node.Location = FVector(Assignment.Location.X, Assignment.Location.Y, Assignment.Location.Z);
+		Node.Purity = static_cast<EResourcePurity>(Assignment.Purity);
+		// New spot, so it needs settling again
+		Node.IsRayCasted = false;
+		Node.NumSettleTraces = 0;
 	}
-}
 
-EResourcePurity UResourceNodeRandomizer::AssignPurity(const FName ResourceClass, const FVector& NodeLocation,
-                                                      bool bUsePurityExclusion) const
-{
-	// Check if the location falls within a purity zone
-	if (bUsePurityExclusion)
+	// Hand the budget back so the purity manager reflects what's left
+	FPurityBudget NewRemainingPurities = RemainingPurities;
+	for (int32 ClassIndex = 0; ClassIndex < ClassNames.Num(); ++ClassIndex)
 	{
-		EResourcePurity ZonePurity = PurityManager->GetZonePurity(NodeLocation);
-		if (ZonePurity != EResourcePurity::RP_MAX && PurityManager->IsPurityAvailable(ResourceClass, ZonePurity))
+		if (PurityClassIndexes[ClassIndex] != INDEX_NONE)
 		{
-			return ZonePurity;
+			for (const EPurity Purity : {EPurity::Impure, EPurity::Normal, EPurity::Pure})
+			{
+				NewRemainingPurities.At(PurityClassIndexes[ClassIndex], Purity) = Budget.At(ClassIndex, Purity);
+			}
 		}
 	}
+	PurityManager->SetRemainingPurities(NewRemainingPurities);
 
-	// Fallback to general purity assignment if no zone or unavailable zone purity
-	if (PurityManager->IsPurityAvailable(ResourceClass, EResourcePurity::RP_Pure))
+	if (Result.NumMissingSourceNodes > 0)
 	{
-		return EResourcePurity::RP_Pure;
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("No source node available for %d randomly picked locations"),
+			                Result.NumMissingSourceNodes), ELogLevel::Warning);
 	}
-	if (PurityManager->IsPurityAvailable(ResourceClass, EResourcePurity::RP_Normal))
+	if (Result.NumPurityShortfalls > 0)
 	{
-		return EResourcePurity::RP_Normal;
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("No purity was available for %d grouped nodes"), Result.NumPurityShortfalls),
+			ELogLevel::Warning);
 	}
-	if (PurityManager->IsPurityAvailable(ResourceClass, EResourcePurity::RP_Inpure))
-	{
-		return EResourcePurity::RP_Inpure;
-	}
-	return EResourcePurity::RP_MAX;
-}
-
 
-void UResourceNodeRandomizer::GroupLocations(const FVector& StartingLocation, const TArray<FVector>& Locations,
-                                             TArray<FVector>& OutGroupedLocations, TArray<int32>& OutGroupedIndexes,
-                                             TSet<int32>& VisitedIndexes, int32 MaxNodesPerGroup)
-{
-	int32 StartingIndex = Locations.IndexOfByKey(StartingLocation);
-
-	if (StartingIndex == INDEX_NONE || VisitedIndexes.Contains(StartingIndex))
-	{
-		return;
-	}
-
-	OutGroupedLocations.Add(StartingLocation);
-
-	VisitedIndexes.Add(StartingIndex);
-	OutGroupedIndexes.Add(StartingIndex);
-
-	for (int32 i = 0; i < Locations.Num(); ++i)
-	{
-		if (OutGroupedLocations.Num() >= MaxNodesPerGroup)
-		{
-			break;
-		}
-
-		FVector Location = Locations[i];
-		if (FVector::Dist(StartingLocation, Location) <= GroupingRadius && !VisitedIndexes.Contains(i))
-		{
-			GroupLocations(Location, Locations, OutGroupedLocations, OutGroupedIndexes, VisitedIndexes, MaxNodesPerGroup);
-		}
-	}
-}
-
-//TODO: Filters out nodes, since we no longer do it in the collection step
-TArray<FResourceNodeData> UResourceNodeRandomizer::FilterNodes(TArray<FResourceNodeData>& Nodes)
-{
-	TArray<FResourceNodeData> NonRandomizedNodes;
-
-	Nodes.RemoveAll([&NonRandomizedNodes](const FResourceNodeData& Node)
-	{
-		// Remove all non-valid classes
-		if (!UResourceRouletteUtility::IsValidFilteredResourceClass(Node.ResourceClass))
-		{
-			NonRandomizedNodes.Add(Node);
-			return true;
-		}
-
-		// Remove liquid oilfracking satellites, as they have the right class but wrong resource type
-		if (Node.ResourceClass == FName("Desc_LiquidOil_C") && (Node.ResourceNodeType ==
-			EResourceNodeType::FrackingSatellite || Node.ResourceNodeType == EResourceNodeType::FrackingCore))
-		{
-			return true;
-		}
-		return false;
-	});
-	return NonRandomizedNodes;
-}
-
-
-/// Sorts primarily by ResourceClass and secondarily by Purity, in Pure/Normal/Impure order
-/// @param Nodes Nodes to Sort
-void UResourceNodeRandomizer::SortNodes(TArray<FResourceNodeData>& Nodes)
-{
-	Nodes.Sort([](const FResourceNodeData& A, const FResourceNodeData& B)
-	{
-		if (A.ResourceClass != B.ResourceClass)
-		{
-			return A.ResourceClass.LexicalLess(B.ResourceClass);
-		}
-		return A.Purity > B.Purity;
-	});
-}
-
-void UResourceNodeRandomizer::PseudorandomizeLocations(TArray<FVector>& Locations, const int32 Seed)
-{
-	const FRandomStream RandomStream(Seed);
-	for (int32 i = Locations.Num() - 1; i > 0; --i)
-	{
-		const int32 j = RandomStream.RandRange(0, i);
-		Locations.Swap(i, j);
-	}
-}
-
-const TArray<FResourceNodeData>& UResourceNodeRandomizer::GetProcessedNodes() const
-{
-	return ProcessedResourceNodes;
+	ResourceRouletteSubsystem->SetSessionRandomizedResourceNodes(MoveTemp(ProcessedNodes));
 }
 
 float UResourceNodeRandomizer::GetGroupingRadius() const
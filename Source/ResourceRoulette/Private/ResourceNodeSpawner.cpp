@@ -1,12 +1,12 @@
 ﻿#include "ResourceNodeSpawner.h"
 
 #include "FGActorRepresentationManager.h"
-#include "ResourceNodeRandomizer.h"
 #include "Engine/World.h"
 #include "GameFramework/Actor.h"
 #include "Components/BoxComponent.h"
 #include "Engine/StaticMeshActor.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Resources/FGResourceNode.h"
 #include "Representation/FGResourceNodeRepresentation.h"
 #include "Engine/StaticMesh.h"
@@ -17,55 +17,170 @@
 #include "Components/DecalComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "ResourceRouletteProfiler.h"
+#include "Engine/AssetManager.h"
+#include "TimerManager.h"
+
+/// How many nodes get spawned per frame
+static TAutoConsoleVariable<int32> CVarSpawnBatchSize(
+	TEXT("ResourceRoulette.SpawnBatchSize"), 64,
+	TEXT("Resource nodes spawned per frame. 0 = spawn everything in one go"),
+	ECVF_Default
+);
+
+/// Takes effect on the next spawn, e.g. after a reroll or reload
+static TAutoConsoleVariable<int32> CVarInstancedNodeMeshes(
+	TEXT("ResourceRoulette.InstancedNodeMeshes"), 0,
+	TEXT("Render solid node rocks through one instanced mesh per resource class instead of a mesh per node. Always on "
+		"while ResourceRoulette.NodeActivationRadius is above 0"),
+	ECVF_Default
+);
+
+namespace
+{
+	/// Grabs an asset if the preload (or anything else) already has it in memory, otherwise loads it right now
+	/// @param Path Object path of the asset
+	/// @param NumSyncLoads Bumped when we had to block on a load
+	template <typename T>
+	T* ResolveAsset(const FString& Path, int32& NumSyncLoads)
+	{
+		const FSoftObjectPath SoftObjectPath(Path);
+		if (UObject* LoadedObject = SoftObjectPath.ResolveObject())
+		{
+			return Cast<T>(LoadedObject);
+		}
+		NumSyncLoads++;
+		return Cast<T>(SoftObjectPath.TryLoad());
+	}
 
-struct FResourceNodeCache;
+	// On the box and hidden collision mesh SetNodeCollision unregisters on a proxy
+	const FName NodeCollisionTag = "ResourceRouletteCollision";
+}
 
 UResourceNodeSpawner::UResourceNodeSpawner()
 {
-	NodeRandomizer = nullptr;
+	ResourceAssets = nullptr;
 	// SpawnedResourceNodes.Empty();
 }
 
-/// Parent method to Spawn world resources
+/// Parent method to Spawn world resources. Waits for the asset preload, then spawns the nodes in batches
+/// across frames and fires OnComplete once the last one is down. With a batch size of 0 everything is
+/// spawned right away and OnComplete fires before this returns
 /// TODO: Currently only spawns solid resources, will add additional resources soon(TM)
 /// @param World World Context
-/// @param InNodeRandomizer The node randomizer instance so we can grab nodes from it
-/// @param IsFromSaved If we have already randomized nodes, we should load from save instead
-void UResourceNodeSpawner::SpawnWorldResources(UWorld* World, UResourceNodeRandomizer* InNodeRandomizer,
-                                               const bool IsFromSaved)
+/// @param OnComplete Called once every node has been spawned
+void UResourceNodeSpawner::SpawnWorldResources(UWorld* World, const FOnResourceSpawningComplete& OnComplete)
 {
 	RR_PROFILE();
-	NodeRandomizer = InNodeRandomizer;
 	if (!World)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage("SpawnWorldResources aborted: World is invalid.",
 		                                              ELogLevel::Error);
 		return;
 	}
-	if (!NodeRandomizer)
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
+	if (!ResourceRouletteSubsystem)
 	{
-		FResourceRouletteUtilityLog::Get().LogMessage("Failed to find UResourceNodeRandomizer instance.",
+		FResourceRouletteUtilityLog::Get().LogMessage("Failed to find AResourceRouletteSubsystem instance.",
 		                                              ELogLevel::Error);
 		return;
 	}
-	ProcessedNodes.Empty();
-	if (IsFromSaved)
+	CancelSpawning();
+
+	// Whether they came from the randomizer or a save, the nodes are in the subsystem by now
+	NodeStore = ResourceRouletteSubsystem;
+	// Any nodes the old instances belonged to are gone by now
+	ClearNodeMeshInstances();
+	UpdateHeadlessMode(World);
+
+	if (!ResourceAssets)
 	{
-		AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
-		ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+		ResourceAssets = NewObject<UResourceRouletteAssets>(this);
 	}
-	else
+	CacheHits = 0;
+	CacheMisses = 0;
+	NumSyncLoads = 0;
+	AssetLoadSeconds = 0.0;
+	NumDecalsSkipped = 0;
+	NextNodeToSpawn = 0;
+	NumSpawnFrames = 0;
+	SpawnStartTime = FPlatformTime::Seconds();
+	SpawnWorld = World;
+	OnSpawningComplete = OnComplete;
+	bIsSpawning = true;
+
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Number of nodes to spawn: %d"),
+		                ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes().Num()), ELogLevel::Debug);
+
+	if (CVarSpawnBatchSize.GetValueOnGameThread() <= 0)
 	{
-		ProcessedNodes = NodeRandomizer->GetProcessedNodes();
+		SpawnNextBatch();
+		return;
 	}
 
-	const UResourceRouletteAssets* ResourceAssets = NewObject<UResourceRouletteAssets>();
+	// Don't start until the meshes and materials are in, otherwise the first batch would load them all anyway
+	PreloadResourceAssets(World);
+	if (!PreloadHandle.IsValid() || !PreloadHandle->BindCompleteDelegate(
+		FStreamableDelegate::CreateUObject(this, &UResourceNodeSpawner::ScheduleNextBatch)))
+	{
+		ScheduleNextBatch();
+	}
+}
 
+/// Drops any spawning still in flight. Nodes spawned so far stay in the world
+void UResourceNodeSpawner::CancelSpawning()
+{
+	if (!bIsSpawning)
+	{
+		return;
+	}
+	if (UWorld* World = SpawnWorld.Get())
+	{
+		World->GetTimerManager().ClearTimer(SpawnBatchTimerHandle);
+	}
+	bIsSpawning = false;
+	OnSpawningComplete.Unbind();
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = NodeStore.Get();
 	FResourceRouletteUtilityLog::Get().LogMessage(
-		FString::Printf(TEXT("Number of nodes to spawn: %d"), ProcessedNodes.Num()), ELogLevel::Debug);
+		FString::Printf(TEXT("Spawning cancelled after %d of %d nodes"), NextNodeToSpawn,
+		                ResourceRouletteSubsystem ? ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes().Num() : 0),
+		ELogLevel::Debug);
+}
+
+void UResourceNodeSpawner::ScheduleNextBatch()
+{
+	UWorld* World = SpawnWorld.Get();
+	if (!bIsSpawning || !World)
+	{
+		return;
+	}
+	SpawnBatchTimerHandle = World->GetTimerManager().SetTimerForNextTick(
+		FTimerDelegate::CreateUObject(this, &UResourceNodeSpawner::SpawnNextBatch));
+}
 
-	for (FResourceNodeData& NodeData : ProcessedNodes)
+/// Spawns the next ResourceRoulette.SpawnBatchSize nodes, then either schedules the next batch or wraps up
+void UResourceNodeSpawner::SpawnNextBatch()
+{
+	RR_PROFILE();
+	UWorld* World = SpawnWorld.Get();
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = NodeStore.Get();
+	if (!bIsSpawning || !World || !ResourceRouletteSubsystem)
 	{
+		bIsSpawning = false;
+		return;
+	}
+
+	// Looked up every batch rather than held on to, in case the array got replaced between frames
+	TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+	const int32 BatchSize = CVarSpawnBatchSize.GetValueOnGameThread();
+	const int32 EndNode = BatchSize > 0
+		                      ? FMath::Min(NextNodeToSpawn + BatchSize, ProcessedNodes.Num())
+		                      : ProcessedNodes.Num();
+	NumSpawnFrames++;
+
+	for (; NextNodeToSpawn < EndNode; ++NextNodeToSpawn)
+	{
+		FResourceNodeData& NodeData = ProcessedNodes[NextNodeToSpawn];
 		bool bSpawned = false;
 
 		if (NodeData.ResourceForm == EResourceForm::RF_LIQUID)
@@ -85,13 +200,446 @@ void UResourceNodeSpawner::SpawnWorldResources(UWorld* World, UResourceNodeRando
 				ELogLevel::Warning);
 		}
 	}
-	if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World))
+
+	if (NextNodeToSpawn < ProcessedNodes.Num())
+	{
+		ScheduleNextBatch();
+		return;
+	}
+
+	bIsSpawning = false;
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Spawned %d nodes over %d frames in %.1f ms"), ProcessedNodes.Num(), NumSpawnFrames,
+		                (FPlatformTime::Seconds() - SpawnStartTime) * 1000.0), ELogLevel::Debug);
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Spawn asset cache: %d hits, %d misses, %d assets loaded synchronously"), CacheHits,
+		                CacheMisses, NumSyncLoads), ELogLevel::Debug);
+	LogAssetStats();
+
+	// Nodes were spawned in place, nothing to hand back
+	ResourceRouletteSubsystem->SetSessionAlreadySpawned(true);
+
+	// Copy first, the callback is allowed to kick off another spawn
+	const FOnResourceSpawningComplete CompletedCallback = OnSpawningComplete;
+	OnSpawningComplete.Unbind();
+	CompletedCallback.ExecuteIfBound();
+}
+
+/// Starts streaming in the meshes and materials of every resource class we might spawn, so by the time
+/// spawning starts they're already in memory. Spawning still works if this hasn't finished, it just
+/// loads whatever is missing synchronously. Headless servers only get the meshes, for their collision
+/// @param World World the nodes are going into
+void UResourceNodeSpawner::PreloadResourceAssets(const UWorld* World)
+{
+	RR_PROFILE();
+	if (PreloadHandle.IsValid() && PreloadHandle->IsLoadingInProgress())
+	{
+		return;
+	}
+	UpdateHeadlessMode(World);
+
+	TArray<FSoftObjectPath> AssetPaths;
+	for (const FName& ResourceClassName : UResourceRouletteUtility::GetFilteredValidResourceClasses())
+	{
+		if (const FResourceRouletteAssetSolid* SolidAssets = UResourceRouletteAssets::SolidResourceInfoMap.Find(
+			ResourceClassName))
+		{
+			AssetPaths.AddUnique(FSoftObjectPath(SolidAssets->MeshPath));
+			for (const FString& MaterialPath : SolidAssets->MaterialPaths)
+			{
+				if (!bHeadless)
+				{
+					AssetPaths.AddUnique(FSoftObjectPath(MaterialPath));
+				}
+			}
+		}
+		if (const FResourceRouletteAssetLiquid* LiquidAssets = UResourceRouletteAssets::LiquidResourceInfoMap.Find(
+			ResourceClassName); !bHeadless && LiquidAssets && LiquidAssets->MaterialPaths.Num() > 0)
+		{
+			AssetPaths.AddUnique(FSoftObjectPath(LiquidAssets->MaterialPaths[0]));
+		}
+	}
+	if (AssetPaths.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 NumAssets = AssetPaths.Num();
+	PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		MoveTemp(AssetPaths), FStreamableDelegate::CreateLambda([NumAssets]()
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Preloaded %d resource node assets."), NumAssets), ELogLevel::Debug);
+		}));
+}
+
+/// Works out whether this spawn is headless. Cache entries built for the other mode get dropped, they're either
+/// missing the materials or hold ones nobody needs
+/// @param World World the nodes are going into
+void UResourceNodeSpawner::UpdateHeadlessMode(const UWorld* World)
+{
+	const bool bNewHeadless = UResourceRouletteUtility::IsHeadlessServer(World);
+	if (bNewHeadless == bHeadless)
+	{
+		return;
+	}
+	bHeadless = bNewHeadless;
+	ResourceNodeCache.Empty();
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		bHeadless
+			? TEXT("Headless server, spawning nodes without materials or decals.")
+			: TEXT("Spawning nodes with materials and decals."), ELogLevel::Debug);
+}
+
+/// Logs what the cached node assets hold and how long they took to load, so a headless server can be compared
+/// with a client
+void UResourceNodeSpawner::LogAssetStats() const
+{
+	TSet<const UObject*> Assets;
+	int32 NumAssetsSkipped = 0;
+	for (const TPair<FName, FResourceNodeCache>& CacheEntry : ResourceNodeCache)
+	{
+		Assets.Add(CacheEntry.Value.Mesh);
+		Assets.Append(CacheEntry.Value.Materials);
+		Assets.Add(CacheEntry.Value.DecalMaterial);
+		NumAssetsSkipped += CacheEntry.Value.NumAssetsSkipped;
+	}
+	Assets.Remove(nullptr);
+
+	SIZE_T AssetBytes = 0;
+	for (const UObject* Asset : Assets)
+	{
+		AssetBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Node assets: %d loaded, %.1f KB, %.1f ms spent loading this spawn"), Assets.Num(),
+		                AssetBytes / 1024.0, AssetLoadSeconds * 1000.0), ELogLevel::Debug);
+	if (bHeadless)
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("Headless server: %d materials not loaded, %d decal components not created"),
+			                NumAssetsSkipped, NumDecalsSkipped), ELogLevel::Debug);
+	}
+}
+
+/// Finds or builds the cached assets for a resource class
+/// @param ResourceClassName Resource class the node is
+/// @return Cache entry, check the loaded flags before using it
+const FResourceNodeCache& UResourceNodeSpawner::GetResourceNodeCache(const FName& ResourceClassName)
+{
+	if (const FResourceNodeCache* CachedAssets = ResourceNodeCache.Find(ResourceClassName))
+	{
+		CacheHits++;
+		return *CachedAssets;
+	}
+	CacheMisses++;
+	const double LoadStartTime = FPlatformTime::Seconds();
+
+	FResourceNodeCache& CachedAssets = ResourceNodeCache.Add(ResourceClassName);
+	CachedAssets.ResourceClass = FindObject<UClass>(ANY_PACKAGE, *ResourceClassName.ToString());
+
+	if (UResourceRouletteAssets::SolidResourceInfoMap.Contains(ResourceClassName))
+	{
+		CachedAssets.Mesh = ResolveAsset<UStaticMesh>(UResourceRouletteAssets::GetSolidMesh(ResourceClassName),
+		                                              NumSyncLoads);
+		CachedAssets.bSolidAssetsLoaded = CachedAssets.Mesh != nullptr;
+		if (!CachedAssets.Mesh)
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Failed to load mesh for resource: %s"), *ResourceClassName.ToString()),
+				ELogLevel::Warning
+			);
+		}
+
+		for (const FString& MaterialPath : UResourceRouletteAssets::GetSolidMaterial(ResourceClassName))
+		{
+			// The rock only needs its mesh for collision when nothing draws it
+			if (bHeadless)
+			{
+				CachedAssets.NumAssetsSkipped++;
+			}
+			else if (UMaterialInterface* Material = ResolveAsset<UMaterialInterface>(MaterialPath, NumSyncLoads))
+			{
+				CachedAssets.Materials.Add(Material);
+			}
+			else
+			{
+				FResourceRouletteUtilityLog::Get().LogMessage(
+					FString::Printf(
+						TEXT("Failed to load material for resource: %s, MaterialPath: %s"),
+						*ResourceClassName.ToString(), *MaterialPath),
+					ELogLevel::Warning);
+				CachedAssets.bSolidAssetsLoaded = false;
+			}
+		}
+	}
+
+	const TArray<FString> DecalMaterialPaths = UResourceRouletteAssets::GetLiquidMaterials(ResourceClassName);
+	if (bHeadless && DecalMaterialPaths.Num() > 0)
+	{
+		// No decal gets made, so there's nothing to load
+		CachedAssets.bDecalAssetsLoaded = true;
+		CachedAssets.NumAssetsSkipped++;
+	}
+	else if (DecalMaterialPaths.Num() > 0)
+	{
+		CachedAssets.DecalMaterial = ResolveAsset<UMaterialInterface>(DecalMaterialPaths[0], NumSyncLoads);
+		CachedAssets.bDecalAssetsLoaded = CachedAssets.DecalMaterial != nullptr;
+		if (!CachedAssets.DecalMaterial)
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Failed to load decal material for resource: %s, Path: %s"),
+				                *ResourceClassName.ToString(), *DecalMaterialPaths[0]),
+				ELogLevel::Warning);
+		}
+	}
+	AssetLoadSeconds += FPlatformTime::Seconds() - LoadStartTime;
+	return CachedAssets;
+}
+
+/// The instanced mesh for a resource class's rocks, made on first use and owned by the subsystem actor so every
+/// node of the class draws in one go
+/// @param ResourceClassName Resource class
+/// @param CachedAssets Its mesh and materials
+/// @return nullptr if there's no subsystem to own it
+UHierarchicalInstancedStaticMeshComponent* UResourceNodeSpawner::GetOrCreateNodeMeshInstances(
+	const FName& ResourceClassName, const FResourceNodeCache& CachedAssets)
+{
+	if (UHierarchicalInstancedStaticMeshComponent* MeshInstances = NodeMeshInstances.FindRef(ResourceClassName))
+	{
+		return MeshInstances;
+	}
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = NodeStore.Get();
+	if (!ResourceRouletteSubsystem)
+	{
+		return nullptr;
+	}
+
+	// Only draws, each node brings its own hidden collision mesh so a proxy's rock stops costing physics
+	UHierarchicalInstancedStaticMeshComponent* MeshInstances = NewObject<UHierarchicalInstancedStaticMeshComponent>(
+		ResourceRouletteSubsystem);
+	MeshInstances->SetMobility(EComponentMobility::Movable);
+	MeshInstances->SetStaticMesh(CachedAssets.Mesh);
+	for (int32 i = 0; i < CachedAssets.Materials.Num(); ++i)
+	{
+		MeshInstances->SetMaterial(i, CachedAssets.Materials[i]);
+	}
+	MeshInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeshInstances->SetGenerateOverlapEvents(false);
+	MeshInstances->ComponentTags.Add(ResourceRouletteTag);
+	MeshInstances->RegisterComponent();
+	ResourceRouletteSubsystem->AddInstanceComponent(MeshInstances);
+	NodeMeshInstances.Add(ResourceClassName, MeshInstances);
+	return MeshInstances;
+}
+
+/// The instanced mesh a node's rock is drawn with, so settle traces can ignore it
+/// @param NodeGUID Spawned node
+/// @return nullptr if the node has its own mesh
+const UPrimitiveComponent* UResourceNodeSpawner::GetNodeMeshInstances(const FGuid& NodeGUID) const
+{
+	const FResourceNodeMeshInstance* MeshInstance = NodeMeshInstanceIndexes.Find(NodeGUID);
+	return MeshInstance ? NodeMeshInstances.FindRef(MeshInstance->ResourceClass) : nullptr;
+}
+
+/// Queues a node's rock instance to move to where settling put the node, FlushNodeMeshInstanceMoves applies it
+/// @param NodeData Settled node
+/// @return false if the node has its own mesh instead
+bool UResourceNodeSpawner::UpdateNodeMeshInstance(const FResourceNodeData& NodeData)
+{
+	const FResourceNodeMeshInstance* MeshInstance = NodeMeshInstanceIndexes.Find(NodeData.NodeGUID);
+	if (!MeshInstance || !NodeMeshInstances.FindRef(MeshInstance->ResourceClass))
+	{
+		return false;
+	}
+	const FTransform InstanceTransform(NodeData.Rotation, NodeData.Location + NodeData.Offset, NodeData.Scale);
+	PendingMeshInstanceMoves.FindOrAdd(MeshInstance->ResourceClass).Add(MeshInstance->InstanceIndex,
+	                                                                     InstanceTransform);
+
+	// The hidden collision copy goes with it, on a proxy too so it's in place when it gets registered again
+	if (const AFGResourceNode* ResourceNode = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
+	{
+		TArray<UStaticMeshComponent*> MeshComponents;
+		ResourceNode->GetComponents(MeshComponents);
+		for (UStaticMeshComponent* MeshComponent : MeshComponents)
+		{
+			if (MeshComponent->ComponentTags.Contains(NodeCollisionTag))
+			{
+				MeshComponent->SetWorldTransform(InstanceTransform, false, nullptr, ETeleportType::TeleportPhysics);
+			}
+		}
+	}
+	return true;
+}
+
+/// Applies the queued rock instance moves. Runs of neighbouring instances go over in one batch and each class's
+/// tree and render state get rebuilt once, not once per node
+void UResourceNodeSpawner::FlushNodeMeshInstanceMoves()
+{
+	if (PendingMeshInstanceMoves.IsEmpty())
+	{
+		return;
+	}
+	RR_PROFILE();
+	TArray<FTransform> RunTransforms;
+	for (TPair<FName, TMap<int32, FTransform>>& ClassMoves : PendingMeshInstanceMoves)
+	{
+		UHierarchicalInstancedStaticMeshComponent* MeshInstances = NodeMeshInstances.FindRef(ClassMoves.Key);
+		if (!IsValid(MeshInstances))
+		{
+			continue;
+		}
+		ClassMoves.Value.KeySort(TLess<int32>());
+		int32 RunStartIndex = INDEX_NONE;
+		for (const TPair<int32, FTransform>& Move : ClassMoves.Value)
+		{
+			if (RunStartIndex + RunTransforms.Num() != Move.Key)
+			{
+				if (!RunTransforms.IsEmpty())
+				{
+					MeshInstances->BatchUpdateInstancesTransforms(RunStartIndex, RunTransforms, true, false, true);
+				}
+				RunStartIndex = Move.Key;
+				RunTransforms.Reset();
+			}
+			RunTransforms.Add(Move.Value);
+		}
+		MeshInstances->BatchUpdateInstancesTransforms(RunStartIndex, RunTransforms, true, false, true);
+		RunTransforms.Reset();
+		MeshInstances->BuildTreeIfOutdated(true, false);
+		MeshInstances->MarkRenderStateDirty();
+	}
+	PendingMeshInstanceMoves.Empty();
+}
+
+/// Switches a solid node between full and proxy. A full node has the box extractors, the scanner and the build
+/// gun look for, and a hidden copy of its rock to stand on when the rock is an instance. A proxy has those
+/// unregistered, which takes their physics bodies with them, and is left with its actor, root and resource data,
+/// which is all extractors, scanner clusters and the map hold on to. The components are built once at spawn and
+/// only ever registered again, the same as the class's own box. A rock that's the node's own mesh can't go without
+/// the node vanishing, it only loses its collision
+/// @param ResourceNode Spawned node
+/// @param NodeData Where the node is now, the collision gets moved there when it comes back
+/// @param bEnabled true for the full node
+void UResourceNodeSpawner::SetNodeCollision(AFGResourceNode* ResourceNode, const FResourceNodeData& NodeData,
+                                            const bool bEnabled)
+{
+	const FRotator MeshRotation = NodeData.IsRayCasted ? NodeData.Rotation : FRotator::ZeroRotator;
+	TArray<UPrimitiveComponent*> PrimitiveComponents;
+	ResourceNode->GetComponents(PrimitiveComponents);
+	for (UPrimitiveComponent* PrimitiveComponent : PrimitiveComponents)
 	{
-		ResourceRouletteSubsystem->SetSessionRandomizedResourceNodes(ProcessedNodes);
-		ResourceRouletteSubsystem->SetSessionAlreadySpawned(true);
+		const bool bIsNodeCollision = PrimitiveComponent->ComponentTags.Contains(NodeCollisionTag);
+		if (bIsNodeCollision || PrimitiveComponent->IsA<UBoxComponent>())
+		{
+			if (bEnabled && !PrimitiveComponent->IsRegistered())
+			{
+				// The node may have settled while it was a proxy
+				if (bIsNodeCollision && PrimitiveComponent->IsA<UStaticMeshComponent>())
+				{
+					PrimitiveComponent->SetWorldTransform(
+						FTransform(MeshRotation, NodeData.Location + NodeData.Offset, NodeData.Scale));
+				}
+				else if (bIsNodeCollision)
+				{
+					PrimitiveComponent->SetWorldLocationAndRotation(NodeData.Location, MeshRotation);
+				}
+				PrimitiveComponent->RegisterComponent();
+			}
+			else if (!bEnabled && PrimitiveComponent->IsRegistered())
+			{
+				PrimitiveComponent->UnregisterComponent();
+			}
+		}
+		else if (PrimitiveComponent->IsA<UStaticMeshComponent>() &&
+			PrimitiveComponent->ComponentTags.Contains(ResourceRouletteTag))
+		{
+			PrimitiveComponent->SetCollisionEnabled(bEnabled
+				                                        ? ECollisionEnabled::QueryAndPhysics
+				                                        : ECollisionEnabled::NoCollision);
+		}
 	}
 }
 
+/// Builds what a player touches on a solid node: the collision box, and for an instanced rock a copy of the mesh
+/// that collides but never draws. Built once at spawn and tagged so SetNodeCollision can switch them
+/// @param ResourceNode Node to add them to, its root is already set up
+/// @param NodeData Where the node and its rock are
+/// @param CollisionMesh The rock if it's an instance, nullptr if the node has its own mesh that collides
+/// @param MeshExtent World half size of the rock, the box is a bit smaller
+void UResourceNodeSpawner::AddNodeCollision(AFGResourceNode* ResourceNode, const FResourceNodeData& NodeData,
+                                            UStaticMesh* CollisionMesh, const FVector& MeshExtent) const
+{
+	USceneComponent* Root = ResourceNode->GetRootComponent();
+	const FRotator MeshRotation = NodeData.IsRayCasted ? NodeData.Rotation : FRotator::ZeroRotator;
+	if (CollisionMesh)
+	{
+		// Hidden before it's registered, so it never gets a render proxy
+		UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(ResourceNode);
+		MeshComponent->SetupAttachment(Root);
+		MeshComponent->SetMobility(EComponentMobility::Movable);
+		MeshComponent->SetStaticMesh(CollisionMesh);
+		MeshComponent->SetVisibility(false);
+		MeshComponent->SetHiddenInGame(true);
+		MeshComponent->SetCastShadow(false);
+		MeshComponent->ComponentTags.Add(ResourceRouletteTag);
+		MeshComponent->ComponentTags.Add(NodeCollisionTag);
+		MeshComponent->RegisterComponent();
+		MeshComponent->SetCollisionProfileName("ResourceMesh");
+		MeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		MeshComponent->SetCollisionObjectType(ECC_WorldStatic);
+		MeshComponent->SetGenerateOverlapEvents(false);
+		MeshComponent->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+		MeshComponent->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+		const FTransform MeshTransform(MeshRotation, NodeData.Location + NodeData.Offset, NodeData.Scale);
+		MeshComponent->SetWorldTransform(MeshTransform, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	UBoxComponent* CollisionBox = NewObject<UBoxComponent>(ResourceNode);
+	CollisionBox->SetupAttachment(Root);
+	CollisionBox->ComponentTags.Add(NodeCollisionTag);
+	CollisionBox->RegisterComponent();
+	CollisionBox->SetBoxExtent(MeshExtent / (ResourceNode->GetActorScale3D() * 1.35));
+	CollisionBox->SetCollisionProfileName("Resource");
+	CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	CollisionBox->SetGenerateOverlapEvents(true);
+	CollisionBox->SetRelativeLocation(FVector::ZeroVector, false, nullptr, ETeleportType::TeleportPhysics);
+	CollisionBox->SetWorldLocation(NodeData.Location);
+	CollisionBox->SetWorldRotation(MeshRotation);
+}
+
+/// Drops every rock instance. The components stay around for the next spawn unless they belong to a subsystem
+/// that's gone, e.g. after loading another save
+void UResourceNodeSpawner::ClearNodeMeshInstances()
+{
+	const AResourceRouletteSubsystem* ResourceRouletteSubsystem = NodeStore.Get();
+	for (auto It = NodeMeshInstances.CreateIterator(); It; ++It)
+	{
+		if (!IsValid(It->Value) || It->Value->GetOwner() != ResourceRouletteSubsystem)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		It->Value->ClearInstances();
+	}
+	NodeMeshInstanceIndexes.Empty();
+	PendingMeshInstanceMoves.Empty();
+}
+
+/// Finds the node actor class by name, once per name
+/// @param Classname Class name stored on the node
+/// @return The class, or nullptr if it doesn't exist
+UClass* UResourceNodeSpawner::GetNodeActorClass(const FString& Classname)
+{
+	if (UClass** CachedClass = NodeActorClassCache.Find(Classname))
+	{
+		return *CachedClass;
+	}
+	UClass* NodeActorClass = FindObject<UClass>(ANY_PACKAGE, *Classname);
+	NodeActorClassCache.Add(Classname, NodeActorClass);
+	return NodeActorClass;
+}
+
 /// Handles spawning nodes that use decals - in the case that's crude oil nodes
 /// @param World World Context
 /// @param NodeData Node data to process
@@ -110,10 +658,10 @@ bool UResourceNodeSpawner::SpawnResourceNodeDecal(UWorld* World, FResourceNodeDa
 
 	const FName ResourceClassName = NodeData.ResourceClass;
 
-	TArray<FString> MaterialPaths = ResourceAssets->GetLiquidMaterials(ResourceClassName);
 	float DecalScale = ResourceAssets->GetLiquidDecalScale(ResourceClassName);
 
-	if (MaterialPaths.Num() == 0)
+	if (!UResourceRouletteAssets::LiquidResourceInfoMap.Contains(ResourceClassName) ||
+		UResourceRouletteAssets::GetLiquidMaterials(ResourceClassName).Num() == 0)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage(
 			FString::Printf(TEXT("No materials found for liquid resource: %s"), *ResourceClassName.ToString()),
@@ -121,20 +669,15 @@ bool UResourceNodeSpawner::SpawnResourceNodeDecal(UWorld* World, FResourceNodeDa
 		return false;
 	}
 
-	UMaterialInterface* DecalMaterial = Cast<UMaterialInterface>(
-		StaticLoadObject(UMaterialInterface::StaticClass(), nullptr, *MaterialPaths[0]));
-
-	if (!DecalMaterial)
+	// Failures were logged when the cache entry was built
+	const FResourceNodeCache& CachedAssets = GetResourceNodeCache(ResourceClassName);
+	if (!CachedAssets.bDecalAssetsLoaded)
 	{
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(TEXT("Failed to load decal material for resource: %s, Path: %s"),
-			                *ResourceClassName.ToString(),
-			                *MaterialPaths[0]),
-			ELogLevel::Warning);
 		return false;
 	}
+	UMaterialInterface* DecalMaterial = CachedAssets.DecalMaterial;
 
-	UClass* Classname = FindObject<UClass>(ANY_PACKAGE, *NodeData.Classname);
+	UClass* Classname = GetNodeActorClass(NodeData.Classname);
 	if (!Classname)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage(
@@ -143,7 +686,9 @@ bool UResourceNodeSpawner::SpawnResourceNodeDecal(UWorld* World, FResourceNodeDa
 		return false;
 	}
 
-	AFGResourceNode* ResourceNode = World->SpawnActor<AFGResourceNode>(Classname, NodeData.Location, NodeData.Rotation);
+	// Deferred so the components below exist before BeginPlay sees the node
+	const FTransform SpawnTransform(NodeData.Rotation, NodeData.Location);
+	AFGResourceNode* ResourceNode = World->SpawnActorDeferred<AFGResourceNode>(Classname, SpawnTransform);
 	if (!ResourceNode)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage(
@@ -151,37 +696,51 @@ bool UResourceNodeSpawner::SpawnResourceNodeDecal(UWorld* World, FResourceNodeDa
 			ELogLevel::Warning);
 		return false;
 	}
+	ResourceNode->InitResource(CachedAssets.ResourceClass, NodeData.Amount, NodeData.Purity);
+	ResourceNode->mResourceNodeType = NodeData.ResourceNodeType;
+	ResourceNode->mCanPlacePortableMiner = NodeData.bCanPlaceResourceExtractor;
+	ResourceNode->mCanPlaceResourceExtractor = NodeData.bCanPlaceResourceExtractor;
+	ResourceNode->SetFlags(EObjectFlags::RF_Transient);
 
-	UDecalComponent* DecalComponent = NewObject<UDecalComponent>(ResourceNode);
-	if (!DecalComponent)
+	if (bHeadless)
 	{
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(
-				TEXT("Failed to create DecalComponent for resource node at location: %s"),
-				*NodeData.Location.ToString()),
-			ELogLevel::Warning);
-		ResourceNode->Destroy();
-		return false;
+		// Nothing to draw the decal, a bare root placed the same way keeps the box below where clients have it
+		USceneComponent* Root = NewObject<USceneComponent>(ResourceNode);
+		Root->SetWorldLocation(NodeData.Location);
+		Root->SetWorldRotation(FRotator(-90.0f, 0.0f, 0.0f));
+		Root->RegisterComponent();
+		ResourceNode->SetRootComponent(Root);
+		NumDecalsSkipped++;
 	}
+	else
+	{
+		UDecalComponent* DecalComponent = NewObject<UDecalComponent>(ResourceNode);
+		if (!DecalComponent)
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(
+					TEXT("Failed to create DecalComponent for resource node at location: %s"),
+					*NodeData.Location.ToString()),
+				ELogLevel::Warning);
+			ResourceNode->FinishSpawning(SpawnTransform);
+			ResourceNode->Destroy();
+			return false;
+		}
 
-	DecalComponent->ComponentTags.Add(ResourceRouletteTag);
-	DecalComponent->SetDecalMaterial(DecalMaterial);
-	DecalComponent->DecalSize = FVector(80, DecalScale, DecalScale);
-	DecalComponent->SetWorldLocation(NodeData.Location);
-	// DecalComponent->SetWorldRotation(NodeData.Rotation);
-	// DecalComponent->SetWorldRotation(FRotator::ZeroRotator);
-	DecalComponent->SetWorldRotation(FRotator(-90.0f, 0.0f, 0.0f));
-	DecalComponent->RegisterComponent();
-
-	ResourceNode->SetRootComponent(DecalComponent);
-	ResourceNode->AddInstanceComponent(DecalComponent);
+		DecalComponent->ComponentTags.Add(ResourceRouletteTag);
+		DecalComponent->SetDecalMaterial(DecalMaterial);
+		DecalComponent->DecalSize = FVector(80, DecalScale, DecalScale);
+		DecalComponent->SetWorldLocation(NodeData.Location);
+		// DecalComponent->SetWorldRotation(NodeData.Rotation);
+		// DecalComponent->SetWorldRotation(FRotator::ZeroRotator);
+		DecalComponent->SetWorldRotation(FRotator(-90.0f, 0.0f, 0.0f));
+		DecalComponent->RegisterComponent();
+
+		ResourceNode->SetRootComponent(DecalComponent);
+		ResourceNode->AddInstanceComponent(DecalComponent);
+	}
 
-	UClass* ResourceClass = FindObject<UClass>(ANY_PACKAGE, *NodeData.ResourceClass.ToString());
-	ResourceNode->InitResource(ResourceClass, NodeData.Amount, NodeData.Purity);
 	ResourceNode->SetActorScale3D(FVector(1.0f));
-	ResourceNode->mResourceNodeType = NodeData.ResourceNodeType;
-	ResourceNode->mCanPlacePortableMiner = NodeData.bCanPlaceResourceExtractor;
-	ResourceNode->mCanPlaceResourceExtractor = NodeData.bCanPlaceResourceExtractor;
 
 	if (!ResourceNode->mBoxComponent)
 	{
@@ -193,10 +752,9 @@ bool UResourceNodeSpawner::SpawnResourceNodeDecal(UWorld* World, FResourceNodeDa
 
 	ResourceNode->mBoxComponent->SetGenerateOverlapEvents(true);
 	ResourceNode->mBoxComponent->SetWorldScale3D(FVector(30.0f, 30.0f, 2.0f));
-
+	ResourceNode->FinishSpawning(SpawnTransform);
 
 	// Register the node in the tracking system
-	ResourceNode->SetFlags(EObjectFlags::RF_Transient);
 	NodeData.NodeGUID = FGuid::NewGuid();
 	SpawnedResourceNodes.Add(NodeData.NodeGUID, ResourceNode);
 
@@ -230,47 +788,24 @@ bool UResourceNodeSpawner::SpawnResourceNodeSolid(UWorld* World, FResourceNodeDa
 
 	// For now only Solid and decal Nodes TODO: Add other node types
 	const FName ResourceClassName = NodeData.ResourceClass;
-	const FString MeshPath = ResourceAssets->GetSolidMesh(ResourceClassName);
-	TArray<FString> MaterialPaths = ResourceAssets->GetSolidMaterial(ResourceClassName);
 	NodeData.Offset = ResourceAssets->GetSolidOffset(ResourceClassName);
 	NodeData.Scale = ResourceAssets->GetSolidScale(ResourceClassName);
 
 
-	// Load the mesh asset
-	UStaticMesh* Mesh = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, *MeshPath));
-	if (!Mesh)
+	// Mesh and materials come from the cache, failures were logged when the entry was built
+	const FResourceNodeCache& CachedAssets = GetResourceNodeCache(ResourceClassName);
+	if (!CachedAssets.bSolidAssetsLoaded)
 	{
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(TEXT("Failed to load mesh for resource: %s"), *ResourceClassName.ToString()),
-			ELogLevel::Warning
-		);
 		return false;
 	}
-
-	// Load materials
-	TArray<UMaterialInterface*> Materials;
-	for (const FString& MaterialPath : MaterialPaths)
-	{
-		if (UMaterialInterface* Material = Cast<UMaterialInterface>(
-			StaticLoadObject(UMaterialInterface::StaticClass(), nullptr, *MaterialPath)))
-		{
-			Materials.Add(Material);
-		}
-		else
-		{
-			FResourceRouletteUtilityLog::Get().LogMessage(
-				FString::Printf(
-					TEXT("Failed to load material for resource: %s, MaterialPath: %s"), *ResourceClassName.ToString(),
-					*MaterialPath),
-				ELogLevel::Warning);
-			return false;
-		}
-	}
+	UStaticMesh* Mesh = CachedAssets.Mesh;
+	const TArray<UMaterialInterface*>& Materials = CachedAssets.Materials;
 
 	// Spawn the Resource Node
-	UClass* Classname = FindObject<UClass>(ANY_PACKAGE, *NodeData.Classname);
-	AFGResourceNode* ResourceNode;
-	ResourceNode = World->SpawnActor<AFGResourceNode>(Classname, NodeData.Location, FRotator::ZeroRotator);
+	UClass* Classname = GetNodeActorClass(NodeData.Classname);
+	// Deferred so the root, mesh and collision box below exist before BeginPlay sees the node
+	const FTransform SpawnTransform(FRotator::ZeroRotator, NodeData.Location);
+	AFGResourceNode* ResourceNode = World->SpawnActorDeferred<AFGResourceNode>(Classname, SpawnTransform);
 	if (!ResourceNode)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage(
@@ -278,16 +813,17 @@ bool UResourceNodeSpawner::SpawnResourceNodeSolid(UWorld* World, FResourceNodeDa
 			ELogLevel::Warning);
 		return false;
 	}
-	UClass* ResourceClass = FindObject<UClass>(ANY_PACKAGE, *NodeData.ResourceClass.ToString());
-	ResourceNode->InitResource(ResourceClass, NodeData.Amount, NodeData.Purity);
-	ResourceNode->SetActorScale3D(NodeData.Scale);
+	ResourceNode->InitResource(CachedAssets.ResourceClass, NodeData.Amount, NodeData.Purity);
 	ResourceNode->mResourceNodeType = NodeData.ResourceNodeType;
 	ResourceNode->mCanPlacePortableMiner = NodeData.bCanPlaceResourceExtractor;
 	ResourceNode->mCanPlaceResourceExtractor = NodeData.bCanPlaceResourceExtractor;
+	ResourceNode->SetFlags(EObjectFlags::RF_Transient);
+	ResourceNode->SetActorScale3D(NodeData.Scale);
 
 	ResourceNode->UpdateMeshFromDescriptor();
 
-	// Set up the USceneComponent as root component
+	// Set up the USceneComponent as root component. The actor is still deferred so every component gets registered
+	// by hand, it's already in the level
 	USceneComponent* Root = NewObject<USceneComponent>(ResourceNode);
 	ResourceNode->SetRootComponent(Root);
 	Root->RegisterComponent();
@@ -296,68 +832,66 @@ bool UResourceNodeSpawner::SpawnResourceNodeSolid(UWorld* World, FResourceNodeDa
 	Root->SetWorldLocation(NodeData.Location);
 	Root->SetWorldRotation(FRotator::ZeroRotator);
 
-	// Set up the Mesh
-	UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(ResourceNode);
-	if (!MeshComponent)
-	{
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(
-				TEXT("Failed to spawn MeshComponent for resource node at location: %s"), *NodeData.Location.ToString()),
-			ELogLevel::Warning);
-		return false;
-	}
-
-	MeshComponent->RegisterComponent();
-	MeshComponent->SetupAttachment(Root);
-	MeshComponent->SetCollisionProfileName("ResourceMesh");
-	MeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	MeshComponent->SetCollisionObjectType(ECC_WorldStatic);
-	MeshComponent->SetGenerateOverlapEvents(false);
-	MeshComponent->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
-	MeshComponent->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
-	MeshComponent->SetMobility(EComponentMobility::Movable);
-	MeshComponent->SetStaticMesh(Mesh);
-	MeshComponent->SetVisibility(true);
-	MeshComponent->ComponentTags.Add(ResourceRouletteTag);
-
-	for (int32 i = 0; i < Materials.Num(); ++i)
+	NodeData.NodeGUID = FGuid::NewGuid();
+	const FRotator MeshRotation = NodeData.IsRayCasted ? NodeData.Rotation : FRotator::ZeroRotator;
+	FVector MeshExtent;
+	UHierarchicalInstancedStaticMeshComponent* MeshInstances = nullptr;
+	if (bInstancedRocksRequired || CVarInstancedNodeMeshes.GetValueOnGameThread() != 0)
 	{
-		MeshComponent->SetMaterial(i, Materials[i]);
+		MeshInstances = GetOrCreateNodeMeshInstances(ResourceClassName, CachedAssets);
 	}
-	MeshComponent->SetRelativeScale3D(NodeData.Scale);
-	MeshComponent->SetRelativeRotation(FRotator::ZeroRotator, false, nullptr, ETeleportType::TeleportPhysics);
-	MeshComponent->SetRelativeLocation(NodeData.Offset, false, nullptr, ETeleportType::TeleportPhysics);
-	MeshComponent->SetWorldLocation(NodeData.Location + NodeData.Offset);
-	if (NodeData.IsRayCasted)
+	if (MeshInstances)
 	{
-		MeshComponent->SetWorldRotation(NodeData.Rotation);
+		// The rock is one instance of the class's mesh on the subsystem, the node gets a hidden copy to collide
+		// with, its collision box and the gameplay bits
+		const FTransform InstanceTransform(MeshRotation, NodeData.Location + NodeData.Offset, NodeData.Scale);
+		NodeMeshInstanceIndexes.Add(NodeData.NodeGUID,
+		                            {ResourceClassName, MeshInstances->AddInstance(InstanceTransform, true)});
+		MeshExtent = Mesh->GetBounds().TransformBy(InstanceTransform).BoxExtent;
 	}
 	else
 	{
-		MeshComponent->SetWorldRotation(FRotator::ZeroRotator);
-	}
+		// Set up the Mesh
+		UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(ResourceNode);
+		if (!MeshComponent)
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Failed to spawn MeshComponent for resource node at location: %s"),
+				                *NodeData.Location.ToString()),
+				ELogLevel::Warning);
+			ResourceNode->FinishSpawning(SpawnTransform);
+			ResourceNode->Destroy();
+			return false;
+		}
 
-	// Set up the Collision box
-	UBoxComponent* CollisionBox = NewObject<UBoxComponent>(ResourceNode);
-	CollisionBox->RegisterComponent();
-	CollisionBox->SetupAttachment(Root);
-	FVector MeshExtent = MeshComponent->Bounds.BoxExtent;
-	FVector CollisionBoxExtent = MeshExtent;
-	CollisionBox->SetBoxExtent(CollisionBoxExtent / (ResourceNode->GetActorScale3D() * 1.35));
-	CollisionBox->SetCollisionProfileName("Resource");
-	CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	CollisionBox->SetGenerateOverlapEvents(true);
-	CollisionBox->SetRelativeLocation(FVector::ZeroVector, false, nullptr, ETeleportType::TeleportPhysics);
-	CollisionBox->SetWorldLocation(NodeData.Location);
-	if (NodeData.IsRayCasted)
-	{
-		CollisionBox->SetWorldRotation(NodeData.Rotation);
-	}
-	else
-	{
-		CollisionBox->SetWorldRotation(FRotator::ZeroRotator);
+		MeshComponent->SetupAttachment(Root);
+		MeshComponent->RegisterComponent();
+		MeshComponent->SetCollisionProfileName("ResourceMesh");
+		MeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		MeshComponent->SetCollisionObjectType(ECC_WorldStatic);
+		MeshComponent->SetGenerateOverlapEvents(false);
+		MeshComponent->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+		MeshComponent->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+		MeshComponent->SetMobility(EComponentMobility::Movable);
+		MeshComponent->SetStaticMesh(Mesh);
+		MeshComponent->SetVisibility(true);
+		MeshComponent->ComponentTags.Add(ResourceRouletteTag);
+
+		for (int32 i = 0; i < Materials.Num(); ++i)
+		{
+			MeshComponent->SetMaterial(i, Materials[i]);
+		}
+		MeshComponent->SetRelativeScale3D(NodeData.Scale);
+		MeshComponent->SetRelativeRotation(FRotator::ZeroRotator, false, nullptr, ETeleportType::TeleportPhysics);
+		MeshComponent->SetRelativeLocation(NodeData.Offset, false, nullptr, ETeleportType::TeleportPhysics);
+		MeshComponent->SetWorldLocation(NodeData.Location + NodeData.Offset);
+		MeshComponent->SetWorldRotation(MeshRotation);
+		MeshExtent = MeshComponent->Bounds.BoxExtent;
 	}
 
+	AddNodeCollision(ResourceNode, NodeData, MeshInstances ? Mesh : nullptr, MeshExtent);
+	ResourceNode->FinishSpawning(SpawnTransform);
+
 	// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Actor Spawned at World Location: %s"), *ResourceNode->GetActorLocation().ToString()),ELogLevel::Debug);
 	// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("MeshComponent Relative Location: %s, Scale: %s"),*MeshComponent->GetRelativeLocation().ToString(), *MeshComponent->GetRelativeScale3D().ToString()),ELogLevel::Debug);
 	// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("MeshComponent World Location: %s"), *MeshComponent->GetComponentLocation().ToString()),ELogLevel::Debug);
@@ -367,8 +901,6 @@ bool UResourceNodeSpawner::SpawnResourceNodeSolid(UWorld* World, FResourceNodeDa
 	ResourceNode->InitRadioactivity();
 	ResourceNode->UpdateRadioactivity();
 
-	ResourceNode->SetFlags(EObjectFlags::RF_Transient);
-	NodeData.NodeGUID = FGuid::NewGuid();
 	SpawnedResourceNodes.Add(NodeData.NodeGUID, ResourceNode);
 
 	return true;
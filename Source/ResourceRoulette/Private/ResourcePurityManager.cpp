@@ -8,34 +8,26 @@
 
 UResourcePurityManager::UResourcePurityManager()
 {
-	RemainingPurityCounts.Empty();
-	FoundPurityCounts.Empty();
-
 	PurityZones.Add({FVector2D(-50000.0f, 240000.0f), 80000.0f, EResourcePurity::RP_Inpure}); // Grasslands Spawn
 	PurityZones.Add({FVector2D(50000.0f, -90000.0f), 80000.0f, EResourcePurity::RP_Inpure}); // Northern Forest Spawn
 	PurityZones.Add({FVector2D(300000.0f, -175000.0f), 120000.0f, EResourcePurity::RP_Inpure}); //Dune Desert Spawn
 	PurityZones.Add({FVector2D(-220000.0f, -35000.0f), 80000.0f, EResourcePurity::RP_Inpure}); //Rocky Desert Spawn
 }
 
-/// Gets Remaining Purity Counts
-/// @return TMap of Remaining Purity Counts
-const TMap<FName, TMap<EResourcePurity, int32>>& UResourcePurityManager::GetRemainingPurityCounts() const
-{
-	return RemainingPurityCounts;
-}
-
 /// Sets Remaining Purity Count values
-/// @param NewPurityCounts TMap you'd like to overwrite it with
-void UResourcePurityManager::SetRemainingPurityCounts(const TMap<FName, TMap<EResourcePurity, int32>>& NewPurityCounts)
+/// @param NewRemainingPurities Budget you'd like to overwrite it with, indexed the same as GetResourceClasses
+void UResourcePurityManager::SetRemainingPurities(const ResourceRouletteCore::FPurityBudget& NewRemainingPurities)
 {
-	RemainingPurityCounts = NewPurityCounts;
+	RemainingPurities = NewRemainingPurities;
 }
 
-/// Gets the Original "Found" Purity Count values
-/// @return TMap of the found purity counts
-const TMap<FName, TMap<EResourcePurity, int32>>& UResourcePurityManager::GetFoundPurityCounts() const
+/// Gets the dense index a resource class got during the last scan
+/// @param ResourceClass FName of resource class
+/// @return Index into the budgets or INDEX_NONE if the scan didn't see it
+int32 UResourcePurityManager::GetResourceClassIndex(const FName ResourceClass) const
 {
-	return FoundPurityCounts;
+	const int32* ClassIndex = ResourceClassIndexes.Find(ResourceClass);
+	return ClassIndex ? *ClassIndex : INDEX_NONE;
 }
 
 EResourcePurity UResourcePurityManager::GetZonePurity(const FVector& Location) const
@@ -51,33 +43,48 @@ EResourcePurity UResourcePurityManager::GetZonePurity(const FVector& Location) c
 	return EResourcePurity::RP_MAX;
 }
 
-/// Checks to see if the requested purity is available in RemainingPurityCounts
+/// Checks to see if the requested purity is available in RemainingPurities
 /// @param ResourceClass FName of resource class we're checking
 /// @param Purity Purity we're checking
 /// @return 
 bool UResourcePurityManager::IsPurityAvailable(const FName ResourceClass, const EResourcePurity Purity) const
 {
-	if (RemainingPurityCounts.Contains(ResourceClass))
-	{
-		const auto& PurityCounts = RemainingPurityCounts[ResourceClass];
-		return PurityCounts.Contains(Purity) && PurityCounts[Purity] > 0;
-	}
-	return false;
+	return IsPurityAvailable(GetResourceClassIndex(ResourceClass), Purity);
 }
 
-/// Decrements the availability count for a given ore type and purity level in RemainingPurityCounts
+/// Same as above for callers that already have the class index
+/// @param ClassIndex Index from GetResourceClassIndex
+/// @param Purity Purity we're checking
+/// @return 
+bool UResourcePurityManager::IsPurityAvailable(const int32 ClassIndex, const EResourcePurity Purity) const
+{
+	return ResourceRouletteCore::IsPurityAvailable(RemainingPurities, ClassIndex,
+	                                               static_cast<ResourceRouletteCore::EPurity>(Purity));
+}
+
+/// Decrements the availability count for a given ore type and purity level in RemainingPurities
 /// @param ResourceClass FName of resource class assigned
 /// @param Purity Purity Assigned
 void UResourcePurityManager::DecrementAvailablePurities(const FName ResourceClass, const EResourcePurity Purity)
 {
-	if (RemainingPurityCounts.Contains(ResourceClass))
-	{
-		auto& PurityCounts = RemainingPurityCounts[ResourceClass];
-		if (PurityCounts.Contains(Purity) && PurityCounts[Purity] > 0)
-		{
-			PurityCounts[Purity]--;
-		}
-	}
+	DecrementAvailablePurities(GetResourceClassIndex(ResourceClass), Purity);
+}
+
+/// @param ClassIndex Index from GetResourceClassIndex
+/// @param Purity Purity Assigned
+void UResourcePurityManager::DecrementAvailablePurities(const int32 ClassIndex, const EResourcePurity Purity)
+{
+	ResourceRouletteCore::DecrementAvailablePurity(RemainingPurities, ClassIndex,
+	                                               static_cast<ResourceRouletteCore::EPurity>(Purity));
+}
+
+/// Takes one from the budget if there's any left, safe to call from parallel randomization
+/// @param ClassIndex Index from GetResourceClassIndex
+/// @param Purity Purity Assigned
+/// @return True if the purity was available and got taken
+bool UResourcePurityManager::TryDecrementAvailablePuritiesAtomic(const int32 ClassIndex, const EResourcePurity Purity)
+{
+	return RemainingPurities.TryDecrementAtomic(ClassIndex, static_cast<ResourceRouletteCore::EPurity>(Purity));
 }
 
 /// Adds the found resource to the purity count. Intended to work one at a time
@@ -87,17 +94,32 @@ void UResourcePurityManager::AddFoundPurity(const FName ResourceClass, const ERe
 {
 	if (IsValidPurityEnum(Purity))
 	{
-		FoundPurityCounts.FindOrAdd(ResourceClass).FindOrAdd(Purity)++;
+		int32 ClassIndex = GetResourceClassIndex(ResourceClass);
+		if (ClassIndex == INDEX_NONE)
+		{
+			ClassIndex = FoundPurities.AddClass();
+			ResourceClasses.Add(ResourceClass);
+			ResourceClassIndexes.Add(ResourceClass, ClassIndex);
+		}
+		++FoundPurities.At(ClassIndex, static_cast<ResourceRouletteCore::EPurity>(Purity));
 	}
 }
 
+/// Forgets the interned classes and both budgets before a new scan
+void UResourcePurityManager::ResetPurities()
+{
+	ResourceClasses.Reset();
+	ResourceClassIndexes.Reset();
+	FoundPurities = ResourceRouletteCore::FPurityBudget();
+	RemainingPurities = ResourceRouletteCore::FPurityBudget();
+}
+
 /// Core method of Purity Manager to iterate over all resource nodes and collect their purity levels
 /// @param World - World context
 void UResourcePurityManager::CollectWorldPurities(const UWorld* World)
 {
 	RR_PROFILE();
-	FoundPurityCounts.Empty();
-	RemainingPurityCounts.Empty();
+	ResetPurities();
 	TSet<FName> RegisteredTags = ResourceRouletteCompatibilityManager::GetRegisteredTags();
 
 	for (TActorIterator<AFGResourceNode> It(World); It; ++It)
@@ -134,7 +156,7 @@ void UResourcePurityManager::CollectWorldPurities(const UWorld* World)
 	}
 
 	// LogFoundPurities();
-	RemainingPurityCounts = FoundPurityCounts;
+	RemainingPurities = FoundPurities;
 }
 
 /// Collects purity data from array of FResourceNodeData instead of from the world
@@ -142,8 +164,7 @@ void UResourcePurityManager::CollectWorldPurities(const UWorld* World)
 void UResourcePurityManager::CollectOriginalPurities(const TArray<FResourceNodeData>& ResourceNodes)
 {
 	RR_PROFILE();
-	FoundPurityCounts.Empty();
-	RemainingPurityCounts.Empty();
+	ResetPurities();
 
 	for (const FResourceNodeData& NodeData : ResourceNodes)
 	{
@@ -155,7 +176,7 @@ void UResourcePurityManager::CollectOriginalPurities(const TArray<FResourceNodeD
 		AddFoundPurity(ResourceClassName, NodeData.Purity);
 	}
 
-	RemainingPurityCounts = FoundPurityCounts;
+	RemainingPurities = FoundPurities;
 
 	// LogFoundPurities();
 }
@@ -164,22 +185,13 @@ void UResourcePurityManager::CollectOriginalPurities(const TArray<FResourceNodeD
 /// Logs the purity values
 void UResourcePurityManager::LogFoundPurities()
 {
-	for (const auto& ResourcePair : FoundPurityCounts)
+	using namespace ResourceRouletteCore;
+	for (int32 ClassIndex = 0; ClassIndex < ResourceClasses.Num(); ++ClassIndex)
 	{
-		const FName& ResourceClass = ResourcePair.Key;
-		const int32 PureCount = ResourcePair.Value.Find(EResourcePurity::RP_Pure)
-			                        ? *ResourcePair.Value.Find(EResourcePurity::RP_Pure)
-			                        : 0;
-		const int32 NormalCount = ResourcePair.Value.Find(EResourcePurity::RP_Normal)
-			                          ? *ResourcePair.Value.Find(EResourcePurity::RP_Normal)
-			                          : 0;
-		const int32 ImpureCount = ResourcePair.Value.Find(EResourcePurity::RP_Inpure)
-			                          ? *ResourcePair.Value.Find(EResourcePurity::RP_Inpure)
-			                          : 0;
-
 		const FString LogMessage = FString::Printf(
 			TEXT("%s | Pure: %d | Normal: %d | Impure: %d"),
-			*ResourceClass.ToString(), PureCount, NormalCount, ImpureCount
+			*ResourceClasses[ClassIndex].ToString(), FoundPurities.At(ClassIndex, EPurity::Pure),
+			FoundPurities.At(ClassIndex, EPurity::Normal), FoundPurities.At(ClassIndex, EPurity::Impure)
 		);
 
 		FResourceRouletteUtilityLog::Get().LogMessage(LogMessage, ELogLevel::Debug);
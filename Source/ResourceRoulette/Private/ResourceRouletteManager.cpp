@@ -16,7 +16,82 @@
 #include "Components/BoxComponent.h"
 #include "SessionSettings/SessionSettingsManager.h"
 #include "ResourceRouletteProfiler.h"
-
+#include "UObject/UObjectArray.h"
+#include "Engine/Level.h"
+#include "Algo/AnyOf.h"
+
+/// Lets the world update run spread over frames instead of all at once on the update timer
+static TAutoConsoleVariable<int32> CVarUpdateBudgetMicroseconds(
+	TEXT("ResourceRoulette.UpdateBudgetMicroseconds"), 1000,
+	TEXT("Per-frame time budget for updating world resource nodes in microseconds. 0 = do the whole update at once"),
+	ECVF_Default
+);
+
+/// Only sweep for vanilla meshes once, after that only check what gets streamed in or spawned
+static TAutoConsoleVariable<int32> CVarEventDrivenMeshSuppression(
+	TEXT("ResourceRoulette.EventDrivenMeshSuppression"), 1,
+	TEXT("1 = check newly streamed levels and spawned actors for vanilla node meshes, 0 = sweep every component on every update"),
+	ECVF_Default
+);
+
+/// Trace node settling asynchronously instead of blocking the frame on 50 line traces per node
+static TAutoConsoleVariable<int32> CVarAsyncNodeSettling(
+	TEXT("ResourceRoulette.AsyncNodeSettling"), 1,
+	TEXT("1 = settle nodes onto the terrain with async traces collected over the next frames, 0 = blocking traces"),
+	ECVF_Default
+);
+
+/// Caps how many nodes start settling per update, or per frame with a frame budget, however many players there are
+static TAutoConsoleVariable<int32> CVarMaxSettlesPerTick(
+	TEXT("ResourceRoulette.MaxSettlesPerTick"), 8,
+	TEXT("Max nodes that start settling per tick across all players, nearest to a player first. 0 = no cap"),
+	ECVF_Default
+);
+
+/// Caps how many nodes can have traces in flight, each one is up to 50 traces
+static TAutoConsoleVariable<int32> CVarMaxPendingSettles(
+	TEXT("ResourceRoulette.MaxPendingSettles"), 16,
+	TEXT("Max number of nodes waiting on async settle traces at once"),
+	ECVF_Default
+);
+
+/// Nodes further than this from every player become proxies, the actor with nothing but its root. Off by default:
+/// a value above 0 when spawning forces the rocks onto instanced meshes whatever InstancedNodeMeshes says, since a
+/// proxy has no mesh component of its own to keep them on, so turning it on changes how every save renders
+static TAutoConsoleVariable<int32> CVarNodeActivationRadius(
+	TEXT("ResourceRoulette.NodeActivationRadius"), 0,
+	TEXT("Radius around players in cm inside which solid nodes are full nodes with collision, further out they're "
+		"proxies. Above 0 also forces ResourceRoulette.InstancedNodeMeshes on at the next spawn. 0 = every node is "
+		"always full"),
+	ECVF_Default
+);
+
+/// Extra distance past the activation radius before a node switches off again
+static TAutoConsoleVariable<int32> CVarNodeActivationHysteresis(
+	TEXT("ResourceRoulette.NodeActivationHysteresis"), 5000,
+	TEXT("How far in cm past the activation radius a node has to be before it switches off again"),
+	ECVF_Default
+);
+
+// Search 250m (about 31 foundations) around player to update nodes
+// TODO: Need to test on lower graphical settings to see if this fails
+// Maybe it needs to be reduced based on graphics values?
+static constexpr float NodeUpdateRadius = 25000.0f;
+
+namespace
+{
+	/// Player locations for the node table, which works in its own vector type
+	std::vector<ResourceRouletteCore::FVec3> ToCoreLocations(const TArray<FVector>& Locations)
+	{
+		std::vector<ResourceRouletteCore::FVec3> CoreLocations;
+		CoreLocations.reserve(Locations.Num());
+		for (const FVector& Location : Locations)
+		{
+			CoreLocations.push_back({Location.X, Location.Y, Location.Z});
+		}
+		return CoreLocations;
+	}
+}
 
 /// We may want to add a check rather than just all 4 managers, as we aren't explicity removing these on reload
 /// Alternatively we could ensure they're destroyed (we need destructor method)
@@ -30,6 +105,9 @@ UResourceRouletteManager::UResourceRouletteManager()
 	bIsResourcesScanned = false;
 	bIsResourcesRandomized = false;
 	bIsResourcesSpawned = false;
+	bInitialComponentSweepDone = false;
+	NextSettleId = 0;
+	SettleTraceDelegate.BindUObject(this, &UResourceRouletteManager::OnSettleTraceDone);
 	FResourceRouletteUtilityLog::Get().LogMessage("Resource Manager initialized successfully.", ELogLevel::Debug);
 }
 
@@ -40,18 +118,21 @@ UResourceRouletteManager::UResourceRouletteManager()
 void UResourceRouletteManager::Update(UWorld* World, AResourceRouletteSeedManager* InSeedManager, bool bReroll)
 {
 	RR_PROFILE();
-	const AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
 	if (bReroll)
 	{
 		bIsResourcesScanned = false;
 		bIsResourcesRandomized = false;
 		bIsResourcesSpawned = false;
+		// Cursors into the old nodes are meaningless now, traces still in flight get ignored when they land
+		WorldUpdatePass = FResourceWorldUpdatePass();
+		PendingSettles.Empty();
+		ResourceNodeSpawner->CancelSpawning();
+		bInitialComponentSweepDone = false;
 	}
 	SeedManager = InSeedManager;
 	ScanWorldResourceNodes(World, bReroll);
 	RandomizeWorldResourceNodes(World, bReroll);
-	// Only pass true as parameter if reroll is false & already have saved data, otherwise pass false
-	SpawnWorldResourceNodes(World, (!bReroll && ResourceRouletteSubsystem->GetSessionAlreadySpawned()));
+	SpawnWorldResourceNodes(World);
 	UpdateWorldResourceNodes(World);
 }
 
@@ -77,11 +158,14 @@ void UResourceRouletteManager::ScanWorldResourceNodes(UWorld* World, bool bRerol
 		USessionSettingsManager* SessionSettings = GetWorld()->GetSubsystem<USessionSettingsManager>();
 		UResourceRouletteUtility::UpdateValidResourceClasses(SessionSettings);
 		UResourceRouletteUtility::UpdateNonGroupableResources(SessionSettings);
+		// Get the node assets streaming in while we scan and randomize
+		ResourceNodeSpawner->PreloadResourceAssets(World);
 	}
 	// Don't repeat this on reroll
 	if (!bReroll && !bIsResourcesScanned)
 	{
 		InitMeshesToDestroy();
+		SettleCache.LoadForWorld(World);
 
 		// Here we can add classnames/tags for mods we want to have compatible with our mod
 		// Buildable Resource Nodes Redux
@@ -100,6 +184,7 @@ void UResourceRouletteManager::ScanWorldResourceNodes(UWorld* World, bool bRerol
 		RegisteredTags = ResourceRouletteCompatibilityManager::GetRegisteredTags();
 		ResourceRouletteCompatibilityManager::TagExistingActors(World);
 		ResourceRouletteCompatibilityManager::SetupActorSpawnCallback(World);
+		RegisterMeshSuppressionHooks(World);
 	}
 
 	if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World))
@@ -107,16 +192,9 @@ void UResourceRouletteManager::ScanWorldResourceNodes(UWorld* World, bool bRerol
 		// If we have previously randomized nodes in this save and now we should re-roll
 		if (ResourceRouletteSubsystem->GetSessionAlreadySpawned() && bReroll && !bIsResourcesScanned)
 		{
-			// ResourceCollectionManager->SetCollectedResourcesNodes(ResourceRouletteSubsystem->GetOriginalResourceNodes());
-			// Here reset the raycast for all the nodes before passing it, to ensure that we resettle them properly.
-			TArray<FResourceNodeData> OriginalNodes = ResourceRouletteSubsystem->GetOriginalResourceNodes();
-
-			for (FResourceNodeData& NodeData : OriginalNodes)
-			{
-				NodeData.IsRayCasted = false;
-			}
-			ResourceCollectionManager->SetCollectedResourcesNodes(OriginalNodes);
-			ResourcePurityManager->CollectOriginalPurities(OriginalNodes);
+			// The randomizer reads the original nodes straight from the subsystem and clears the raycast flag on
+			// what it hands back, so they all get resettled
+			ResourcePurityManager->CollectOriginalPurities(ResourceRouletteSubsystem->GetOriginalResourceNodes());
 			// Destroy both vanilla actors and our own nodes!
 			for (TActorIterator<AFGResourceNode> It(World); It; ++It)
 			{
@@ -168,17 +246,13 @@ void UResourceRouletteManager::ScanWorldResourceNodes(UWorld* World, bool bRerol
 			if (ResourceRouletteSubsystem->GetOriginalResourceNodes().IsEmpty())
 			{
 				ResourceCollectionManager->CollectWorldResources(World);
-				const TArray<FResourceNodeData>& NewResourceNodes = ResourceCollectionManager->
-					GetCollectedResourceNodes();
-				ResourceRouletteSubsystem->SetOriginalResourceNodes(NewResourceNodes);
-				ResourcePurityManager->CollectOriginalPurities(NewResourceNodes);
+				ResourceRouletteSubsystem->SetOriginalResourceNodes(
+					ResourceCollectionManager->TakeCollectedResourceNodes());
+				ResourcePurityManager->CollectOriginalPurities(ResourceRouletteSubsystem->GetOriginalResourceNodes());
 				FResourceRouletteUtilityLog::Get().LogMessage("Cached new Original Resource node data.",
 				                                              ELogLevel::Debug);
 			}
 
-			ResourceCollectionManager->SetCollectedResourcesNodes(
-				ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes());
-
 			// Destroy the actors!
 			for (TActorIterator<AFGResourceNode> It(World); It; ++It)
 			{
@@ -243,7 +317,7 @@ void UResourceRouletteManager::ScanWorldResourceNodes(UWorld* World, bool bRerol
 		{
 			ResourcePurityManager->CollectWorldPurities(World);
 			ResourceCollectionManager->CollectWorldResources(World);
-			ResourceRouletteSubsystem->SetOriginalResourceNodes(ResourceCollectionManager->GetCollectedResourceNodes());
+			ResourceRouletteSubsystem->SetOriginalResourceNodes(ResourceCollectionManager->TakeCollectedResourceNodes());
 			bIsResourcesScanned = true;
 			FResourceRouletteUtilityLog::Get().LogMessage("Resource Scan completed successfully.", ELogLevel::Debug);
 		}
@@ -282,8 +356,7 @@ void UResourceRouletteManager::RandomizeWorldResourceNodes(UWorld* World, bool b
 	}
 	if (bIsResourcesScanned && !bIsResourcesRandomized)
 	{
-		ResourceNodeRandomizer->RandomizeWorldResources(World, ResourceCollectionManager, ResourcePurityManager,
-		                                                SeedManager);
+		ResourceNodeRandomizer->RandomizeWorldResources(World, ResourcePurityManager, SeedManager);
 		bIsResourcesRandomized = true;
 		FResourceRouletteUtilityLog::Get().LogMessage("Resource Randomization completed successfully.",
 		                                              ELogLevel::Debug);
@@ -296,8 +369,7 @@ void UResourceRouletteManager::RandomizeWorldResourceNodes(UWorld* World, bool b
 
 /// Manager method to spawn all the resource nodes needed
 /// @param World world context
-/// @param IsFromSaved is it from a save or randomizer?
-void UResourceRouletteManager::SpawnWorldResourceNodes(UWorld* World, bool IsFromSaved)
+void UResourceRouletteManager::SpawnWorldResourceNodes(UWorld* World)
 {
 	RR_PROFILE();
 	if (!World)
@@ -306,32 +378,579 @@ void UResourceRouletteManager::SpawnWorldResourceNodes(UWorld* World, bool IsFro
 		                                              ELogLevel::Error);
 		return;
 	}
-	if (bIsResourcesScanned && bIsResourcesRandomized && !bIsResourcesSpawned)
+	if (bIsResourcesScanned && bIsResourcesRandomized && !bIsResourcesSpawned && !ResourceNodeSpawner->IsSpawning())
 	{
-		ResourceNodeSpawner->SpawnWorldResources(World, ResourceNodeRandomizer, IsFromSaved);
+		// Nodes on locations settled in an earlier session spawn already settled and never get traced
 		if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World))
 		{
-			const TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->
-				GetSessionRandomizedResourceNodes();
-			UResourceRouletteUtility::AssociateExtractorsWithNodes(World, ProcessedNodes,
-			                                                       ResourceNodeSpawner->GetSpawnedResourceNodes());
+			int32 NumFromCache = 0;
+			for (FResourceNodeData& NodeData : ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes())
+			{
+				if (!NodeData.IsRayCasted && NodeData.ResourceForm != EResourceForm::RF_LIQUID &&
+					SettleCache.Apply(NodeData))
+				{
+					NumFromCache++;
+				}
+			}
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Settled %d nodes from the settle cache"), NumFromCache), ELogLevel::Debug);
 		}
 
+		// Spawning runs over several frames, everything that needs the nodes waits for the callback
+		ResourceNodeSpawner->SetInstancedRocksRequired(CVarNodeActivationRadius.GetValueOnGameThread() > 0);
+		ResourceNodeSpawner->SpawnWorldResources(
+			World, FOnResourceSpawningComplete::CreateUObject(this, &UResourceRouletteManager::OnResourceNodesSpawned));
+	}
+	else
+	{
+		// FResourceRouletteUtilityLog::Get().LogMessage("Spawning Skipped.", ELogLevel::Debug);
+	}
+}
+
+/// Called by the spawner once the last node is in the world
+void UResourceRouletteManager::OnResourceNodesSpawned()
+{
+	RR_PROFILE();
+	UWorld* World = GetWorld();
+	if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World))
+	{
+		const TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->
+			GetSessionRandomizedResourceNodes();
+		UResourceRouletteUtility::AssociateExtractorsWithNodes(World, ProcessedNodes,
+		                                                       ResourceNodeSpawner->GetSpawnedResourceNodes());
+		RebuildNodeTable(ProcessedNodes);
 		bIsResourcesSpawned = true;
 		FResourceRouletteUtilityLog::Get().LogMessage("Resources Spawning completed successfully.", ELogLevel::Debug);
+		ResourceRouletteSubsystem->OnResourceNodesSpawned();
+	}
+}
+
+/// Stops any batched spawning still running, e.g. when the world is going away
+void UResourceRouletteManager::CancelSpawning()
+{
+	if (ResourceNodeSpawner)
+	{
+		ResourceNodeSpawner->CancelSpawning();
+	}
+}
+
+/// Writes any settle results not on disk yet. Only called when the game saves and when the world goes away, never
+/// from the update passes, so the file write doesn't land in the middle of gameplay
+void UResourceRouletteManager::SaveSettleCache()
+{
+	SettleCache.Save();
+}
+
+/// Copies the hot fields of every session node into the node table
+/// @param ProcessedNodes The subsystem's session nodes
+void UResourceRouletteManager::RebuildNodeTable(const TArray<FResourceNodeData>& ProcessedNodes)
+{
+	RR_PROFILE();
+	NodeTable.Reset(ProcessedNodes.Num());
+	for (const FResourceNodeData& NodeData : ProcessedNodes)
+	{
+		// We shouldn't really raycast oil nodes since they're decals, so they count as settled from the start
+		NodeTable.Add({NodeData.Location.X, NodeData.Location.Y, NodeData.Location.Z},
+		              NodeData.IsRayCasted || NodeData.ResourceForm == EResourceForm::RF_LIQUID);
+	}
+}
+
+/// Where every player with a pawn is. On a dedicated server player 0 is nobody in particular, so all of them
+/// count
+/// @param World World context
+/// @param OutLocations Cleared and filled with the pawn locations
+void UResourceRouletteManager::GetPlayerLocations(const UWorld* World, TArray<FVector>& OutLocations) const
+{
+	OutLocations.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->GetPawn())
+		{
+			OutLocations.Add(PlayerController->GetPawn()->GetActorLocation());
+		}
+	}
+}
+
+/// Sweeps the node table once for nodes within NodeUpdateRadius of any player that haven't been settled yet
+/// @param ProcessedNodes The subsystem's session nodes, the table gets rebuilt if it doesn't match them
+/// @param PlayerLocations Where the players are
+/// @param OutNodeIndexes Indexes into ProcessedNodes, nearest to a player first
+void UResourceRouletteManager::FindNodesToSettle(const TArray<FResourceNodeData>& ProcessedNodes,
+                                                 const TArray<FVector>& PlayerLocations,
+                                                 TArray<int32>& OutNodeIndexes)
+{
+	RR_PROFILE();
+	if (NodeTable.Num() != ProcessedNodes.Num())
+	{
+		RebuildNodeTable(ProcessedNodes);
+	}
+	std::vector<int32_t> NodeIndexes;
+	NodeTable.QueryUnsettledNearCenters(ToCoreLocations(PlayerLocations), NodeUpdateRadius, NodeIndexes);
+	OutNodeIndexes = TArray<int32>(NodeIndexes.data(), static_cast<int32>(NodeIndexes.size()));
+}
+
+/// Settles a node onto the terrain if it's close enough to the player and hasn't been raycast yet. With async
+/// settling this only queues the traces and the node gets updated a few frames later
+/// @param ProcessedNodes Session nodes, the node is updated in place when settling synchronously
+/// @param NodeIndex Node to settle, usually from FindNodesToSettle
+/// @param World World context
+/// @param PlayerLocations Where the players are
+/// @return true if the node moved or was queued
+bool UResourceRouletteManager::SettleNodeNearPlayer(TArray<FResourceNodeData>& ProcessedNodes, const int32 NodeIndex,
+                                                    UWorld* World, const TArray<FVector>& PlayerLocations)
+{
+	if (!ProcessedNodes.IsValidIndex(NodeIndex))
+	{
+		return false;
+	}
+	FResourceNodeData& NodeData = ProcessedNodes[NodeIndex];
+	if (NodeData.ResourceForm == EResourceForm::RF_LIQUID)
+	{
+		return false;
+	}
+	if (NodeData.IsRayCasted)
+	{
+		// The table went stale, e.g. the subsystem's nodes were swapped for ones that are already settled
+		if (NodeIndex < NodeTable.Num())
+		{
+			NodeTable.MarkSettled(NodeIndex, NodeData.Location.Z);
+		}
+		return false;
+	}
+	if (!Algo::AnyOf(PlayerLocations, [&NodeData](const FVector& PlayerLocation)
+	{
+		return FVector::DistSquared(NodeData.Location, PlayerLocation) <= FMath::Square(NodeUpdateRadius);
+	}))
+	{
+		return false;
+	}
+	AFGResourceNode* ResourceNode = ResourceNodeSpawner->GetSpawnedResourceNodes().FindRef(NodeData.NodeGUID);
+	if (!ResourceNode)
+	{
+		return false;
+	}
+
+	if (CVarAsyncNodeSettling.GetValueOnGameThread() != 0)
+	{
+		if (IsSettlePending(NodeData.NodeGUID))
+		{
+			return false;
+		}
+		QueueNodeSettle(NodeIndex, NodeData, World, ResourceNode);
+		return true;
+	}
+
+	const FVector CandidateLocation = NodeData.Location;
+	if (!UResourceRouletteUtility::CalculateLocationAndRotationForNode(
+		NodeData, World, ResourceNode, ResourceNodeSpawner->GetNodeMeshInstances(NodeData.NodeGUID)))
+	{
+		return false;
+	}
+	SettleCache.Add(CandidateLocation, NodeData);
+	if (NodeIndex < NodeTable.Num())
+	{
+		NodeTable.MarkSettled(NodeIndex, NodeData.Location.Z);
+	}
+	ApplySettledTransform(NodeData, ResourceNode);
+	WorldUpdatePass.NumNodesSettled++;
+	return true;
+}
+
+/// Moves the spawned node's mesh, or its rock instance, and collision to where settling put it
+/// @param NodeData Settled node data
+/// @param ResourceNode Spawned node
+void UResourceRouletteManager::ApplySettledTransform(const FResourceNodeData& NodeData,
+                                                     const AFGResourceNode* ResourceNode) const
+{
+	// ResourceNode->SetActorLocation(NodeData.Location,false, nullptr, ETeleportType::TeleportPhysics);
+	// ResourceNode->SetActorRotation(NodeData.Rotation, ETeleportType::TeleportPhysics);
+
+	// Instanced rocks are moved by the spawner, otherwise the node has its own mesh
+	if (!ResourceNodeSpawner->UpdateNodeMeshInstance(NodeData))
+	{
+		if (UStaticMeshComponent* MeshComponent = ResourceNode->FindComponentByClass<UStaticMeshComponent>())
+		{
+			// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Updating MeshComponent Location to: %s, Rotation to: %s"),
+			// 	*NodeData.Location.ToString(), *NodeData.Rotation.ToString()),	ELogLevel::Debug);
+			FVector CorrectedLocation = NodeData.Location + NodeData.Offset;
+			MeshComponent->SetWorldLocation(CorrectedLocation, false, nullptr, ETeleportType::TeleportPhysics);
+			// MeshComponent->SetWorldLocation(NodeData.Location, false, nullptr, ETeleportType::TeleportPhysics);
+			MeshComponent->SetWorldRotation(NodeData.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		}
+	}
+	if (UBoxComponent* CollisionBox = ResourceNode->FindComponentByClass<UBoxComponent>())
+	{
+		CollisionBox->SetWorldLocation(NodeData.Location, false, nullptr, ETeleportType::TeleportPhysics);
+		CollisionBox->SetWorldRotation(NodeData.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+}
+
+bool UResourceRouletteManager::IsSettleQueueFull() const
+{
+	return CVarAsyncNodeSettling.GetValueOnGameThread() != 0 &&
+		PendingSettles.Num() >= FMath::Max(CVarMaxPendingSettles.GetValueOnGameThread(), 1);
+}
+
+bool UResourceRouletteManager::IsSettlePending(const FGuid& NodeGUID) const
+{
+	for (const TPair<uint32, FPendingNodeSettle>& PendingSettle : PendingSettles)
+	{
+		if (PendingSettle.Value.NodeGUID == NodeGUID)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Fires off the first settle traces for a node, OnSettleTraceDone collects them as they come back
+/// @param NodeIndex Index of the node in the session nodes
+/// @param NodeData Node to settle
+/// @param World World context
+/// @param ResourceNode Spawned node, ignored by the traces
+void UResourceRouletteManager::QueueNodeSettle(const int32 NodeIndex, const FResourceNodeData& NodeData,
+                                               UWorld* World, const AFGResourceNode* ResourceNode)
+{
+	const uint32 SettleId = NextSettleId++;
+	FPendingNodeSettle& PendingSettle = PendingSettles.Add(SettleId);
+	PendingSettle.NodeGUID = NodeData.NodeGUID;
+	PendingSettle.NodeIndex = NodeIndex;
+	PendingSettle.NodeLocation = NodeData.Location;
+	PendingSettle.HitPoints.Reserve(UResourceRouletteUtility::GetNumSettleTraces());
+	FireSettleTraces(SettleId, PendingSettle, World, ResourceNode,
+	                 UResourceRouletteUtility::GetNumInitialSettleTraces());
+}
+
+/// Fires the next NumTraces settle traces of a node that haven't gone out yet
+/// @param SettleId Key of the pending settle, comes back in the trace UserData
+/// @param PendingSettle The pending settle
+/// @param World World context
+/// @param ResourceNode Spawned node, ignored by the traces
+/// @param NumTraces How many more to fire
+void UResourceRouletteManager::FireSettleTraces(const uint32 SettleId, FPendingNodeSettle& PendingSettle,
+                                                UWorld* World, const AFGResourceNode* ResourceNode,
+                                                const int32 NumTraces) const
+{
+	TArray<TPair<FVector, FVector>> Segments;
+	UResourceRouletteUtility::GetSettleTraceSegments(PendingSettle.NodeLocation, Segments);
+	const FCollisionQueryParams QueryParams = UResourceRouletteUtility::GetSettleQueryParams(
+		ResourceNode, ResourceNodeSpawner->GetNodeMeshInstances(PendingSettle.NodeGUID));
+
+	const int32 EndIndex = FMath::Min(Segments.Num(), PendingSettle.NumTracesFired + NumTraces);
+	for (int32 i = PendingSettle.NumTracesFired; i < EndIndex; ++i)
+	{
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Multi, Segments[i].Key, Segments[i].Value, ECC_WorldStatic,
+		                               QueryParams, FCollisionResponseParams::DefaultResponseParam,
+		                               &SettleTraceDelegate, SettleId);
+	}
+	PendingSettle.NumTracesLeft += EndIndex - PendingSettle.NumTracesFired;
+	PendingSettle.NumTracesFired = EndIndex;
+}
+
+/// Async trace callback, runs on the game thread the frame after the trace was queued
+/// @param TraceHandle Unused
+/// @param TraceDatum Hits and the settle id in UserData
+void UResourceRouletteManager::OnSettleTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	// Missing after a reroll cleared the queue
+	FPendingNodeSettle* PendingSettle = PendingSettles.Find(TraceDatum.UserData);
+	if (!PendingSettle)
+	{
+		return;
+	}
+	FVector HitPoint;
+	if (UResourceRouletteUtility::FindSettleHitPoint(TraceDatum.OutHits, HitPoint))
+	{
+		PendingSettle->HitPoints.Add(HitPoint);
+	}
+	PendingSettle->NumTracesLeft--;
+}
+
+/// Fits planes for every node whose traces are all back and moves them. Nodes whose first round of traces landed
+/// on uneven ground get the rest of the disk fired and stay pending
+/// @param World World context
+void UResourceRouletteManager::ApplyCompletedSettles(UWorld* World)
+{
+	TArray<FPendingNodeSettle> CompletedSettles;
+	for (auto It = PendingSettles.CreateIterator(); It; ++It)
+	{
+		FPendingNodeSettle& PendingSettle = It->Value;
+		if (PendingSettle.NumTracesLeft > 0)
+		{
+			continue;
+		}
+		if (PendingSettle.NumTracesFired < UResourceRouletteUtility::GetNumSettleTraces() &&
+			UResourceRouletteUtility::NeedsMoreSettleTraces(PendingSettle.HitPoints, PendingSettle.PlaneNormal))
+		{
+			if (const AFGResourceNode* ResourceNode = ResourceNodeSpawner->GetSpawnedResourceNodes().FindRef(
+				PendingSettle.NodeGUID))
+			{
+				PendingSettle.PlaneNormal.Reset();
+				FireSettleTraces(It->Key, PendingSettle, World, ResourceNode, MAX_int32);
+				continue;
+			}
+		}
+		CompletedSettles.Add(MoveTemp(PendingSettle));
+		It.RemoveCurrent();
+	}
+	if (CompletedSettles.IsEmpty())
+	{
+		return;
+	}
+	RR_PROFILE();
+
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
+	if (!ResourceRouletteSubsystem)
+	{
+		return;
+	}
+
+	// Straight to each node by index, so this costs the number of completed settles rather than the node count.
+	// Nodes that don't get enough hits stay un-raycast and get another go on a later pass
+	TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+	const TMap<FGuid, AFGResourceNode*>& SpawnedResourceNodes = ResourceNodeSpawner->GetSpawnedResourceNodes();
+	for (const FPendingNodeSettle& CompletedSettle : CompletedSettles)
+	{
+		const int32 NodeIndex = CompletedSettle.NodeIndex;
+		if (!ProcessedNodes.IsValidIndex(NodeIndex) || ProcessedNodes[NodeIndex].NodeGUID != CompletedSettle.NodeGUID)
+		{
+			continue;
+		}
+		FResourceNodeData& NodeData = ProcessedNodes[NodeIndex];
+		if (NodeData.IsRayCasted)
+		{
+			continue;
+		}
+		UResourceRouletteUtility::RecordSettleTraces(NodeData, CompletedSettle.NumTracesFired);
+		const AFGResourceNode* ResourceNode = SpawnedResourceNodes.FindRef(NodeData.NodeGUID);
+		if (ResourceNode && UResourceRouletteUtility::ApplySettleHitPoints(NodeData, CompletedSettle.HitPoints,
+		                                                                  CompletedSettle.PlaneNormal.GetPtrOrNull()))
+		{
+			SettleCache.Add(CompletedSettle.NodeLocation, NodeData);
+			if (NodeIndex < NodeTable.Num())
+			{
+				NodeTable.MarkSettled(NodeIndex, NodeData.Location.Z);
+			}
+			ApplySettledTransform(NodeData, ResourceNode);
+			WorldUpdatePass.NumNodesSettled++;
+		}
+	}
+}
+
+/// Passes the nodes that moved since the last flush on to whatever mirrors their locations, only those nodes
+/// get looked at. Does nothing when nothing settled
+/// @param World World context
+void UResourceRouletteManager::FlushDirtyNodes(UWorld* World)
+{
+	if (!NodeTable.HasDirty())
+	{
+		return;
+	}
+	RR_PROFILE();
+	std::vector<int32_t> DirtyIndexes;
+	NodeTable.TakeDirtyIndexes(DirtyIndexes);
+
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
+	if (!ResourceRouletteSubsystem)
+	{
+		return;
+	}
+	const TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+	const TMap<FGuid, AFGResourceNode*>& SpawnedResourceNodes = ResourceNodeSpawner->GetSpawnedResourceNodes();
+	TMap<const AFGResourceNodeBase*, FVector> MovedNodes;
+	MovedNodes.Reserve(DirtyIndexes.size());
+	for (const int32 NodeIndex : DirtyIndexes)
+	{
+		if (!ProcessedNodes.IsValidIndex(NodeIndex))
+		{
+			continue;
+		}
+		const FResourceNodeData& NodeData = ProcessedNodes[NodeIndex];
+		if (const AFGResourceNode* ResourceNode = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
+		{
+			MovedNodes.Add(ResourceNode, NodeData.Location);
+		}
+	}
+	UResourceRouletteUtility::ScannerUpdateNodeClusters(World, MovedNodes);
+}
+
+/// Switches solid nodes between full and proxy as players move. Near a player a node has its collision box and
+/// something to stand on like it always had, far from all of them the spawner unregisters both and only an
+/// instance of the rock is left to draw it. The proxy is pooled rather than despawned: the actor with just its root and
+/// resource data stays, since extractors, portable miners, scanner clusters and the map point at it and would
+/// have to be rewired on every switch. See UResourceNodeSpawner::SetNodeCollision
+/// @param PlayerLocations Where the players are, with none nothing changes
+/// @param ProcessedNodes The subsystem's session nodes
+void UResourceRouletteManager::UpdateNodeActivation(const TArray<FVector>& PlayerLocations,
+                                                    const TArray<FResourceNodeData>& ProcessedNodes)
+{
+	RR_PROFILE();
+	if (NodeTable.Num() != ProcessedNodes.Num())
+	{
+		RebuildNodeTable(ProcessedNodes);
+	}
+
+	std::vector<int32_t> ActivatedIndexes;
+	std::vector<int32_t> DeactivatedIndexes;
+	const int32 ActivationRadius = CVarNodeActivationRadius.GetValueOnGameThread();
+	if (ActivationRadius <= 0)
+	{
+		if (NodeTable.NumActive() == NodeTable.Num())
+		{
+			return;
+		}
+		NodeTable.ActivateAll(ActivatedIndexes);
 	}
 	else
 	{
-		// FResourceRouletteUtilityLog::Get().LogMessage("Spawning Skipped.", ELogLevel::Debug);
+		// Every player counts, a node near any of them stays active
+		if (PlayerLocations.IsEmpty())
+		{
+			return;
+		}
+		const int32 DeactivationRadius = ActivationRadius + FMath::Max(
+			CVarNodeActivationHysteresis.GetValueOnGameThread(), 0);
+		NodeTable.UpdateActiveNodes(ToCoreLocations(PlayerLocations), ActivationRadius, DeactivationRadius,
+		                            ActivatedIndexes, DeactivatedIndexes);
+	}
+	if (ActivatedIndexes.empty() && DeactivatedIndexes.empty())
+	{
+		return;
+	}
+
+	const TMap<FGuid, AFGResourceNode*>& SpawnedResourceNodes = ResourceNodeSpawner->GetSpawnedResourceNodes();
+	auto SetNodesActive = [&](const std::vector<int32_t>& NodeIndexes, const bool bActive)
+	{
+		for (const int32 NodeIndex : NodeIndexes)
+		{
+			if (!ProcessedNodes.IsValidIndex(NodeIndex))
+			{
+				continue;
+			}
+			const FResourceNodeData& NodeData = ProcessedNodes[NodeIndex];
+			if (NodeData.ResourceForm == EResourceForm::RF_LIQUID)
+			{
+				continue;
+			}
+			if (AFGResourceNode* ResourceNode = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
+			{
+				ResourceNodeSpawner->SetNodeCollision(ResourceNode, NodeData, bActive);
+			}
+		}
+	};
+	SetNodesActive(DeactivatedIndexes, false);
+	SetNodesActive(ActivatedIndexes, true);
+
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Node activation: %d switched on, %d switched off, %d active, %d proxies"),
+		                static_cast<int32>(ActivatedIndexes.size()), static_cast<int32>(DeactivatedIndexes.size()),
+		                NodeTable.NumActive(), NodeTable.Num() - NodeTable.NumActive()), ELogLevel::Debug);
+}
+
+/// Logs how many nodes are full and how many are proxies, with what each kind costs in components, physics bodies
+/// and memory. The bytes are the component objects plus what they report themselves (body instances, mesh
+/// render data they own), enough to compare the two tiers rather than an exact footprint
+/// @param World World context
+void UResourceRouletteManager::LogNodeActivation(const UWorld* World) const
+{
+	struct FNodeTierStats
+	{
+		int32 NumNodes = 0;
+		int32 NumComponents = 0;
+		int32 NumWithCollision = 0;
+		int32 NumPhysicsBodies = 0;
+		SIZE_T NumBytes = 0;
+	};
+	FNodeTierStats FullStats;
+	FNodeTierStats ProxyStats;
+	for (const TPair<FGuid, AFGResourceNode*>& SpawnedNode : ResourceNodeSpawner->GetSpawnedResourceNodes())
+	{
+		if (!IsValid(SpawnedNode.Value) || SpawnedNode.Value->GetWorld() != World)
+		{
+			continue;
+		}
+		FNodeTierStats NodeStats;
+		TInlineComponentArray<UActorComponent*> Components;
+		SpawnedNode.Value->GetComponents(Components);
+		for (UActorComponent* Component : Components)
+		{
+			NodeStats.NumComponents++;
+			NodeStats.NumBytes += Component->GetClass()->GetStructureSize() +
+				Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+			const UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component);
+			if (PrimitiveComponent && PrimitiveComponent->IsRegistered() && PrimitiveComponent->IsCollisionEnabled())
+			{
+				NodeStats.NumWithCollision++;
+				const FBodyInstance* BodyInstance = PrimitiveComponent->GetBodyInstance();
+				NodeStats.NumPhysicsBodies += BodyInstance && BodyInstance->IsValidBodyInstance() ? 1 : 0;
+			}
+		}
+
+		FNodeTierStats& TierStats = NodeStats.NumWithCollision > 0 ? FullStats : ProxyStats;
+		TierStats.NumNodes++;
+		TierStats.NumComponents += NodeStats.NumComponents;
+		TierStats.NumWithCollision += NodeStats.NumWithCollision;
+		TierStats.NumPhysicsBodies += NodeStats.NumPhysicsBodies;
+		TierStats.NumBytes += NodeStats.NumBytes;
 	}
+
+	FResourceRouletteUtilityLog& Log = FResourceRouletteUtilityLog::Get();
+	Log.LogReport(FString::Printf(TEXT("Node activation: %d active, %d proxies in the node table"),
+	                              NodeTable.NumActive(), NodeTable.Num() - NodeTable.NumActive()));
+	auto LogTier = [&Log](const TCHAR* TierName, const FNodeTierStats& TierStats)
+	{
+		const int32 NumNodes = FMath::Max(TierStats.NumNodes, 1);
+		Log.LogReport(FString::Printf(
+			TEXT("  %-6s %6d nodes, %7d components (%.1f per node), %6d with collision, %6d physics bodies, "
+			     "%.1f KB (%.0f bytes per node)"),
+			TierName, TierStats.NumNodes, TierStats.NumComponents,
+			static_cast<double>(TierStats.NumComponents) / NumNodes, TierStats.NumWithCollision,
+			TierStats.NumPhysicsBodies, TierStats.NumBytes / 1024.0,
+			static_cast<double>(TierStats.NumBytes) / NumNodes));
+	};
+	// Liquid nodes are never proxies and land under full
+	LogTier(TEXT("Full"), FullStats);
+	LogTier(TEXT("Proxy"), ProxyStats);
+}
+
+/// Vanilla node meshes that aren't ours or tagged by a compatible mod get destroyed
+/// @param StaticMeshComponent Mesh component to check
+/// @return true if it should go
+bool UResourceRouletteManager::ShouldDestroyMeshComponent(const UStaticMeshComponent* StaticMeshComponent) const
+{
+	// Cheapest check first, almost nothing in the world uses one of these meshes
+	if (!StaticMeshComponent || !MeshAssetsToDestroy.Contains(StaticMeshComponent->GetStaticMesh()))
+	{
+		return false;
+	}
+	for (const FName& Tag : StaticMeshComponent->ComponentTags)
+	{
+		if (RegisteredTags.Contains(Tag) || Tag == ResourceRouletteTag)
+		{
+			return false;
+		}
+	}
+	if (const AActor* Owner = StaticMeshComponent->GetOwner())
+	{
+		for (const FName& Tag : Owner->Tags)
+		{
+			if (RegisteredTags.Contains(Tag) || Tag == ResourceRouletteTag)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
 }
 
 /// For now, this destroys any meshes that aren't explicity marked as our randomized meshes
 /// It also updates the locations of resource nodes based on raycasting if they haven't
 /// been raycast before
 /// Destroying any vanilla meshes on udpate may not be necessary, but requires more playtesting
+/// With a frame budget set this only kicks off a new pass, TickWorldResourceNodes does the work
 /// @param World 
-void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) const
+void UResourceRouletteManager::UpdateWorldResourceNodes(UWorld* World)
 {
 	RR_PROFILE();
 	if (!World)
@@ -349,22 +968,13 @@ void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) con
 
 	// double StartTotalTime = FPlatformTime::Seconds();
 
-	FVector PlayerLocation;
-	APlayerController* PlayerController = UGameplayStatics::GetPlayerController(World, 0);
-	if (PlayerController && PlayerController->GetPawn())
-	{
-		PlayerLocation = PlayerController->GetPawn()->GetActorLocation();
-	}
-	else
+	TArray<FVector> PlayerLocations;
+	GetPlayerLocations(World, PlayerLocations);
+	if (PlayerLocations.IsEmpty())
 	{
 		return;
 	}
 
-	// Search 250m (about 31 foundations) around player to update nodes
-	// TODO: Need to test on lower graphical settings to see if this fails
-	// Maybe it needs to be reduced based on graphics values?
-	const float UpdateRadius = 25000.0f;
-
 	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
 	if (!ResourceRouletteSubsystem)
 	{
@@ -372,65 +982,56 @@ void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) con
 		return;
 	}
 
-	TArray<FResourceNodeData> ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+	UpdateNodeActivation(PlayerLocations, ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes());
+
+	if (CVarUpdateBudgetMicroseconds.GetValueOnGameThread() > 0)
+	{
+		// Let a running pass finish before starting over, otherwise a slow pass would never reach the meshes
+		if (WorldUpdatePass.Phase == FResourceWorldUpdatePass::EPhase::Idle)
+		{
+			WorldUpdatePass = FResourceWorldUpdatePass();
+			WorldUpdatePass.Phase = FResourceWorldUpdatePass::EPhase::Nodes;
+			FindNodesToSettle(ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes(), PlayerLocations,
+			                  WorldUpdatePass.NodeIndexes);
+			WorldUpdatePass.PlayerLocations = MoveTemp(PlayerLocations);
+		}
+		return;
+	}
+	WorldUpdatePass = FResourceWorldUpdatePass();
+
+	// Settled in place, no copy of the session nodes to write back
+	TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
 
 
 	// double StartNodeUpdatingTime = FPlatformTime::Seconds();
 
 	// Somehow this takes <1ms to run normally, even when we're updating and raycasting things
 	// I have no idea how, but this is some dark magic UE must be running behind the scenes
-	bool bNodeUpdated = false;
-	for (FResourceNodeData& NodeData : ProcessedNodes)
+	TArray<int32> NodeIndexes;
+	FindNodesToSettle(ProcessedNodes, PlayerLocations, NodeIndexes);
+	const int32 MaxSettlesPerTick = CVarMaxSettlesPerTick.GetValueOnGameThread();
+	int32 NumSettlesStarted = 0;
+	for (const int32 NodeIndex : NodeIndexes)
 	{
-		if (NodeData.ResourceForm == EResourceForm::RF_LIQUID)
+		// The rest get picked up on the next update, nearest ones first
+		if (IsSettleQueueFull() || (MaxSettlesPerTick > 0 && NumSettlesStarted >= MaxSettlesPerTick))
 		{
-			// We shouldn't really raycast oil nodes since they're decals...
-			continue;
-		}
-		if (!NodeData.IsRayCasted && FVector::Dist(NodeData.Location, PlayerLocation) <= UpdateRadius)
-		{
-			if (AFGResourceNode** ResourceNodePtr = ResourceNodeSpawner->GetSpawnedResourceNodes().Find(
-				NodeData.NodeGUID))
-			{
-				AFGResourceNode* ResourceNode = *ResourceNodePtr;
-				if (UResourceRouletteUtility::CalculateLocationAndRotationForNode(NodeData, World, ResourceNode))
-				{
-					bNodeUpdated = true;
-					// ResourceNode->SetActorLocation(NodeData.Location,false, nullptr, ETeleportType::TeleportPhysics);
-					// ResourceNode->SetActorRotation(NodeData.Rotation, ETeleportType::TeleportPhysics);
-
-					if (UStaticMeshComponent* MeshComponent = ResourceNode->FindComponentByClass<
-						UStaticMeshComponent>())
-					{
-						// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Updating MeshComponent Location to: %s, Rotation to: %s"),
-						// 	*NodeData.Location.ToString(), *NodeData.Rotation.ToString()),	ELogLevel::Debug);
-						FVector CorrectedLocation = NodeData.Location + NodeData.Offset;
-						MeshComponent->SetWorldLocation(CorrectedLocation, false, nullptr,
-						                                ETeleportType::TeleportPhysics);
-						// MeshComponent->SetWorldLocation(NodeData.Location, false, nullptr, ETeleportType::TeleportPhysics);
-						MeshComponent->SetWorldRotation(NodeData.Rotation, false, nullptr,
-						                                ETeleportType::TeleportPhysics);
-					}
-					if (UBoxComponent* CollisionBox = ResourceNode->FindComponentByClass<UBoxComponent>())
-					{
-						CollisionBox->SetWorldLocation(NodeData.Location, false, nullptr,
-						                               ETeleportType::TeleportPhysics);
-						CollisionBox->SetWorldRotation(NodeData.Rotation, false, nullptr,
-						                               ETeleportType::TeleportPhysics);
-					}
-				}
-			}
+			break;
 		}
+		NumSettlesStarted += SettleNodeNearPlayer(ProcessedNodes, NodeIndex, World, PlayerLocations) ? 1 : 0;
 	}
-
-	if (bNodeUpdated)
-	{
-		ResourceRouletteSubsystem->SetSessionRandomizedResourceNodes(ProcessedNodes);
-	}
+	ResourceNodeSpawner->FlushNodeMeshInstanceMoves();
+	FlushDirtyNodes(World);
 
 	// double NodeUpdatingTime = (FPlatformTime::Seconds() - StartNodeUpdatingTime)*1000.0f;
 	// double StartMeshDestroyingTime = FPlatformTime::Seconds();
 
+	ProcessSuppressionChecks(World);
+	if (!IsComponentSweepNeeded())
+	{
+		return;
+	}
+
 	// This runs significantly faster
 	TArray<UStaticMeshComponent*> WorldMeshComponents;
 	for (TObjectIterator<UStaticMeshComponent> It; It; ++It)
@@ -445,41 +1046,11 @@ void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) con
 	TSet<UStaticMeshComponent*> ComponentsToDestroy;
 	ParallelFor(WorldMeshComponents.Num(), [&](int32 Index)
 	{
-		bool bIsTagged = false;
 		UStaticMeshComponent* StaticMeshComponent = WorldMeshComponents[Index];
-		if (StaticMeshComponent)
+		if (ShouldDestroyMeshComponent(StaticMeshComponent))
 		{
-			for (const FName& Tag : StaticMeshComponent->ComponentTags)
-			{
-				if (RegisteredTags.Contains(Tag) || Tag == ResourceRouletteTag)
-				{
-					bIsTagged = true;
-				}
-			}
-
-			if (AActor* Owner = StaticMeshComponent->GetOwner())
-			{
-				for (const FName& Tag : Owner->Tags)
-				{
-					if (RegisteredTags.Contains(Tag) || Tag == ResourceRouletteTag)
-					{
-						bIsTagged = true;
-					}
-				}
-			}
-
-			if (!bIsTagged)
-			{
-				if (const UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh())
-				{
-					FName MeshPath = FName(*StaticMesh->GetPathName());
-					if (MeshesToDestroy.Contains(MeshPath))
-					{
-						FScopeLock Lock(&CriticalSection);
-						ComponentsToDestroy.Add(StaticMeshComponent);
-					}
-				}
-			}
+			FScopeLock Lock(&CriticalSection);
+			ComponentsToDestroy.Add(StaticMeshComponent);
 		}
 	});
 
@@ -506,26 +1077,33 @@ void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) con
 		StaticMeshComponent->DestroyComponent();
 	}
 
-	TArray<UDecalComponent*> DecalComponents;
-
-	for (TObjectIterator<UDecalComponent> It; It; ++It)
+	// Decals are only there to be looked at, a headless server leaves them be
+	if (!UResourceRouletteUtility::IsHeadlessServer(World))
 	{
-		UDecalComponent* DecalComponent = *It;
-		if (DecalComponent && DecalComponent->GetWorld() == World)
+		TArray<UDecalComponent*> DecalComponents;
+
+		for (TObjectIterator<UDecalComponent> It; It; ++It)
 		{
-			DecalComponents.Add(DecalComponent);
+			UDecalComponent* DecalComponent = *It;
+			if (DecalComponent && DecalComponent->GetWorld() == World)
+			{
+				DecalComponents.Add(DecalComponent);
+			}
 		}
-	}
 
-	for (UDecalComponent* DecalComponent : DecalComponents)
-	{
-		if (DecalComponent && !DecalComponent->ComponentTags.Contains(ResourceRouletteTag))
+		for (UDecalComponent* DecalComponent : DecalComponents)
 		{
-			DecalComponent->SetVisibility(false);
-			DecalComponent->DestroyComponent();
+			if (DecalComponent && !DecalComponent->ComponentTags.Contains(ResourceRouletteTag))
+			{
+				DecalComponent->SetVisibility(false);
+				DecalComponent->DestroyComponent();
+			}
 		}
 	}
 
+	bInitialComponentSweepDone = true;
+	ProcessSuppressionChecks(World);
+
 	// double MeshDestroyingTime = (FPlatformTime::Seconds() - StartMeshDestroyingTime)*1000.0f;
 	// double TotalTime = (FPlatformTime::Seconds() - StartTotalTime)*1000.0f;
 	// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Node updating took: %f ms"), NodeUpdatingTime), ELogLevel::Debug);
@@ -533,11 +1111,136 @@ void UResourceRouletteManager::UpdateWorldResourceNodes(const UWorld* World) con
 	// FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Total execution time: %f ms"), TotalTime), ELogLevel::Debug);
 }
 
+/// Called every frame. Applies the settles whose traces came back and runs the time-sliced world update, then
+/// moves the rocks of everything that settled this frame in one batch
+/// @param World World context
+void UResourceRouletteManager::TickWorldResourceNodes(UWorld* World)
+{
+	if (!World)
+	{
+		return;
+	}
+	ProcessSuppressionChecks(World);
+	ApplyCompletedSettles(World);
+	TickWorldUpdatePass(World);
+	ResourceNodeSpawner->FlushNodeMeshInstanceMoves();
+}
+
+/// Works through the current time-sliced world update until the frame budget runs out, then leaves the cursor
+/// where it stopped for next frame. Does the same work as the one-shot UpdateWorldResourceNodes, just walks the
+/// object array by index instead of collecting components up front so it can resume
+/// @param World World context
+void UResourceRouletteManager::TickWorldUpdatePass(UWorld* World)
+{
+	if (WorldUpdatePass.Phase == FResourceWorldUpdatePass::EPhase::Idle)
+	{
+		return;
+	}
+	RR_PROFILE();
+
+	AResourceRouletteSubsystem* ResourceRouletteSubsystem = AResourceRouletteSubsystem::Get(World);
+	if (!ResourceRouletteSubsystem)
+	{
+		WorldUpdatePass = FResourceWorldUpdatePass();
+		return;
+	}
+
+	const int32 BudgetMicroseconds = FMath::Max(CVarUpdateBudgetMicroseconds.GetValueOnGameThread(), 1);
+	const uint64 DeadlineCycles = FPlatformTime::Cycles64() + static_cast<uint64>(
+		BudgetMicroseconds / (1000000.0 * FPlatformTime::GetSecondsPerCycle64()));
+	WorldUpdatePass.NumFrames++;
+	WorldUpdatePass.NumSettlesThisFrame = 0;
+
+	if (WorldUpdatePass.Phase == FResourceWorldUpdatePass::EPhase::Nodes)
+	{
+		// Settled in place, the array can be swapped out under us between frames so every index is re-checked
+		TArray<FResourceNodeData>& ProcessedNodes = ResourceRouletteSubsystem->GetSessionRandomizedResourceNodes();
+		const int32 MaxSettlesPerTick = CVarMaxSettlesPerTick.GetValueOnGameThread();
+		while (WorldUpdatePass.Cursor < WorldUpdatePass.NodeIndexes.Num())
+		{
+			// Wait for traces in flight to come back before queueing more, or for the next frame once this one
+			// started its share
+			if (IsSettleQueueFull() ||
+				(MaxSettlesPerTick > 0 && WorldUpdatePass.NumSettlesThisFrame >= MaxSettlesPerTick))
+			{
+				return;
+			}
+			WorldUpdatePass.NumSettlesThisFrame += SettleNodeNearPlayer(
+				ProcessedNodes, WorldUpdatePass.NodeIndexes[WorldUpdatePass.Cursor++], World,
+				WorldUpdatePass.PlayerLocations) ? 1 : 0;
+			if (FPlatformTime::Cycles64() >= DeadlineCycles)
+			{
+				return;
+			}
+		}
+		WorldUpdatePass.Phase = FResourceWorldUpdatePass::EPhase::Components;
+		WorldUpdatePass.Cursor = 0;
+	}
+
+	if (!IsComponentSweepNeeded())
+	{
+		WorldUpdatePass.Cursor = GUObjectArray.GetObjectArrayNum();
+	}
+
+	// Same walk TObjectIterator does, but by index so we can stop anywhere and pick it back up. Objects
+	// created behind the cursor (or in a slot it already passed) are missed here, the spawn and level hooks
+	// queue them and they get checked once the sweep is done
+	constexpr int32 ObjectsPerBudgetCheck = 256;
+	const bool bHeadless = UResourceRouletteUtility::IsHeadlessServer(World);
+	while (WorldUpdatePass.Cursor < GUObjectArray.GetObjectArrayNum())
+	{
+		for (int32 i = 0; i < ObjectsPerBudgetCheck && WorldUpdatePass.Cursor < GUObjectArray.GetObjectArrayNum(); ++i)
+		{
+			const FUObjectItem* ObjectItem = GUObjectArray.IndexToObject(WorldUpdatePass.Cursor++);
+			UObject* Object = ObjectItem ? static_cast<UObject*>(ObjectItem->Object) : nullptr;
+			if (!Object || ObjectItem->IsUnreachable() || !IsValid(Object) ||
+				Object->HasAnyFlags(RF_ClassDefaultObject))
+			{
+				continue;
+			}
+
+			if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Object))
+			{
+				if (StaticMeshComponent->GetWorld() == World && ShouldDestroyMeshComponent(StaticMeshComponent))
+				{
+					StaticMeshComponent->SetActive(false);
+					StaticMeshComponent->SetVisibility(false);
+					StaticMeshComponent->DestroyComponent();
+					WorldUpdatePass.NumComponentsDestroyed++;
+				}
+			}
+			else if (UDecalComponent* DecalComponent = Cast<UDecalComponent>(Object); DecalComponent && !bHeadless)
+			{
+				if (DecalComponent->GetWorld() == World && !DecalComponent->ComponentTags.Contains(ResourceRouletteTag))
+				{
+					DecalComponent->SetVisibility(false);
+					DecalComponent->DestroyComponent();
+					WorldUpdatePass.NumComponentsDestroyed++;
+				}
+			}
+		}
+		if (FPlatformTime::Cycles64() >= DeadlineCycles)
+		{
+			return;
+		}
+	}
+	bInitialComponentSweepDone = true;
+	ProcessSuppressionChecks(World);
+	FlushDirtyNodes(World);
+
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("World update pass finished over %d frames: %d nodes settled, %d components destroyed"),
+		                WorldUpdatePass.NumFrames, WorldUpdatePass.NumNodesSettled,
+		                WorldUpdatePass.NumComponentsDestroyed), ELogLevel::Debug);
+	WorldUpdatePass = FResourceWorldUpdatePass();
+}
+
 /// Creates the lsit of meshes to destroy in a faster/smaller array to see if it improves speed
 void UResourceRouletteManager::InitMeshesToDestroy()
 {
 	RR_PROFILE();
-	MeshesToDestroy.Empty();
+	// Only needed to resolve the meshes, the checks go by MeshAssetsToDestroy
+	TSet<FName> MeshesToDestroy;
 
 	// Add resource paths
 	const TMap<FName, FResourceRouletteAssetSolid>& SolidResourceInfoMap =
@@ -548,6 +1251,21 @@ void UResourceRouletteManager::InitMeshesToDestroy()
 		MeshesToDestroy.Add(FName(*Pair.Value.MeshPath));
 	}
 
+	MeshAssetsToDestroy.Empty();
+	for (const FName& MeshPath : MeshesToDestroy)
+	{
+		if (UStaticMesh* Mesh = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr,
+		                                                           *MeshPath.ToString())))
+		{
+			MeshAssetsToDestroy.Add(Mesh);
+		}
+		else
+		{
+			FResourceRouletteUtilityLog::Get().LogMessage(
+				FString::Printf(TEXT("Couldn't load mesh to destroy: %s"), *MeshPath.ToString()), ELogLevel::Warning);
+		}
+	}
+
 	// Add fracking resource paths
 	// const TMap<FName, FResourceRouletteAssetFracking>& FrackingResourceInfoMap = UResourceRouletteAssets::FrackingResourceInfoMap;
 	// for (const auto& Pair : FrackingResourceInfoMap)
@@ -559,6 +1277,143 @@ void UResourceRouletteManager::InitMeshesToDestroy()
 	// }
 }
 
+/// Hooks level streaming and actor spawning so new vanilla node meshes get caught as they show up
+/// @param World World context
+void UResourceRouletteManager::RegisterMeshSuppressionHooks(UWorld* World)
+{
+	if (!World || LevelAddedHandle.IsValid())
+	{
+		return;
+	}
+	HookedWorld = World;
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(
+		this, &UResourceRouletteManager::OnLevelAddedToWorld);
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &UResourceRouletteManager::OnActorSpawned));
+	FResourceRouletteUtilityLog::Get().LogMessage("Mesh suppression hooks registered.", ELogLevel::Debug);
+}
+
+void UResourceRouletteManager::UnregisterMeshSuppressionHooks()
+{
+	if (LevelAddedHandle.IsValid())
+	{
+		FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+		LevelAddedHandle.Reset();
+	}
+	if (UWorld* World = HookedWorld.Get(); World && ActorSpawnedHandle.IsValid())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	ActorSpawnedHandle.Reset();
+	HookedWorld.Reset();
+	PendingSuppressionChecks.Empty();
+}
+
+/// Full sweeps are only needed until the first one finishes, or always with event driven suppression off. A
+/// headless server never repeats them, the first one already took out the vanilla rocks' collision
+bool UResourceRouletteManager::IsComponentSweepNeeded() const
+{
+	return !bInitialComponentSweepDone || (CVarEventDrivenMeshSuppression.GetValueOnGameThread() == 0 &&
+		!UResourceRouletteUtility::IsHeadlessServer(GetWorld()));
+}
+
+void UResourceRouletteManager::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != HookedWorld.Get())
+	{
+		return;
+	}
+	for (const AActor* Actor : Level->Actors)
+	{
+		QueueSuppressionChecks(Actor);
+	}
+}
+
+void UResourceRouletteManager::OnActorSpawned(AActor* SpawnedActor)
+{
+	QueueSuppressionChecks(SpawnedActor);
+}
+
+/// Queues an actor's candidate components. They're checked on the next tick instead of inside the
+/// spawn so our spawner gets a chance to tag its own nodes first. Also queues during the initial sweep,
+/// a time-sliced sweep can't see anything that lands behind its cursor
+/// @param Actor Actor that just showed up
+void UResourceRouletteManager::QueueSuppressionChecks(const AActor* Actor)
+{
+	if (!Actor)
+	{
+		return;
+	}
+	Actor->ForEachComponent<UStaticMeshComponent>(false, [this](UStaticMeshComponent* StaticMeshComponent)
+	{
+		if (MeshAssetsToDestroy.Contains(StaticMeshComponent->GetStaticMesh()))
+		{
+			PendingSuppressionChecks.Add(StaticMeshComponent);
+		}
+	});
+	if (UResourceRouletteUtility::IsHeadlessServer(HookedWorld.Get()))
+	{
+		return;
+	}
+	Actor->ForEachComponent<UDecalComponent>(false, [this](UDecalComponent* DecalComponent)
+	{
+		PendingSuppressionChecks.Add(DecalComponent);
+	});
+}
+
+/// Destroys whatever queued components turned out to be vanilla node meshes or decals. Holds the queue
+/// until the initial sweep is done, whatever the sweep already destroyed drops out as a stale pointer
+/// @param World World context
+void UResourceRouletteManager::ProcessSuppressionChecks(const UWorld* World)
+{
+	if (!bInitialComponentSweepDone || PendingSuppressionChecks.IsEmpty())
+	{
+		return;
+	}
+	RR_PROFILE();
+
+	int32 NumDestroyed = 0;
+	for (const TWeakObjectPtr<USceneComponent>& WeakComponent : PendingSuppressionChecks)
+	{
+		USceneComponent* Component = WeakComponent.Get();
+		if (!Component || Component->GetWorld() != World)
+		{
+			continue;
+		}
+		if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component))
+		{
+			// Compatibility actors get tagged on a timer, so look at the class too in case that hasn't run yet
+			FName CompatibilityTag;
+			AActor* Owner = StaticMeshComponent->GetOwner();
+			if (ShouldDestroyMeshComponent(StaticMeshComponent) && !(Owner &&
+				ResourceRouletteCompatibilityManager::IsCompatibilityClass(Owner, CompatibilityTag)))
+			{
+				StaticMeshComponent->SetActive(false);
+				StaticMeshComponent->SetVisibility(false);
+				StaticMeshComponent->DestroyComponent();
+				NumDestroyed++;
+			}
+		}
+		else if (UDecalComponent* DecalComponent = Cast<UDecalComponent>(Component))
+		{
+			if (!DecalComponent->ComponentTags.Contains(ResourceRouletteTag))
+			{
+				DecalComponent->SetVisibility(false);
+				DecalComponent->DestroyComponent();
+				NumDestroyed++;
+			}
+		}
+	}
+
+	if (NumDestroyed > 0)
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("Suppressed %d streamed in or spawned components out of %d checked"), NumDestroyed,
+			                PendingSuppressionChecks.Num()), ELogLevel::Debug);
+	}
+	PendingSuppressionChecks.Reset();
+}
+
 /// Prep to remove the mod and destroy extractors in the world
 void UResourceRouletteManager::RemoveResourceRouletteNodes()
 {
@@ -619,6 +1474,8 @@ void UResourceRouletteManager::RemoveResourceRouletteNodes()
 		// and then the actor
 		ResourceNode->Destroy();
 	}
+	// Instanced rocks aren't part of the node actors
+	ResourceNodeSpawner->ClearNodeMeshInstances();
 }
 
 void UResourceRouletteManager::UpdateRadarTowers() const
@@ -659,6 +1516,7 @@ void FResourceRouletteModule::StartupModule()
 
 void FResourceRouletteModule::ShutdownModule()
 {
+	FResourceRouletteUtilityLog::Get().ShutdownLog();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,262 @@
+﻿#include "ResourceRouletteProfiler.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTLS.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	/// One finished scope, kept for the trace export
+	struct FProfileTraceEvent
+	{
+		const FResourceRouletteProfileSite* Site;
+		uint64 StartCycles;
+		uint64 DurationCycles;
+		uint32 ThreadId;
+		uint32 Depth;
+	};
+
+	// Caps the trace at a few MB, anything past that just counts as dropped
+	constexpr int32 MaxTraceEvents = 256 * 1024;
+
+	struct FProfilerRegistry
+	{
+		FCriticalSection Mutex;
+		TArray<FResourceRouletteProfileSite*> Sites;
+		TArray<FProfileTraceEvent> TraceEvents;
+		int32 NumDroppedTraceEvents = 0;
+	};
+
+	/// Function local so sites in other translation units can register during static init
+	FProfilerRegistry& GetRegistry()
+	{
+		static FProfilerRegistry Registry;
+		return Registry;
+	}
+
+	thread_local FResourceRouletteProfiler* CurrentScope = nullptr;
+	thread_local uint32 CurrentDepth = 0;
+
+	double CyclesToMilliseconds(const uint64 Cycles)
+	{
+		return FPlatformTime::ToMilliseconds64(Cycles);
+	}
+
+	FString EscapeJson(const FString& Value)
+	{
+		return Value.Replace(TEXT("\\"), TEXT("\\\\")).Replace(TEXT("\""), TEXT("\\\""));
+	}
+
+	FAutoConsoleCommand ProfilerDumpCommand(
+		TEXT("ResourceRoulette.Profiler.Dump"),
+		TEXT("Logs the aggregated RR_PROFILE stats"),
+		FConsoleCommandDelegate::CreateStatic(&FResourceRouletteProfiler::LogSummary)
+	);
+
+	FAutoConsoleCommand ProfilerExportTraceCommand(
+		TEXT("ResourceRoulette.Profiler.ExportTrace"),
+		TEXT("Writes the recorded RR_PROFILE scopes as Chrome trace JSON to Saved/Logs/ResourceRouletteTrace.json"),
+		FConsoleCommandDelegate::CreateLambda([]
+		{
+			FResourceRouletteProfiler::ExportTrace(
+				FPaths::Combine(FPaths::ProjectLogDir(), TEXT("ResourceRouletteTrace.json")));
+		})
+	);
+
+	FAutoConsoleCommand ProfilerResetCommand(
+		TEXT("ResourceRoulette.Profiler.Reset"),
+		TEXT("Clears the RR_PROFILE stats and trace"),
+		FConsoleCommandDelegate::CreateStatic(&FResourceRouletteProfiler::Reset)
+	);
+}
+
+/// @param FunctionName __FUNCTION__ of the profiled scope
+/// @param SubsectionName Optional name for a part of the function
+FResourceRouletteProfileSite::FResourceRouletteProfileSite(const ANSICHAR* FunctionName, const TCHAR* SubsectionName)
+	: Name(ANSI_TO_TCHAR(FunctionName))
+{
+	if (SubsectionName)
+	{
+		Name = FString::Printf(TEXT("%s - %s"), *Name, SubsectionName);
+	}
+	RecentSamples.Reserve(MaxRecentSamples);
+
+	FProfilerRegistry& Registry = GetRegistry();
+	FScopeLock Lock(&Registry.Mutex);
+	Registry.Sites.Add(this);
+}
+
+/// @param InclusiveCycles Time spent in the scope including children
+/// @param ExclusiveCycles Time spent in the scope minus children
+void FResourceRouletteProfileSite::AddSample(const uint64 InclusiveCycles, const uint64 ExclusiveCycles)
+{
+	FScopeLock Lock(&Mutex);
+	if (RecentSamples.Num() < MaxRecentSamples)
+	{
+		RecentSamples.Add(InclusiveCycles);
+	}
+	else
+	{
+		RecentSamples[NumCalls % MaxRecentSamples] = InclusiveCycles;
+	}
+	++NumCalls;
+	TotalCycles += InclusiveCycles;
+	SelfCycles += ExclusiveCycles;
+	MinCycles = FMath::Min(MinCycles, InclusiveCycles);
+	MaxCycles = FMath::Max(MaxCycles, InclusiveCycles);
+}
+
+void FResourceRouletteProfileSite::Reset()
+{
+	FScopeLock Lock(&Mutex);
+	NumCalls = 0;
+	TotalCycles = 0;
+	SelfCycles = 0;
+	MinCycles = MAX_uint64;
+	MaxCycles = 0;
+	RecentSamples.Reset();
+}
+
+/// @param InSite The static site of the RR_PROFILE this scope belongs to
+FResourceRouletteProfiler::FResourceRouletteProfiler(FResourceRouletteProfileSite& InSite)
+	: Site(InSite), Parent(CurrentScope), Depth(CurrentDepth)
+{
+	CurrentScope = this;
+	++CurrentDepth;
+	StartCycles = FPlatformTime::Cycles64();
+}
+
+FResourceRouletteProfiler::~FResourceRouletteProfiler()
+{
+	const uint64 ElapsedCycles = FPlatformTime::Cycles64() - StartCycles;
+	CurrentScope = Parent;
+	--CurrentDepth;
+	if (Parent)
+	{
+		Parent->ChildCycles += ElapsedCycles;
+	}
+
+	Site.AddSample(ElapsedCycles, ElapsedCycles - FMath::Min(ChildCycles, ElapsedCycles));
+
+	FProfilerRegistry& Registry = GetRegistry();
+	FScopeLock Lock(&Registry.Mutex);
+	if (Registry.TraceEvents.Num() < MaxTraceEvents)
+	{
+		Registry.TraceEvents.Add({&Site, StartCycles, ElapsedCycles, FPlatformTLS::GetCurrentThreadId(), Depth});
+	}
+	else
+	{
+		++Registry.NumDroppedTraceEvents;
+	}
+}
+
+void FResourceRouletteProfiler::LogSummary()
+{
+	struct FSiteSummary
+	{
+		FString Name;
+		uint64 NumCalls;
+		double TotalMs;
+		double SelfMs;
+		double MinMs;
+		double MaxMs;
+		double P99Ms;
+	};
+
+	TArray<FSiteSummary> Summaries;
+	{
+		FProfilerRegistry& Registry = GetRegistry();
+		FScopeLock Lock(&Registry.Mutex);
+		for (FResourceRouletteProfileSite* Site : Registry.Sites)
+		{
+			FScopeLock SiteLock(&Site->Mutex);
+			if (Site->NumCalls == 0)
+			{
+				continue;
+			}
+
+			TArray<uint64> SortedSamples = Site->RecentSamples;
+			SortedSamples.Sort();
+			const int32 P99Index = FMath::Min(SortedSamples.Num() - 1,
+			                                  FMath::CeilToInt(SortedSamples.Num() * 0.99) - 1);
+
+			Summaries.Add({
+				Site->Name, Site->NumCalls, CyclesToMilliseconds(Site->TotalCycles),
+				CyclesToMilliseconds(Site->SelfCycles), CyclesToMilliseconds(Site->MinCycles),
+				CyclesToMilliseconds(Site->MaxCycles), CyclesToMilliseconds(SortedSamples[FMath::Max(0, P99Index)])
+			});
+		}
+	}
+
+	Summaries.Sort([](const FSiteSummary& A, const FSiteSummary& B) { return A.TotalMs > B.TotalMs; });
+
+	FResourceRouletteUtilityLog& Log = FResourceRouletteUtilityLog::Get();
+	if (Summaries.IsEmpty())
+	{
+		Log.LogReport(TEXT("No profiler samples yet, nothing has run or ENABLE_PROFILING is 0"));
+		return;
+	}
+	Log.LogReport(FString::Printf(TEXT("%10s %12s %12s %10s %10s %10s %10s  %s"), TEXT("Calls"), TEXT("Total ms"),
+	                              TEXT("Self ms"), TEXT("Avg ms"), TEXT("Min ms"), TEXT("Max ms"), TEXT("P99 ms"),
+	                              TEXT("Scope")));
+	for (const FSiteSummary& Summary : Summaries)
+	{
+		Log.LogReport(FString::Printf(TEXT("%10llu %12.3f %12.3f %10.3f %10.3f %10.3f %10.3f  %s"), Summary.NumCalls,
+		                              Summary.TotalMs, Summary.SelfMs, Summary.TotalMs / Summary.NumCalls,
+		                              Summary.MinMs, Summary.MaxMs, Summary.P99Ms, *Summary.Name));
+	}
+}
+
+/// @param FilePath Where to put the json
+bool FResourceRouletteProfiler::ExportTrace(const FString& FilePath)
+{
+	FString Json = TEXT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	int32 NumEvents;
+	int32 NumDropped;
+	{
+		FProfilerRegistry& Registry = GetRegistry();
+		FScopeLock Lock(&Registry.Mutex);
+		NumEvents = Registry.TraceEvents.Num();
+		NumDropped = Registry.NumDroppedTraceEvents;
+
+		uint64 FirstCycles = MAX_uint64;
+		for (const FProfileTraceEvent& Event : Registry.TraceEvents)
+		{
+			FirstCycles = FMath::Min(FirstCycles, Event.StartCycles);
+		}
+
+		for (int32 i = 0; i < NumEvents; ++i)
+		{
+			const FProfileTraceEvent& Event = Registry.TraceEvents[i];
+			Json.Appendf(
+				TEXT("{\"name\":\"%s\",\"cat\":\"ResourceRoulette\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"depth\":%u}}%s\n"),
+				*EscapeJson(Event.Site->GetName()), CyclesToMilliseconds(Event.StartCycles - FirstCycles) * 1000.0,
+				CyclesToMilliseconds(Event.DurationCycles) * 1000.0, Event.ThreadId, Event.Depth,
+				i + 1 < NumEvents ? TEXT(",") : TEXT(""));
+		}
+	}
+	Json += TEXT("]}\n");
+
+	if (!FFileHelper::SaveStringToFile(Json, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		FResourceRouletteUtilityLog::Get().LogReport(
+			FString::Printf(TEXT("Couldn't write profiler trace to %s"), *FilePath));
+		return false;
+	}
+
+	FResourceRouletteUtilityLog::Get().LogReport(
+		FString::Printf(TEXT("Wrote %d profiler trace events to %s (%d dropped)"), NumEvents, *FilePath, NumDropped));
+	return true;
+}
+
+void FResourceRouletteProfiler::Reset()
+{
+	FProfilerRegistry& Registry = GetRegistry();
+	FScopeLock Lock(&Registry.Mutex);
+	for (FResourceRouletteProfileSite* Site : Registry.Sites)
+	{
+		Site->Reset();
+	}
+	Registry.TraceEvents.Reset();
+	Registry.NumDroppedTraceEvents = 0;
+}
@@ -8,6 +8,33 @@
 #include "Equipment/FGResourceScanner.h"
 #include "ModLoading/ModLoadingLibrary.h"
 #include "ResourceRouletteProfiler.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/Engine.h"
+
+static FAutoConsoleCommandWithWorld NodeMemoryCommand(
+	TEXT("ResourceRoulette.NodeMemory"),
+	TEXT("Logs the memory held by the node arrays"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&AResourceRouletteSubsystem::LogNodeMemory)
+);
+
+static FAutoConsoleCommand SubsystemLookupsCommand(
+	TEXT("ResourceRoulette.SubsystemLookups"),
+	TEXT("Logs how many subsystem lookups there were and how many had to search the world's actors"),
+	FConsoleCommandDelegate::CreateStatic(&AResourceRouletteSubsystem::LogLookupStats)
+);
+
+/// The subsystem of each world, set in BeginPlay and cleared in EndPlay so Get doesn't walk the actors
+static TMap<TWeakObjectPtr<const UWorld>, TWeakObjectPtr<AResourceRouletteSubsystem>> SubsystemRegistry;
+
+/// Lookups this session, anything past the first few going through the actors means the registry missed
+static int64 NumSubsystemLookups = 0;
+static int64 NumSubsystemActorSearches = 0;
+
+static FAutoConsoleCommandWithWorld NodeActivationCommand(
+	TEXT("ResourceRoulette.NodeActivation"),
+	TEXT("Logs how many nodes are full and how many are proxies, and their components, physics bodies and memory"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&AResourceRouletteSubsystem::LogNodeActivation)
+);
 
 /// Init the fields on construction or bad things happen
 AResourceRouletteSubsystem::AResourceRouletteSubsystem()
@@ -20,23 +47,61 @@ AResourceRouletteSubsystem::AResourceRouletteSubsystem()
 	SavedOriginalResourceNodes.Empty();
 	SessionSeed = -1;
 	SessionAlreadySpawned = false;
-	SessionRandomizedResourceNodes.Empty();
 	SavedModVersion = "Unknown";
+	// Ticks so the time-sliced world update can run a little every frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+/// Per-frame work, the heavy lifting still happens on the update timer
+/// @param DeltaSeconds Frame time
+void AResourceRouletteSubsystem::Tick(const float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	if (bIsInitialized && ResourceRouletteManager)
+	{
+		ResourceRouletteManager->TickWorldResourceNodes(GetWorld());
+	}
 }
 
+/// The subsystem of the context's world, straight from the registry once it has begun play
+/// @param WorldContext Anything in the world
+/// @return nullptr if the world doesn't have one
 AResourceRouletteSubsystem* AResourceRouletteSubsystem::Get(const UObject* WorldContext)
 {
-	if (!WorldContext)
+	const UWorld* World = WorldContext && GEngine
+		                      ? GEngine->GetWorldFromContextObject(WorldContext, EGetWorldErrorMode::ReturnNull)
+		                      : nullptr;
+	if (!World)
 	{
 		return nullptr;
 	}
-	return Cast<AResourceRouletteSubsystem>(UGameplayStatics::GetActorOfClass(WorldContext, StaticClass()));
+	NumSubsystemLookups++;
+	if (const TWeakObjectPtr<AResourceRouletteSubsystem>* RegisteredSubsystem = SubsystemRegistry.Find(World))
+	{
+		if (AResourceRouletteSubsystem* ResourceRouletteSubsystem = RegisteredSubsystem->Get())
+		{
+			return ResourceRouletteSubsystem;
+		}
+	}
+	// Only before BeginPlay, e.g. while the save is being loaded into it
+	NumSubsystemActorSearches++;
+	return Cast<AResourceRouletteSubsystem>(UGameplayStatics::GetActorOfClass(World, StaticClass()));
+}
+
+/// Logs the lookup counters, in steady state the actor searches shouldn't go up
+void AResourceRouletteSubsystem::LogLookupStats()
+{
+	FResourceRouletteUtilityLog::Get().LogReport(
+		FString::Printf(TEXT("Subsystem lookups: %lld, %lld searched the actors, %d worlds registered"),
+		                NumSubsystemLookups, NumSubsystemActorSearches, SubsystemRegistry.Num()));
 }
 
-/// On BeginPlay, initializes itself
+/// On BeginPlay, registers itself for its world and initializes
 void AResourceRouletteSubsystem::BeginPlay()
 {
 	Super::BeginPlay();
+	SubsystemRegistry.Add(GetWorld(), this);
 	InitializeResourceRoulette();
 }
 
@@ -57,8 +122,6 @@ void AResourceRouletteSubsystem::InitializeResourceRoulette()
 	                                       UpdateInterval, true);
 	FResourceRouletteUtilityLog::Get().LogMessage("Resource Roulette initialized successfully.", ELogLevel::Debug);
 	UpdateResourceRoulette();
-	UResourceRouletteUtility::ScannerGenerateNodeClusters(GetWorld(), 7000.0f);
-	ResourceRouletteManager->UpdateRadarTowers();
 }
 
 /// Called to re-roll Resources
@@ -70,8 +133,6 @@ void AResourceRouletteSubsystem::RerollResources()
 	ResourceRouletteManager->RemoveResourceRouletteNodes();
 	InitializeWorldSeedManager(GetWorld());
 	ResourceRouletteManager->Update(GetWorld(), SeedManager, true);
-	UResourceRouletteUtility::ScannerGenerateNodeClusters(GetWorld(), 7000.0f);
-	ResourceRouletteManager->UpdateRadarTowers();
 }
 
 /// Called to update Resources - currently just resets positions back to original and re-lays them down
@@ -80,8 +141,6 @@ void AResourceRouletteSubsystem::UpdateResources()
 	RR_PROFILE();
 	ResourceRouletteManager->RemoveResourceRouletteNodes();
 	ResourceRouletteManager->Update(GetWorld(), SeedManager, true);
-	UResourceRouletteUtility::ScannerGenerateNodeClusters(GetWorld(), 7000.0f);
-	ResourceRouletteManager->UpdateRadarTowers();
 }
 
 
@@ -142,12 +201,36 @@ void AResourceRouletteSubsystem::UpdateResourceRoulette() const
 	// FResourceRouletteUtilityLog::Get().LogMessage("Resource nodes updated successfully.", ELogLevel::Debug);
 }
 
+/// Called once the manager has finished spawning nodes, anything that needs them in the world goes here
+void AResourceRouletteSubsystem::OnResourceNodesSpawned() const
+{
+	RR_PROFILE();
+	UResourceRouletteUtility::ScannerGenerateNodeClusters(GetWorld(), 7000.0f);
+	if (ResourceRouletteManager)
+	{
+		ResourceRouletteManager->UpdateRadarTowers();
+	}
+}
+
 /// On shutdown it Clears the timers.
 /// TODO: - We should also clean up all the other things we were playing with
 /// @param EndPlayReason I actually have no idea what this is, but I don't think really need to use it
 void AResourceRouletteSubsystem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	GetWorld()->GetTimerManager().ClearTimer(UpdateTimerHandle);
+	if (ResourceRouletteManager)
+	{
+		ResourceRouletteManager->CancelSpawning();
+		ResourceRouletteManager->UnregisterMeshSuppressionHooks();
+		// Settles that landed after the last pass finished would be lost otherwise
+		ResourceRouletteManager->SaveSettleCache();
+	}
+	// Another subsystem may have taken the world over already
+	if (const TWeakObjectPtr<AResourceRouletteSubsystem>* RegisteredSubsystem = SubsystemRegistry.Find(GetWorld());
+		RegisteredSubsystem && RegisteredSubsystem->Get() == this)
+	{
+		SubsystemRegistry.Remove(GetWorld());
+	}
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -158,8 +241,6 @@ void AResourceRouletteSubsystem::PreSaveGame_Implementation(int32 SaveVersion, i
 {
 	SavedSeed = SessionSeed;
 	SavedAlreadySpawned = SessionAlreadySpawned;
-	SavedRandomizedResourceNodes = SessionRandomizedResourceNodes;
-	SavedOriginalResourceNodes = OriginalResourceNodes;
 	FModInfo ModInfo;
 	UModLoadingLibrary* ModLoadingLibrary = UGameplayStatics::GetGameInstance(GetWorld())->GetSubsystem<
 		UModLoadingLibrary>();
@@ -167,6 +248,11 @@ void AResourceRouletteSubsystem::PreSaveGame_Implementation(int32 SaveVersion, i
 	{
 		SavedModVersion = ModInfo.Version.ToString();
 	}
+	// The game is hitching for its own save anyway, a good time to write the settle cache too
+	if (ResourceRouletteManager)
+	{
+		ResourceRouletteManager->SaveSettleCache();
+	}
 }
 
 /// Loads our data from the savefile
@@ -202,9 +288,7 @@ void AResourceRouletteSubsystem::PostLoadGame_Implementation(int32 SaveVersion,
 		// SavedAlreadySpawned = false;
 		// SessionAlreadySpawned = false;
 		// SavedRandomizedResourceNodes.Empty();
-		// SessionRandomizedResourceNodes.Empty();
 		SavedOriginalResourceNodes.Empty();
-		OriginalResourceNodes.Empty();
 	}
 
 	if (SavedAlreadySpawned)
@@ -215,13 +299,11 @@ void AResourceRouletteSubsystem::PostLoadGame_Implementation(int32 SaveVersion,
 	}
 	if (SavedRandomizedResourceNodes.Num() > 0)
 	{
-		SessionRandomizedResourceNodes = SavedRandomizedResourceNodes;
 		FResourceRouletteUtilityLog::Get().LogMessage(
 			TEXT("PostLoadGame: Previously Randomized List of Nodes loaded"), ELogLevel::Debug);
 	}
 	if (SavedOriginalResourceNodes.Num() > 0)
 	{
-		OriginalResourceNodes = SavedOriginalResourceNodes;
 		FResourceRouletteUtilityLog::Get().LogMessage(
 			TEXT("PostLoadGame: Original List of Nodes loaded"), ELogLevel::Debug);
 	}
@@ -235,13 +317,63 @@ void AResourceRouletteSubsystem::SetSessionAlreadySpawned(const bool InSessionAl
 	SessionAlreadySpawned = InSessionAlreadySpawned;
 }
 
+/// Takes over the randomized nodes, the old array is dropped instead of copied into
+/// @param InSessionRandomizedResourceNodes Nodes to keep, left empty
 void AResourceRouletteSubsystem::SetSessionRandomizedResourceNodes(
-	const TArray<FResourceNodeData>& InSessionRandomizedResourceNodes)
+	TArray<FResourceNodeData>&& InSessionRandomizedResourceNodes)
+{
+	SavedRandomizedResourceNodes = MoveTemp(InSessionRandomizedResourceNodes);
+}
+
+/// Takes over the nodes as they were before randomizing
+/// @param InOriginalResourceNodes Nodes to keep, left empty
+void AResourceRouletteSubsystem::SetOriginalResourceNodes(TArray<FResourceNodeData>&& InOriginalResourceNodes)
 {
-	SessionRandomizedResourceNodes = InSessionRandomizedResourceNodes;
+	SavedOriginalResourceNodes = MoveTemp(InOriginalResourceNodes);
 }
 
-void AResourceRouletteSubsystem::SetOriginalResourceNodes(const TArray<FResourceNodeData>& InOriginalResourceNodes)
+/// Logs how much memory the node arrays take as measured, next to an estimate of what the old layout with a copy
+/// per pipeline stage would have held for the same nodes
+/// @param World World whose subsystem to report on
+void AResourceRouletteSubsystem::LogNodeMemory(UWorld* World)
 {
-	OriginalResourceNodes = InOriginalResourceNodes;
+	const AResourceRouletteSubsystem* ResourceRouletteSubsystem = Get(World);
+	if (!ResourceRouletteSubsystem)
+	{
+		FResourceRouletteUtilityLog::Get().LogReport("LogNodeMemory: No subsystem in this world.");
+		return;
+	}
+
+	const TArray<FResourceNodeData>& RandomizedNodes = ResourceRouletteSubsystem->SavedRandomizedResourceNodes;
+	const TArray<FResourceNodeData>& OriginalNodes = ResourceRouletteSubsystem->SavedOriginalResourceNodes;
+	const SIZE_T RandomizedBytes = RandomizedNodes.GetAllocatedSize();
+	const SIZE_T OriginalBytes = OriginalNodes.GetAllocatedSize();
+
+	// Not measured, the old layout is gone. Randomized nodes used to be held by the randomizer, the spawner, the
+	// session and the save properties, the originals by the collection manager, the session and the save
+	// properties. Counts elements only, so it leaves out slack and the strings each node points to
+	const SIZE_T RandomizedArrayBytes = RandomizedNodes.Num() * sizeof(FResourceNodeData);
+	const SIZE_T OriginalArrayBytes = OriginalNodes.Num() * sizeof(FResourceNodeData);
+	const SIZE_T EstimatedBytesBefore = 4 * RandomizedArrayBytes + 3 * OriginalArrayBytes;
+	const SIZE_T BytesAfter = RandomizedBytes + OriginalBytes;
+
+	FResourceRouletteUtilityLog::Get().LogReport(
+		FString::Printf(
+			TEXT("Node memory: %d randomized nodes %.1f KB, %d original nodes %.1f KB, %.1f KB total allocated. "
+				"Estimate for the old layout with a copy per stage: %.1f KB (element sizes only, not measured)"),
+			RandomizedNodes.Num(), RandomizedBytes / 1024.0, OriginalNodes.Num(), OriginalBytes / 1024.0,
+			BytesAfter / 1024.0, EstimatedBytesBefore / 1024.0));
+}
+
+/// Logs the node activation counts of the world's manager
+/// @param World World whose subsystem to report on
+void AResourceRouletteSubsystem::LogNodeActivation(UWorld* World)
+{
+	const AResourceRouletteSubsystem* ResourceRouletteSubsystem = Get(World);
+	if (!ResourceRouletteSubsystem || !ResourceRouletteSubsystem->ResourceRouletteManager)
+	{
+		FResourceRouletteUtilityLog::Get().LogReport("LogNodeActivation: No subsystem in this world.");
+		return;
+	}
+	ResourceRouletteSubsystem->ResourceRouletteManager->LogNodeActivation(World);
 }
@@ -23,6 +23,11 @@
 #include "Async/ParallelFor.h"
 #include "Buildables/FGBuildableFrackingActivator.h"
 #include "Buildables/FGBuildableFrackingExtractor.h"
+#include "RandomizerCore/ResourceLocationGrid.h"
+#include "RandomizerCore/ResourcePlaneFit.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Misc/App.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogResourceRoulette, Log, All);
 
@@ -33,6 +38,49 @@ static TAutoConsoleVariable<int32> CVarLogLevel(
 	ECVF_Default
 );
 
+/// How many raycast points settling a node checks
+static constexpr int32 NumSettleTracePoints = 50;
+/// Every n-th point of the disk goes in the first round of adaptive settling, so it still covers the full radius
+static constexpr int32 InitialSettleTraceStride = 4;
+/// Fewer terrain hits than this and the node isn't settled
+static constexpr int32 MinSettleHitPoints = 10;
+
+/// Start settling with a sparse ring of traces and only fire the rest when the ground isn't flat enough
+static TAutoConsoleVariable<int32> CVarAdaptiveSettleSampling(
+	TEXT("ResourceRoulette.AdaptiveSettleSampling"), 1,
+	TEXT("1 = settle with a sparse set of traces first and only trace the full disk on uneven ground, 0 = always trace the full disk"),
+	ECVF_Default
+);
+
+/// How far off the fitted plane the first round of hits can be before the full disk gets traced
+static TAutoConsoleVariable<int32> CVarSettleResidualThreshold(
+	TEXT("ResourceRoulette.SettleResidualThreshold"), 10,
+	TEXT("RMS distance in cm of the first settle hits from their plane above which the full disk is traced"),
+	ECVF_Default
+);
+
+/// Servers nobody looks at skip the node meshes' materials, decals and render-only cleanup
+static TAutoConsoleVariable<int32> CVarHeadlessServerMode(
+	TEXT("ResourceRoulette.HeadlessServerMode"), 1,
+	TEXT("1 = on dedicated servers and -nullrhi only load and create what gameplay and collision need, 0 = same as a client"),
+	ECVF_Default
+);
+
+/// Rays spent on settling this session, to see what adaptive sampling saves
+static int32 NumSessionSettleAttempts = 0;
+static int64 NumSessionSettleTraces = 0;
+
+static FAutoConsoleCommand SettleStatsCommand(
+	TEXT("ResourceRoulette.SettleStats"),
+	TEXT("Logs how many settle traces nodes needed on average this session"),
+	FConsoleCommandDelegate::CreateStatic(&UResourceRouletteUtility::LogSettleStats)
+);
+
+/// Pending log characters before new messages start getting dropped
+static constexpr int32 LogBufferCapacity = 512 * 1024;
+/// How often the writer thread flushes when nobody wakes it up
+static constexpr uint32 LogFlushIntervalMilliseconds = 250;
+
 FResourceRouletteUtilityLog FResourceRouletteUtilityLog::Instance;
 
 FResourceRouletteUtilityLog& FResourceRouletteUtilityLog::Get()
@@ -40,13 +88,13 @@ FResourceRouletteUtilityLog& FResourceRouletteUtilityLog::Get()
 	return Instance;
 }
 
-/// Initializes Logfile stuff
+/// Initializes Logfile stuff, opens the file once and starts the writer thread
 void FResourceRouletteUtilityLog::InitializeLog()
 {
 	if (bUseCustomLogFile)
 	{
 		FScopeLock Lock(&LogFileMutex);
-		if (!LogFile)
+		if (!bIsLogOpen)
 		{
 			const FString LogFilePath = FPaths::Combine(
 				FPlatformMisc::GetEnvironmentVariable(TEXT("LOCALAPPDATA")),
@@ -55,7 +103,26 @@ void FResourceRouletteUtilityLog::InitializeLog()
 
 			IFileManager& FileManager = IFileManager::Get();
 			FileManager.Delete(*LogFilePath);
-			LogFile = new FString(LogFilePath);
+			LogFileWriter.Reset(FileManager.CreateFileWriter(*LogFilePath, FILEWRITE_AllowRead));
+			if (!LogFileWriter)
+			{
+				UE_LOG(LogResourceRoulette, Error, TEXT("Couldn't open %s, falling back to UE_LOG"), *LogFilePath);
+				return;
+			}
+
+			LogBuffer.SetNumUninitialized(LogBufferCapacity);
+			LogBufferHead = 0;
+			LogBufferNum = 0;
+			NumDroppedMessages = 0;
+			bIsLogOpen = true;
+
+			// Without threads RawLogMessage just drains the buffer itself
+			if (FPlatformProcess::SupportsMultithreading())
+			{
+				bStopWriter = false;
+				WriterWakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+				WriterThread = FRunnableThread::Create(this, TEXT("ResourceRouletteLogWriter"), 0, TPri_BelowNormal);
+			}
 
 			RawLogMessage(TEXT("Resource Roulette Module Log Startup"));
 		}
@@ -68,18 +135,109 @@ void FResourceRouletteUtilityLog::SetUseCustomLogFile(const bool bEnableCustomLo
 	bUseCustomLogFile = bEnableCustomLogFile;
 }
 
-/// Writes log message to file
+/// Queues a log message for the writer thread, drops it if the buffer is full
 /// @param Message 
 void FResourceRouletteUtilityLog::RawLogMessage(const FString& Message)
 {
-	FScopeLock Lock(&LogFileMutex);
-	if (LogFile && !LogFile->IsEmpty())
+	const int32 TerminatorLength = FCString::Strlen(LINE_TERMINATOR);
+	bool bShouldWakeWriter = false;
+	{
+		FScopeLock Lock(&LogFileMutex);
+		if (!bIsLogOpen)
+		{
+			return;
+		}
+		if (LogBufferNum + Message.Len() + TerminatorLength > LogBuffer.Num())
+		{
+			++NumDroppedMessages;
+			return;
+		}
+		CopyToLogBuffer(*Message, Message.Len());
+		CopyToLogBuffer(LINE_TERMINATOR, TerminatorLength);
+
+		// Don't wait for the timer if the buffer is filling up
+		bShouldWakeWriter = LogBufferNum > LogBuffer.Num() / 2;
+	}
+
+	if (!WriterThread)
+	{
+		DrainLogBuffer();
+	}
+	else if (bShouldWakeWriter)
+	{
+		WriterWakeEvent->Trigger();
+	}
+}
+
+/// Appends to the ring buffer, caller holds LogFileMutex and has checked there's room
+/// @param Characters 
+/// @param NumCharacters 
+void FResourceRouletteUtilityLog::CopyToLogBuffer(const TCHAR* Characters, const int32 NumCharacters)
+{
+	const int32 Tail = (LogBufferHead + LogBufferNum) % LogBuffer.Num();
+	const int32 NumBeforeWrap = FMath::Min(NumCharacters, LogBuffer.Num() - Tail);
+	FMemory::Memcpy(LogBuffer.GetData() + Tail, Characters, NumBeforeWrap * sizeof(TCHAR));
+	FMemory::Memcpy(LogBuffer.GetData(), Characters + NumBeforeWrap, (NumCharacters - NumBeforeWrap) * sizeof(TCHAR));
+	LogBufferNum += NumCharacters;
+}
+
+/// Moves everything queued so far out of the ring buffer and writes it to the file, only the writer calls this
+void FResourceRouletteUtilityLog::DrainLogBuffer()
+{
+	int32 NumDropped;
+	{
+		FScopeLock Lock(&LogFileMutex);
+		NumDropped = NumDroppedMessages;
+		NumDroppedMessages = 0;
+
+		const int32 NumBeforeWrap = FMath::Min(LogBufferNum, LogBuffer.Num() - LogBufferHead);
+		PendingCharacters.Reset();
+		PendingCharacters.Append(LogBuffer.GetData() + LogBufferHead, NumBeforeWrap);
+		PendingCharacters.Append(LogBuffer.GetData(), LogBufferNum - NumBeforeWrap);
+		LogBufferHead = LogBuffer.Num() > 0 ? (LogBufferHead + LogBufferNum) % LogBuffer.Num() : 0;
+		LogBufferNum = 0;
+	}
+
+	if (!LogFileWriter || (PendingCharacters.IsEmpty() && NumDropped == 0))
+	{
+		return;
+	}
+
+	auto WriteCharacters = [this](const TCHAR* Characters, const int32 NumCharacters)
+	{
+		const FTCHARToUTF8 Utf8Characters(Characters, NumCharacters);
+		LogFileWriter->Serialize(const_cast<void*>(static_cast<const void*>(Utf8Characters.Get())),
+		                         Utf8Characters.Length());
+	};
+	WriteCharacters(PendingCharacters.GetData(), PendingCharacters.Num());
+	if (NumDropped > 0)
+	{
+		const FString DroppedLine = FString::Printf(TEXT("Log buffer was full, dropped %d messages%s"), NumDropped,
+		                                            LINE_TERMINATOR);
+		WriteCharacters(*DroppedLine, DroppedLine.Len());
+	}
+	LogFileWriter->Flush();
+}
+
+/// Writer thread loop, flushes on a timer or when the buffer is half full
+uint32 FResourceRouletteUtilityLog::Run()
+{
+	while (!bStopWriter)
 	{
-		const FString LogFilePath = *LogFile;
-		const FString FormattedMessage = Message + LINE_TERMINATOR;
+		WriterWakeEvent->Wait(LogFlushIntervalMilliseconds);
+		DrainLogBuffer();
+	}
+	DrainLogBuffer();
+	return 0;
+}
 
-		FFileHelper::SaveStringToFile(FormattedMessage, *LogFilePath, FFileHelper::EEncodingOptions::AutoDetect,
-		                              &IFileManager::Get(), FILEWRITE_Append);
+/// Asks the writer thread to flush whatever is left and exit
+void FResourceRouletteUtilityLog::Stop()
+{
+	bStopWriter = true;
+	if (WriterWakeEvent)
+	{
+		WriterWakeEvent->Trigger();
 	}
 }
 
@@ -91,7 +249,7 @@ void FResourceRouletteUtilityLog::LogMessage(const FString& Message, ELogLevel L
 	const int32 CurrentLogLevel = CVarLogLevel.GetValueOnAnyThread();
 	if (static_cast<int32>(Level) >= CurrentLogLevel)
 	{
-		if (bUseCustomLogFile && LogFile)
+		if (bUseCustomLogFile && bIsLogOpen)
 		{
 			RawLogMessage(Message);
 		}
@@ -114,6 +272,17 @@ void FResourceRouletteUtilityLog::LogMessage(const FString& Message, ELogLevel L
 	}
 }
 
+/// Prints a report someone asked for from the console. Goes to the custom log file like everything else, and
+/// to the UE log at Display so it shows up in the console too
+/// @param Message Report line
+void FResourceRouletteUtilityLog::LogReport(const FString& Message)
+{
+	if (bUseCustomLogFile && bIsLogOpen)
+	{
+		RawLogMessage(Message);
+	}
+	UE_LOG(LogResourceRoulette, Display, TEXT("%s"), *Message);
+}
 
 /// Blueprint callable way to override using custom logfile or not
 /// @param bEnableCustomLogFile 
@@ -131,15 +300,34 @@ void UResourceRouletteUtility::LogMessage(const FString& Message, EBlueprintLogL
 	Logger.LogMessage(Message, static_cast<ELogLevel>(Level));
 }
 
-/// Shuts down the log
+/// Shuts down the log, waits for the writer thread to flush and closes the file
 void FResourceRouletteUtilityLog::ShutdownLog()
 {
-	if (bUseCustomLogFile && LogFile)
+	if (!bIsLogOpen)
+	{
+		return;
+	}
+	RawLogMessage(TEXT("Resource Roulette Module Log Shutdown"));
+
+	if (WriterThread)
+	{
+		// Kill calls Stop and waits, Run drains the buffer one last time on the way out
+		WriterThread->Kill(true);
+		delete WriterThread;
+		WriterThread = nullptr;
+		FPlatformProcess::ReturnSynchEventToPool(WriterWakeEvent);
+		WriterWakeEvent = nullptr;
+	}
+	else
 	{
-		RawLogMessage(TEXT("Resource Roulette Module Log Shutdown"));
-		delete LogFile;
-		LogFile = nullptr;
+		DrainLogBuffer();
 	}
+
+	FScopeLock Lock(&LogFileMutex);
+	bIsLogOpen = false;
+	LogFileWriter.Reset();
+	LogBuffer.Empty();
+	PendingCharacters.Empty();
 }
 
 /// Static method to initialize the logging module
@@ -353,6 +541,19 @@ const TArray<FName>& UResourceRouletteUtility::GetNonGroupableResources()
 	return NonGroupableResources;
 }
 
+/// Whether this process never renders anything, a dedicated server or a -nullrhi run. Collision still matters
+/// there, materials and decals don't
+/// @param World World context, can be null
+/// @return true if visual-only work can be skipped
+bool UResourceRouletteUtility::IsHeadlessServer(const UWorld* World)
+{
+	if (CVarHeadlessServerMode.GetValueOnGameThread() == 0)
+	{
+		return false;
+	}
+	return !FApp::CanEverRender() || IsRunningDedicatedServer() || (World && World->GetNetMode() == NM_DedicatedServer);
+}
+
 /// Logs all the resource nodes in the world
 /// @param World World Context
 void UResourceRouletteUtility::LogAllResourceNodes(const UWorld* World)
@@ -414,87 +615,197 @@ void UResourceRouletteUtility::LogAllResourceNodes(const UWorld* World)
 /// Raycasts nodes and finds how to rotate them properly to the world.
 /// Right now writes back to NodeData directly, should probably use setters
 /// to do it better. Raycasting is surprisingly cheap so we're using a lot of points
-/// for now
+/// for now. This is the blocking version, the manager normally does the same traces async
 /// @param NodeData The NodeData we're checking
 /// @param World World Context
 /// @param ResourceNodeActor We have to ignore the actor/mesh when raycasting or we hit ourself
+/// @param NodeMeshInstances Instanced mesh the node's rock is drawn with, if it doesn't have its own
 /// @return Returns True if it succeeds, false if fails. Failure should be because there was no
 ///			world to raycast against so we will try again later
 bool UResourceRouletteUtility::CalculateLocationAndRotationForNode(FResourceNodeData& NodeData, const UWorld* World,
-                                                                   const AActor* ResourceNodeActor)
+                                                                   const AActor* ResourceNodeActor,
+                                                                   const UPrimitiveComponent* NodeMeshInstances)
+{
+	RR_PROFILE();
+	TArray<TPair<FVector, FVector>> Segments;
+	GetSettleTraceSegments(NodeData.Location, Segments);
+	const FCollisionQueryParams QueryParams = GetSettleQueryParams(ResourceNodeActor, NodeMeshInstances);
+
+	TArray<FVector> HitPoints;
+	TArray<FHitResult> Hits;
+	int32 NumTraced = 0;
+	auto TraceUpTo = [&](const int32 NumTraces)
+	{
+		for (; NumTraced < NumTraces; ++NumTraced)
+		{
+			Hits.Reset();
+			FVector HitPoint;
+			const TPair<FVector, FVector>& Segment = Segments[NumTraced];
+			if (World->LineTraceMultiByChannel(Hits, Segment.Key, Segment.Value, ECC_WorldStatic, QueryParams) &&
+				FindSettleHitPoint(Hits, HitPoint))
+			{
+				HitPoints.Add(HitPoint);
+			}
+		}
+	};
+
+	TOptional<FVector> PlaneNormal;
+	TraceUpTo(GetNumInitialSettleTraces());
+	if (NumTraced < Segments.Num() && NeedsMoreSettleTraces(HitPoints, PlaneNormal))
+	{
+		PlaneNormal.Reset();
+		TraceUpTo(Segments.Num());
+	}
+	RecordSettleTraces(NodeData, NumTraced);
+	return ApplySettleHitPoints(NodeData, HitPoints, PlaneNormal.GetPtrOrNull());
+}
+
+int32 UResourceRouletteUtility::GetNumSettleTraces()
+{
+	return NumSettleTracePoints;
+}
+
+/// How many of the GetSettleTraceSegments traces to fire before deciding whether the rest are needed
+int32 UResourceRouletteUtility::GetNumInitialSettleTraces()
+{
+	return CVarAdaptiveSettleSampling.GetValueOnGameThread() != 0
+		       ? (NumSettleTracePoints + InitialSettleTraceStride - 1) / InitialSettleTraceStride
+		       : NumSettleTracePoints;
+}
+
+/// Flat ground is pinned down by a handful of hits, bumpy ground or rocks in the way show up as hits far off
+/// the fitted plane and get the full disk
+/// @param HitPoints Terrain hits so far
+/// @param OutPlaneNormal Normal fitted to HitPoints, if there were enough of them to fit. Still good for
+///			ApplySettleHitPoints as long as no more hits get added
+/// @return true if the remaining traces should be fired
+bool UResourceRouletteUtility::NeedsMoreSettleTraces(const TArray<FVector>& HitPoints,
+                                                     TOptional<FVector>& OutPlaneNormal)
 {
 	RR_PROFILE();
-	TArray<FVector> SamplePoints;
+	if (HitPoints.Num() < MinSettleHitPoints)
+	{
+		return true;
+	}
+
+	TArray<ResourceRouletteCore::FVec3, TInlineAllocator<NumSettleTracePoints>> CorePoints;
+	for (const FVector& Point : HitPoints)
+	{
+		CorePoints.Add({Point.X, Point.Y, Point.Z});
+	}
+	const ResourceRouletteCore::FVec3 Normal = ResourceRouletteCore::FitPlaneNormal(
+		CorePoints.GetData(), CorePoints.Num());
+	OutPlaneNormal = FVector(Normal.X, Normal.Y, Normal.Z);
+	const double RmsDistance = ResourceRouletteCore::GetPlaneRmsDistance(CorePoints.GetData(), CorePoints.Num(),
+	                                                                     Normal);
+	return RmsDistance > CVarSettleResidualThreshold.GetValueOnGameThread();
+}
+
+/// Adds the traces a settle attempt spent to the node and the session totals
+/// @param NodeData Node that was traced
+/// @param NumTraces How many traces it took
+void UResourceRouletteUtility::RecordSettleTraces(FResourceNodeData& NodeData, const int32 NumTraces)
+{
+	NodeData.NumSettleTraces += NumTraces;
+	NumSessionSettleAttempts++;
+	NumSessionSettleTraces += NumTraces;
+}
+
+void UResourceRouletteUtility::LogSettleStats()
+{
+	const double TracesPerAttempt = NumSessionSettleAttempts > 0
+		                                ? static_cast<double>(NumSessionSettleTraces) / NumSessionSettleAttempts
+		                                : 0.0;
+	FResourceRouletteUtilityLog::Get().LogReport(
+		FString::Printf(TEXT("Settle traces this session: %lld over %d attempts, %.1f per attempt (full disk is %d)"),
+		                NumSessionSettleTraces, NumSessionSettleAttempts, TracesPerAttempt, NumSettleTracePoints));
+}
+
+/// Vogel disk of downward traces around a node. Every InitialSettleTraceStride-th point comes first, so the
+/// GetNumInitialSettleTraces that adaptive settling starts with still cover the whole disk
+/// @param NodeLocation Where the node currently is
+/// @param OutSegments Start and end of every trace
+void UResourceRouletteUtility::GetSettleTraceSegments(const FVector& NodeLocation,
+                                                      TArray<TPair<FVector, FVector>>& OutSegments)
+{
 	const float Radius = 800.0f; // gives 16m search diameter, which is ~2 foundations.
-	const int NumPoints = 50; // How many raycast points to check
-	FVector LocationAboveGround = NodeData.Location + FVector(0, 0, 600); // Start 4m above ground
+	const int NumPoints = NumSettleTracePoints;
+	FVector LocationAboveGround = NodeLocation + FVector(0, 0, 600); // Start 4m above ground
 
 	// Vogel disk for sampling. We can precalculate this instead of doing at runtime if this is a bottleneck
 	// but the whole process is surprisingly lightweight. We could probably bump to even more points tbh 
 	const float GoldenAngle = 2.39996f;
-	for (int i = 0; i < NumPoints; ++i)
+	OutSegments.Reset(NumPoints);
+	for (int Start = 0; Start < InitialSettleTraceStride; ++Start)
 	{
-		float Distance = Radius * FMath::Sqrt(static_cast<float>(i) / NumPoints);
-		float Angle = i * GoldenAngle;
+		for (int i = Start; i < NumPoints; i += InitialSettleTraceStride)
+		{
+			float Distance = Radius * FMath::Sqrt(static_cast<float>(i) / NumPoints);
+			float Angle = i * GoldenAngle;
 
-		float X = FMath::Cos(Angle) * Distance;
-		float Y = FMath::Sin(Angle) * Distance;
+			float X = FMath::Cos(Angle) * Distance;
+			float Y = FMath::Sin(Angle) * Distance;
 
-		SamplePoints.Add(LocationAboveGround + FVector(X, Y, 0));
+			const FVector StartPoint = LocationAboveGround + FVector(X, Y, 0);
+			OutSegments.Emplace(StartPoint, StartPoint - FVector(0, 0, 1200));
+		}
 	}
+}
 
-	TArray<FVector> HitPoints;
-	FCollisionQueryParams QueryParams;
+/// @param ResourceNodeActor We have to ignore the actor/mesh when raycasting or we hit ourself
+/// @param NodeMeshInstances Instanced mesh the node's rock is drawn with, if it doesn't have its own
+/// @return Query params for the settle traces
+FCollisionQueryParams UResourceRouletteUtility::GetSettleQueryParams(const AActor* ResourceNodeActor,
+                                                                    const UPrimitiveComponent* NodeMeshInstances)
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ResourceRouletteSettle), false);
 	if (ResourceNodeActor)
 	{
 		QueryParams.AddIgnoredActor(ResourceNodeActor);
 		QueryParams.AddIgnoredComponent(ResourceNodeActor->FindComponentByClass<UStaticMeshComponent>());
 	}
+	// Ignores every rock of the class, which is fine, traces only want terrain anyway
+	if (NodeMeshInstances)
+	{
+		QueryParams.AddIgnoredComponent(NodeMeshInstances);
+	}
+	return QueryParams;
+}
 
-	// for (const FVector& StartPoint : SamplePoints)
-	// {
-	// 	FVector EndPoint = StartPoint - FVector(0, 0, 1200);
-	// 	FHitResult Hit;
-	// 	if (World->LineTraceSingleByChannel(Hit, StartPoint, EndPoint, ECC_WorldStatic, QueryParams))
-	// 	{
-	// 		HitPoints.Add(Hit.ImpactPoint);
-	// 	}
-	// }
-
-	for (const FVector& StartPoint : SamplePoints)
+/// Picks the first hit that's actually terrain, landscape, cliffs and static meshes count
+/// @param Hits Hits of one trace
+/// @param OutHitPoint Impact point of the terrain hit
+/// @return true if one was found
+bool UResourceRouletteUtility::FindSettleHitPoint(const TArray<FHitResult>& Hits, FVector& OutHitPoint)
+{
+	for (const FHitResult& Hit : Hits)
 	{
-		FVector EndPoint = StartPoint - FVector(0, 0, 1200);
-		TArray<FHitResult> Hits;
-		if (World->LineTraceMultiByChannel(Hits, StartPoint, EndPoint, ECC_WorldStatic, QueryParams))
+		const AActor* HitActor = Hit.GetActor();
+		if (!HitActor)
 		{
-			bool bHitPointAdded = false;
-			for (const FHitResult& Hit : Hits)
-			{
-				if (bHitPointAdded)
-				{
-					break;
-				}
-				AActor* HitActor = Hit.GetActor();
-				if (!HitActor)
-				{
-					continue;
-				}
-				if (HitActor->IsA(ALandscapeStreamingProxy::StaticClass()) || HitActor->IsA(AStaticMeshActor::StaticClass()) || HitActor->IsA(AFGCliffActor::StaticClass()))
-				{
-					HitPoints.Add(Hit.ImpactPoint);
-					bHitPointAdded = true;
-				}
-				// else
-				// {
-				// 	FString ClassName = HitActor->GetClass()->GetName();
-				// 	FResourceRouletteUtilityLog::Get().LogMessage(FString::Printf(TEXT("Ignored Hit Class: %s"), *ClassName), ELogLevel::Warning);
-				// }
-			}
+			continue;
+		}
+		// Landscape is by far the most common hit, so check it first
+		if (HitActor->IsA<ALandscapeStreamingProxy>() || HitActor->IsA<AStaticMeshActor>() ||
+			HitActor->IsA<AFGCliffActor>())
+		{
+			OutHitPoint = Hit.ImpactPoint;
+			return true;
 		}
 	}
+	return false;
+}
 
-
-	if (HitPoints.Num() < NumPoints - 40)
+/// Turns the terrain hits around a node into its settled height and rotation
+/// @param NodeData Node to update
+/// @param HitPoints Terrain hits from the settle traces
+/// @param PlaneNormal Normal NeedsMoreSettleTraces already fitted to these same hits, saves fitting them again
+/// @return false if there weren't enough hits, the terrain probably isn't streamed in yet
+bool UResourceRouletteUtility::ApplySettleHitPoints(FResourceNodeData& NodeData, const TArray<FVector>& HitPoints,
+                                                    const FVector* PlaneNormal)
+{
+	RR_PROFILE();
+	if (HitPoints.Num() < MinSettleHitPoints)
 	{
 		FResourceRouletteUtilityLog::Get().LogMessage(
 			"Insufficient hit points for calculating node location and rotation.", ELogLevel::Warning);
@@ -511,8 +822,8 @@ bool UResourceRouletteUtility::CalculateLocationAndRotationForNode(FResourceNode
 	NodeData.Location.Z = FMath::Lerp(NodeData.Location.Z, AverageZ, 0.75f);
 
 	// Calculate best-fit plane normal and set rotation
-	FVector PlaneNormal = CalculateBestFitPlaneNormal(HitPoints);
-	FQuat RotationQuat = FQuat::FindBetweenNormals(FVector::UpVector, PlaneNormal);
+	const FVector Normal = PlaneNormal ? *PlaneNormal : CalculateBestFitPlaneNormal(HitPoints);
+	FQuat RotationQuat = FQuat::FindBetweenNormals(FVector::UpVector, Normal);
 	NodeData.Rotation = RotationQuat.Rotator();
 
 	// Mark node as raycasted
@@ -521,58 +832,23 @@ bool UResourceRouletteUtility::CalculateLocationAndRotationForNode(FResourceNode
 }
 
 
-/// Uses RANSAC to find a best fit plane. It's overkill, but also nice and this only has to run
-/// once per node as you come across it (results are serialized to savefile) and I like nice things
+/// Least squares plane through the hits, seeded and reweighted to shrug off rocks and foundations. Used to be
+/// RANSAC, but that picked random triangles so the same node could settle differently on each machine
 /// @param Points Points to check
 /// @return Returns the normal of best plane
 FVector UResourceRouletteUtility::CalculateBestFitPlaneNormal(const TArray<FVector>& Points)
 {
 	RR_PROFILE();
-	const int MaxIterations = 50; // How many iterations can we run
-	const float DistanceThreshold = 50.0f;
-	// How far can our point be off plane and still be "in" the plane - 30cm seems good
-	int BestInlierCount = 0;
-	FVector BestPlaneNormal = FVector::UpVector;
-
-	for (int i = 0; i < MaxIterations; ++i)
-	{
-		int Index1 = FMath::RandRange(0, Points.Num() - 1);
-		int Index2 = FMath::RandRange(0, Points.Num() - 1);
-		int Index3 = FMath::RandRange(0, Points.Num() - 1);
-		while (Index2 == Index1)
-		{
-			Index2 = FMath::RandRange(0, Points.Num() - 1);
-		}
-		while (Index3 == Index1 || Index3 == Index2)
-		{
-			Index3 = FMath::RandRange(0, Points.Num() - 1);
-		}
-		FVector P1 = Points[Index1];
-		FVector P2 = Points[Index2];
-		FVector P3 = Points[Index3];
-		FVector PlaneNormal = FVector::CrossProduct(P2 - P1, P3 - P1).GetSafeNormal();
-		int InlierCount = 0;
-		for (const FVector& Point : Points)
-		{
-			float Distance = FMath::Abs(FVector::DotProduct(Point - P1, PlaneNormal));
-			if (Distance < DistanceThreshold)
-			{
-				InlierCount++;
-			}
-		}
-		if (InlierCount > BestInlierCount)
-		{
-			BestInlierCount = InlierCount;
-			BestPlaneNormal = PlaneNormal;
-		}
-	}
-
-	// We can get inverted normals depending on where we start looking, so fix that
-	if (BestPlaneNormal.Z < 0)
+	TArray<ResourceRouletteCore::FVec3, TInlineAllocator<NumSettleTracePoints>> CorePoints;
+	CorePoints.Reserve(Points.Num());
+	for (const FVector& Point : Points)
 	{
-		BestPlaneNormal *= -1;
+		CorePoints.Add({Point.X, Point.Y, Point.Z});
 	}
-	return BestPlaneNormal;
+
+	const ResourceRouletteCore::FVec3 Normal = ResourceRouletteCore::FitPlaneNormal(
+		CorePoints.GetData(), CorePoints.Num());
+	return FVector(Normal.X, Normal.Y, Normal.Z);
 }
 
 /// Associates Miners with the closest node. Useful for reloading a save since we respawn all the nodes
@@ -598,6 +874,21 @@ void UResourceRouletteUtility::AssociateExtractorsWithNodes(
 	const float MinerAssociationRadius = 700.0f; // 7m
 	const float PortableMinerRadius = 1500.0f; // 15m
 
+	// Index the spawned nodes once so each miner only looks at the nodes around it
+	TArray<AFGResourceNode*> IndexedNodes;
+	std::vector<ResourceRouletteCore::FVec3> IndexedNodeLocations;
+	IndexedNodes.Reserve(ProcessedNodes.Num());
+	IndexedNodeLocations.reserve(ProcessedNodes.Num());
+	for (const FResourceNodeData& NodeData : ProcessedNodes)
+	{
+		if (AFGResourceNode* Node = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
+		{
+			IndexedNodes.Add(Node);
+			IndexedNodeLocations.push_back({NodeData.Location.X, NodeData.Location.Y, NodeData.Location.Z});
+		}
+	}
+	const ResourceRouletteCore::FResourceLocationGrid NodeGrid(std::move(IndexedNodeLocations), PortableMinerRadius);
+
 	// Handle Solid Miners
 	for (TActorIterator<AFGBuildableResourceExtractor> It(World); It; ++It)
 	{
@@ -629,31 +920,14 @@ void UResourceRouletteUtility::AssociateExtractorsWithNodes(
 		}
 
 		FVector ExtractorLocation = ResourceExtractor->GetActorLocation() - FVector(0.0f, 0.0f, 150.0f);
-		AFGResourceNode* ClosestNode = nullptr;
-		float ClosestDistance = MinerAssociationRadius;
-
-		for (const FResourceNodeData& NodeData : ProcessedNodes)
-		{
-			if (AFGResourceNode* Node = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
+		const int32 ClosestIndex = NodeGrid.FindNearest(
+			{ExtractorLocation.X, ExtractorLocation.Y, ExtractorLocation.Z}, MinerAssociationRadius,
+			[&IndexedNodes, ResourceExtractor](const int32 Index)
 			{
-				if (!Node || Node->IsOccupied())
-				{
-					continue;
-				}
-
-				if (!ResourceExtractor->IsAllowedOnResource(Node))
-				{
-					continue;
-				}
-
-				float Distance = FVector::Dist(ExtractorLocation, NodeData.Location);
-				if (Distance < ClosestDistance)
-				{
-					ClosestNode = Node;
-					ClosestDistance = Distance;
-				}
-			}
-		}
+				AFGResourceNode* Node = IndexedNodes[Index];
+				return Node && !Node->IsOccupied() && ResourceExtractor->IsAllowedOnResource(Node);
+			});
+		AFGResourceNode* ClosestNode = ClosestIndex != INDEX_NONE ? IndexedNodes[ClosestIndex] : nullptr;
 
 		if (ClosestNode)
 		{
@@ -696,19 +970,11 @@ void UResourceRouletteUtility::AssociateExtractorsWithNodes(
 			}
 		}
 
-		float ClosestDistance = PortableMinerRadius;
-
-		for (const FResourceNodeData& NodeData : ProcessedNodes)
+		const int32 ClosestIndex = NodeGrid.FindNearest({MinerLocation.X, MinerLocation.Y, MinerLocation.Z},
+		                                                PortableMinerRadius, [](int32) { return true; });
+		if (ClosestIndex != INDEX_NONE)
 		{
-			if (AFGResourceNode* Node = SpawnedResourceNodes.FindRef(NodeData.NodeGUID))
-			{
-				float Distance = FVector::Dist(MinerLocation, NodeData.Location);
-				if (Distance < ClosestDistance)
-				{
-					ClosestNode = Node;
-					ClosestDistance = Distance;
-				}
-			}
+			ClosestNode = IndexedNodes[ClosestIndex];
 		}
 
 		if (ClosestNode)
@@ -945,3 +1211,54 @@ void UResourceRouletteUtility::ScannerGenerateNodeClusters(UWorld* World, float
 		// FString::Printf(TEXT("ScannerGenerateNodeClusters: Generated %d clusters across %d threads"),
 		                // NodeClusters.Num(), NumThreads), ELogLevel::Warning);
 }
+
+/// Moves the scanner cluster midpoints of clusters that have a node that settled since they were built. Clusters
+/// keep their nodes, settling only nudges a node up or down
+/// @param World World context
+/// @param MovedNodes Nodes that moved and where they are now
+void UResourceRouletteUtility::ScannerUpdateNodeClusters(UWorld* World,
+                                                         const TMap<const AFGResourceNodeBase*, FVector>& MovedNodes)
+{
+	RR_PROFILE();
+	if (!World || MovedNodes.IsEmpty())
+	{
+		return;
+	}
+	AFGResourceScanner* ResourceScanner = Cast<AFGResourceScanner>(
+		UGameplayStatics::GetActorOfClass(World, AFGResourceScanner::StaticClass()));
+	if (!ResourceScanner)
+	{
+		return;
+	}
+
+	int32 NumClustersUpdated = 0;
+	for (FNodeClusterData& Cluster : ResourceScanner->mNodeClusters)
+	{
+		bool bHasMovedNode = false;
+		FVector Sum = FVector::ZeroVector;
+		for (const AFGResourceNodeBase* ClusterNode : Cluster.Nodes)
+		{
+			if (!ClusterNode)
+			{
+				continue;
+			}
+			if (const FVector* MovedLocation = MovedNodes.Find(ClusterNode))
+			{
+				Sum += *MovedLocation;
+				bHasMovedNode = true;
+			}
+			else
+			{
+				Sum += ClusterNode->GetActorLocation();
+			}
+		}
+		if (bHasMovedNode)
+		{
+			Cluster.MidPoint = Sum / Cluster.Nodes.Num();
+			NumClustersUpdated++;
+		}
+	}
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("ScannerUpdateNodeClusters: %d nodes moved, %d clusters updated"), MovedNodes.Num(),
+		                NumClustersUpdated), ELogLevel::Debug);
+}
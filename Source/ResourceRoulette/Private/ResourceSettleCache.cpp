@@ -0,0 +1,138 @@
+﻿#include "ResourceSettleCache.h"
+#include "ResourceCollectionManager.h"
+#include "ResourceRouletteProfiler.h"
+#include "ResourceRouletteUtility.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+/// Reuse settle results from earlier sessions on the same map instead of tracing again
+static TAutoConsoleVariable<int32> CVarSettleCache(
+	TEXT("ResourceRoulette.SettleCache"), 1,
+	TEXT("1 = place nodes on candidate locations that were settled before from the per-map settle cache, 0 = always trace"),
+	ECVF_Default
+);
+
+static constexpr uint32 SettleCacheMagic = 0x43535252; // RRSC
+/// Bump whenever settling changes how it places nodes, old cache files get thrown away
+static constexpr int32 SettleCacheVersion = 1;
+/// Candidates are vanilla node positions metres apart, 10cm buckets only soak up float noise from saves
+static constexpr double SettleCacheQuantization = 10.0;
+
+/// Loads the cache file for the world's map, does nothing if that map's cache is already loaded
+/// @param World World context
+void FResourceSettleCache::LoadForWorld(const UWorld* World)
+{
+	RR_PROFILE();
+	if (!World)
+	{
+		return;
+	}
+
+	const FString MapName = UWorld::RemovePIEPrefix(World->GetMapName());
+	const FString FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ResourceRoulette"),
+	                                         FString::Printf(TEXT("SettleCache_%s.bin"), *MapName));
+	if (FilePath == CacheFilePath)
+	{
+		return;
+	}
+	Save();
+	CacheFilePath = FilePath;
+	Entries.Reset();
+	bIsDirty = false;
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *CacheFilePath, FILEREAD_Silent))
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("No settle cache for %s yet"), *MapName), ELogLevel::Debug);
+		return;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != SettleCacheMagic || Version != SettleCacheVersion)
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("Ignoring outdated settle cache %s"), *CacheFilePath), ELogLevel::Warning);
+		return;
+	}
+	Reader << Entries;
+	if (Reader.IsError())
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("Settle cache %s is corrupt, starting over"), *CacheFilePath), ELogLevel::Warning);
+		Entries.Reset();
+		return;
+	}
+
+	FResourceRouletteUtilityLog::Get().LogMessage(
+		FString::Printf(TEXT("Loaded %d settled locations from %s"), Entries.Num(), *CacheFilePath), ELogLevel::Debug);
+}
+
+/// Writes the cache back if anything was added since the last save
+void FResourceSettleCache::Save()
+{
+	RR_PROFILE();
+	if (!bIsDirty || CacheFilePath.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+	uint32 Magic = SettleCacheMagic;
+	int32 Version = SettleCacheVersion;
+	Writer << Magic << Version << Entries;
+	if (!FFileHelper::SaveArrayToFile(FileData, *CacheFilePath))
+	{
+		FResourceRouletteUtilityLog::Get().LogMessage(
+			FString::Printf(TEXT("Couldn't write settle cache %s"), *CacheFilePath), ELogLevel::Error);
+		return;
+	}
+	bIsDirty = false;
+}
+
+/// Settles a node from the cache if its location was settled before
+/// @param NodeData Node sitting on its candidate location, updated in place on a hit
+/// @return true if the node is settled now
+bool FResourceSettleCache::Apply(FResourceNodeData& NodeData) const
+{
+	if (CVarSettleCache.GetValueOnGameThread() == 0)
+	{
+		return false;
+	}
+	const FResourceSettleCacheEntry* Entry = Entries.Find(QuantizeLocation(NodeData.Location));
+	if (!Entry)
+	{
+		return false;
+	}
+	NodeData.Location.Z = Entry->SettledZ;
+	NodeData.Rotation = Entry->Rotation;
+	NodeData.IsRayCasted = true;
+	return true;
+}
+
+/// Remembers where a node on this candidate location settled
+/// @param CandidateLocation Location the node had before settling
+/// @param SettledNode The node after settling
+void FResourceSettleCache::Add(const FVector& CandidateLocation, const FResourceNodeData& SettledNode)
+{
+	if (CVarSettleCache.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+	Entries.Add(QuantizeLocation(CandidateLocation), {SettledNode.Location.Z, SettledNode.Rotation});
+	bIsDirty = true;
+}
+
+FIntVector FResourceSettleCache::QuantizeLocation(const FVector& Location)
+{
+	return FIntVector(FMath::RoundToInt32(Location.X / SettleCacheQuantization),
+	                  FMath::RoundToInt32(Location.Y / SettleCacheQuantization),
+	                  FMath::RoundToInt32(Location.Z / SettleCacheQuantization));
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+
+// Engine-free types shared by the randomizer core. Nothing in RandomizerCore may include engine headers,
+// so the whole pipeline can be built and profiled outside the game (see Benchmarks/)
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace ResourceRouletteCore
+{
+	/// Same order and values as EResourcePurity so the two can be cast back and forth
+	enum class EPurity : uint8_t
+	{
+		Impure = 0,
+		Normal = 1,
+		Pure = 2,
+		Max = 3
+	};
+
+	struct FVec3
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+	};
+
+	inline double DistSquared(const FVec3& A, const FVec3& B)
+	{
+		const double DX = A.X - B.X;
+		const double DY = A.Y - B.Y;
+		const double DZ = A.Z - B.Z;
+		return DX * DX + DY * DY + DZ * DZ;
+	}
+
+	/// Same sequence as FRandomStream, so a seed gives the same layout inside and outside the engine
+	class FSeededRandomStream
+	{
+	public:
+		explicit FSeededRandomStream(const int32_t InSeed) : Seed(static_cast<uint32_t>(InSeed))
+		{
+		}
+
+		float GetFraction()
+		{
+			MutateSeed();
+			const uint32_t Bits = 0x3F800000U | (Seed >> 9);
+			float Result;
+			std::memcpy(&Result, &Bits, sizeof(Result));
+			return Result - 1.0f;
+		}
+
+		int32_t RandHelper(const int32_t A)
+		{
+			return A > 0 ? std::min(static_cast<int32_t>(GetFraction() * static_cast<float>(A)), A - 1) : 0;
+		}
+
+		int32_t RandRange(const int32_t Min, const int32_t Max)
+		{
+			const int32_t Range = (Max - Min) + 1;
+			return Min + RandHelper(Range);
+		}
+
+	private:
+		void MutateSeed()
+		{
+			Seed = (Seed * 196314165U) + 907633515U;
+		}
+
+		uint32_t Seed;
+	};
+
+	/// Counter based generator, every number is a pure function of (seed, stream, counter). Tasks can each get
+	/// their own stream derived from the global seed and produce the same numbers no matter which thread runs them
+	class FCounterRandomStream
+	{
+	public:
+		FCounterRandomStream(const int32_t InSeed, const uint32_t InStream)
+			: Key(Mix((static_cast<uint64_t>(static_cast<uint32_t>(InSeed)) << 32) | InStream))
+		{
+		}
+
+		uint32_t GetUnsignedInt()
+		{
+			return static_cast<uint32_t>(Mix(Key + ++Counter * 0x9E3779B97F4A7C15ULL) >> 32);
+		}
+
+		/// Inclusive on both ends like FSeededRandomStream::RandRange
+		int32_t RandRange(const int32_t Min, const int32_t Max)
+		{
+			const uint64_t Range = static_cast<uint64_t>(static_cast<int64_t>(Max) - Min + 1);
+			return Max < Min ? Min : Min + static_cast<int32_t>((GetUnsignedInt() * Range) >> 32);
+		}
+
+	private:
+		/// SplitMix64 finalizer
+		static uint64_t Mix(uint64_t Value)
+		{
+			Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBULL;
+			return Value ^ (Value >> 31);
+		}
+
+		uint64_t Key;
+		uint64_t Counter = 0;
+	};
+}
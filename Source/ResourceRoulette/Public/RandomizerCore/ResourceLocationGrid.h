@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace ResourceRouletteCore
+{
+	/// Uniform grid over a fixed list of candidate locations so radius queries only look at nearby cells
+	/// instead of every location. Locations keep the index they were given, removing one just marks it
+	/// as consumed so nothing ever has to be shifted around
+	class FResourceLocationGrid
+	{
+	public:
+		FResourceLocationGrid(std::vector<FVec3> InLocations, double InCellSize);
+
+		int32_t Num() const { return NumRemaining; }
+		int32_t GetLastRemainingIndex() const { return LastRemainingIndex; }
+		bool IsRemaining(const int32_t Index) const { return RemainingFlags[Index] != 0; }
+		const FVec3& GetLocation(const int32_t Index) const { return Locations[Index]; }
+
+		void Remove(int32_t Index);
+		void QueryRadius(const FVec3& Center, double Radius, std::vector<int32_t>& OutIndexes) const;
+		void GetRemainingLocations(std::vector<FVec3>& OutLocations) const;
+
+		/// Closest remaining location strictly within Radius that Predicate accepts. Predicate is only asked
+		/// about locations that would beat the current best, ties go to the lower index
+		/// @param Center Location to search around
+		/// @param Radius Search radius
+		/// @param Predicate Called with a location index, return false to skip it
+		/// @return Index of the closest location, -1 if there isn't one
+		template <typename PredicateType>
+		int32_t FindNearest(const FVec3& Center, const double Radius, PredicateType&& Predicate) const
+		{
+			int32_t BestIndex = -1;
+			double BestDistSquared = Radius * Radius;
+			ForEachInRadius(Center, Radius, [&](const int32_t Index, const double IndexDistSquared)
+			{
+				const bool bBeatsBest = IndexDistSquared < BestDistSquared ||
+					(BestIndex != -1 && IndexDistSquared == BestDistSquared && Index < BestIndex);
+				if (bBeatsBest && Predicate(Index))
+				{
+					BestIndex = Index;
+					BestDistSquared = IndexDistSquared;
+				}
+			});
+			return BestIndex;
+		}
+
+	private:
+		struct FCellRange
+		{
+			int32_t Start;
+			int32_t Count;
+		};
+
+		/// Calls Visitor(Index, DistSquared) for every remaining location within Radius of Center
+		template <typename VisitorType>
+		void ForEachInRadius(const FVec3& Center, const double Radius, VisitorType&& Visitor) const
+		{
+			const int64_t CellX = GetCellCoord(Center.X);
+			const int64_t CellY = GetCellCoord(Center.Y);
+			const int64_t CellZ = GetCellCoord(Center.Z);
+			const int64_t CellReach = static_cast<int64_t>(std::ceil(Radius / CellSize));
+			const double RadiusSquared = Radius * Radius;
+
+			for (int64_t X = CellX - CellReach; X <= CellX + CellReach; ++X)
+			{
+				for (int64_t Y = CellY - CellReach; Y <= CellY + CellReach; ++Y)
+				{
+					for (int64_t Z = CellZ - CellReach; Z <= CellZ + CellReach; ++Z)
+					{
+						const auto It = Cells.find(MakeCellKey(X, Y, Z));
+						if (It == Cells.end())
+						{
+							continue;
+						}
+						const int32_t End = It->second.Start + It->second.Count;
+						for (int32_t i = It->second.Start; i < End; ++i)
+						{
+							const int32_t Index = CellIndexes[i];
+							if (!RemainingFlags[Index])
+							{
+								continue;
+							}
+							const double IndexDistSquared = DistSquared(Center, Locations[Index]);
+							if (IndexDistSquared <= RadiusSquared)
+							{
+								Visitor(Index, IndexDistSquared);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		int64_t GetCellCoord(double Value) const;
+		static uint64_t MakeCellKey(int64_t X, int64_t Y, int64_t Z);
+
+		std::vector<FVec3> Locations;
+		std::vector<uint8_t> RemainingFlags;
+		// Location indexes sorted by cell, each cell owns one contiguous run of it
+		std::vector<int32_t> CellIndexes;
+		std::unordered_map<uint64_t, FCellRange> Cells;
+		double CellSize;
+		int32_t NumRemaining;
+		int32_t LastRemainingIndex;
+	};
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+#include <vector>
+
+namespace ResourceRouletteCore
+{
+	/// The few node fields the per-frame loops look at, stored as separate arrays instead of inside the full node
+	/// struct. A radius sweep reads 12 bytes of position and one bit per node instead of striding over everything
+	/// the save needs, so the whole table stays in cache and the distance checks run through the SIMD kernel
+	class FResourceNodeTable
+	{
+	public:
+		void Reset(size_t NumNodes);
+		void Add(const FVec3& Location, bool bSettled);
+
+		int32_t Num() const { return static_cast<int32_t>(X.size()); }
+		FVec3 GetLocation(const int32_t Index) const { return {X[Index], Y[Index], Z[Index]}; }
+		bool IsSettled(const int32_t Index) const { return (SettledBits[Index / 64] >> (Index % 64)) & 1; }
+
+		void MarkSettled(int32_t Index, double SettledZ);
+		void QueryUnsettledInRadius(const FVec3& Center, double Radius, std::vector<int32_t>& OutIndexes) const;
+		void QueryUnsettledNearCenters(const std::vector<FVec3>& Centers, double Radius,
+		                               std::vector<int32_t>& OutIndexes) const;
+		int32_t NumUnsettled() const { return NumUnsettledNodes; }
+
+		/// Nodes that changed since the last TakeDirtyIndexes, so whoever mirrors node data only redoes those
+		void MarkDirty(int32_t Index);
+		bool HasDirty() const { return !DirtyIndexes.empty(); }
+		void TakeDirtyIndexes(std::vector<int32_t>& OutIndexes);
+
+		/// Which nodes are close enough to a player to need their full actor, new nodes start out active
+		bool IsActive(const int32_t Index) const { return (ActiveBits[Index / 64] >> (Index % 64)) & 1; }
+		int32_t NumActive() const { return NumActiveNodes; }
+		void UpdateActiveNodes(const std::vector<FVec3>& Centers, double ActivateRadius, double DeactivateRadius,
+		                       std::vector<int32_t>& OutActivated, std::vector<int32_t>& OutDeactivated);
+		void ActivateAll(std::vector<int32_t>& OutActivated);
+
+	private:
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+		// One bit per node, 64 nodes to a word
+		std::vector<uint64_t> SettledBits;
+		int32_t NumUnsettledNodes = 0;
+		// Same layout as SettledBits, the list keeps taking them proportional to how many changed
+		std::vector<uint64_t> DirtyBits;
+		std::vector<int32_t> DirtyIndexes;
+		std::vector<uint64_t> ActiveBits;
+		int32_t NumActiveNodes = 0;
+	};
+}
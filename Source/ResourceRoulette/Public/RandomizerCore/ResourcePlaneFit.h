@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+
+namespace ResourceRouletteCore
+{
+	/// Least squares plane through a set of points, seeded from the fixed point triple most of them agree with and
+	/// refit twice with robust weights so hits on rocks or foundations don't tilt the result. No randomness, the same
+	/// points give the same normal on every machine
+	/// @param Points Points to fit, usually terrain hits around a node
+	/// @param NumPoints How many points there are
+	/// @param MinCutoff Floor for the outlier cutoff, which otherwise comes from the spread of the points
+	/// @return Unit normal with Z >= 0, straight up if the points don't define a plane
+	FVec3 FitPlaneNormal(const FVec3* Points, int32_t NumPoints, double MinCutoff = 1.0);
+
+	/// Root mean square distance of the points from the plane with this normal through their centroid, how well a
+	/// fit actually explains them
+	/// @param Points Points that were fit
+	/// @param NumPoints How many points there are
+	/// @param Normal Unit normal of the plane
+	double GetPlaneRmsDistance(const FVec3* Points, int32_t NumPoints, const FVec3& Normal);
+}
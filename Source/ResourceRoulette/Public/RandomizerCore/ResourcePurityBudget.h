@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+#include <atomic>
+#include <vector>
+
+namespace ResourceRouletteCore
+{
+	/// Remaining node count per class and purity. Classes are dense indexes and each one gets a row of three
+	/// counts in one flat array, so a lookup is a multiply and an add instead of two hash lookups
+	class FPurityBudget
+	{
+	public:
+		FPurityBudget() = default;
+
+		explicit FPurityBudget(const int32_t NumClasses) : Counts(static_cast<size_t>(NumClasses) * NumPurities, 0)
+		{
+		}
+
+		int32_t GetNumClasses() const { return static_cast<int32_t>(Counts.size() / NumPurities); }
+
+		/// Adds a zeroed row for a new class
+		/// @return Index of the new class
+		int32_t AddClass()
+		{
+			Counts.resize(Counts.size() + NumPurities, 0);
+			return GetNumClasses() - 1;
+		}
+
+		bool IsValid(const int32_t ClassIndex, const EPurity Purity) const
+		{
+			return ClassIndex >= 0 && ClassIndex < GetNumClasses() && Purity < EPurity::Max;
+		}
+
+		/// Caller makes sure the index is valid
+		int32_t& At(const int32_t ClassIndex, const EPurity Purity) { return Counts[ToFlatIndex(ClassIndex, Purity)]; }
+		int32_t At(const int32_t ClassIndex, const EPurity Purity) const
+		{
+			return Counts[ToFlatIndex(ClassIndex, Purity)];
+		}
+
+		/// Safe to call from several threads at once, never takes a count below zero
+		/// @return True if there was one left to take
+		bool TryDecrementAtomic(const int32_t ClassIndex, const EPurity Purity)
+		{
+			if (!IsValid(ClassIndex, Purity))
+			{
+				return false;
+			}
+			std::atomic_ref<int32_t> Count(Counts[ToFlatIndex(ClassIndex, Purity)]);
+			int32_t Current = Count.load(std::memory_order_relaxed);
+			while (Current > 0)
+			{
+				if (Count.compare_exchange_weak(Current, Current - 1, std::memory_order_relaxed))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+	private:
+		static constexpr size_t NumPurities = static_cast<size_t>(EPurity::Max);
+
+		static size_t ToFlatIndex(const int32_t ClassIndex, const EPurity Purity)
+		{
+			return static_cast<size_t>(ClassIndex) * NumPurities + static_cast<size_t>(Purity);
+		}
+
+		std::vector<int32_t> Counts;
+	};
+
+	inline bool IsPurityAvailable(const FPurityBudget& Budget, const int32_t ClassIndex, const EPurity Purity)
+	{
+		return Budget.IsValid(ClassIndex, Purity) && Budget.At(ClassIndex, Purity) > 0;
+	}
+
+	inline void DecrementAvailablePurity(FPurityBudget& Budget, const int32_t ClassIndex, const EPurity Purity)
+	{
+		if (IsPurityAvailable(Budget, ClassIndex, Purity))
+		{
+			--Budget.At(ClassIndex, Purity);
+		}
+	}
+}
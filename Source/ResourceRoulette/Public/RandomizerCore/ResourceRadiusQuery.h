@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+#include <cstddef>
+#include <vector>
+
+namespace ResourceRouletteCore
+{
+	/// Positions stored as three float arrays, the layout the radius kernels want
+	struct FPackedPositions
+	{
+		const float* X = nullptr;
+		const float* Y = nullptr;
+		const float* Z = nullptr;
+		size_t Num = 0;
+	};
+
+	enum class ERadiusQueryKernel : uint8_t
+	{
+		// Whatever the CPU running this supports best
+		Best,
+		Scalar,
+		SSE,
+		AVX2
+	};
+
+	/// @return true if this build and CPU can run the kernel
+	bool IsRadiusQueryKernelSupported(ERadiusQueryKernel Kernel);
+	const char* GetRadiusQueryKernelName(ERadiusQueryKernel Kernel);
+
+	/// Sets bit i of OutMask for every position i within Radius of Center (squared distance compare, inclusive)
+	/// @param Positions Positions to check
+	/// @param Center Query point
+	/// @param Radius Query radius
+	/// @param OutMask (Positions.Num + 63) / 64 words, 64 positions per word, unused bits of the last one are cleared
+	/// @param Kernel Which implementation to run, falls back to scalar if it isn't supported
+	void QueryRadiusMask(const FPackedPositions& Positions, const FVec3& Center, double Radius, uint64_t* OutMask,
+	                     ERadiusQueryKernel Kernel = ERadiusQueryKernel::Best);
+
+	/// Same query against several centers at once. Every position is loaded once and checked against all of them,
+	/// keeping its squared distance to the nearest one, so the caller can order by it without measuring again
+	/// @param Positions Positions to check
+	/// @param Centers Query points
+	/// @param NumCenters How many there are
+	/// @param Radius Query radius around each center
+	/// @param OutMask Same layout as QueryRadiusMask, set for positions within Radius of any center
+	/// @param OutNearestDistSquared Positions.Num floats, squared distance to the nearest center
+	/// @param SkipMask Optional, same layout as OutMask. Words with every position's bit set aren't checked at all,
+	/// their OutMask word comes back 0 and their distances are left as they were
+	/// @param Kernel Which implementation to run, falls back to scalar if it isn't supported
+	void QueryNearestRadiusMask(const FPackedPositions& Positions, const FVec3* Centers, size_t NumCenters,
+	                            double Radius, uint64_t* OutMask, float* OutNearestDistSquared,
+	                            const uint64_t* SkipMask = nullptr,
+	                            ERadiusQueryKernel Kernel = ERadiusQueryKernel::Best);
+
+	/// Same query, but as a list of the indexes within Radius in ascending order
+	/// @param Positions Positions to check
+	/// @param Center Query point
+	/// @param Radius Query radius
+	/// @param OutIndexes Cleared and filled
+	void QueryRadiusIndexes(const FPackedPositions& Positions, const FVec3& Center, double Radius,
+	                        std::vector<int32_t>& OutIndexes);
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include "RandomizerCore/ResourceCoreTypes.h"
+#include "RandomizerCore/ResourcePurityBudget.h"
+#include <functional>
+#include <vector>
+
+namespace ResourceRouletteCore
+{
+	/// One row of the node table handed to the randomizer
+	struct FNodeEntry
+	{
+		FVec3 Location;
+		// Index into FRandomizerOptions::Classes, INDEX_NONE style -1 for nodes without a known class
+		int32_t ClassIndex = -1;
+		EPurity Purity = EPurity::Normal;
+		// Randomizable class but must never be moved or kept, e.g. the fracking oil nodes
+		bool bExcluded = false;
+	};
+
+	struct FResourceClassInfo
+	{
+		bool bRandomize = false;
+		bool bGroupable = true;
+	};
+
+	struct FPurityZone
+	{
+		double CenterX = 0.0;
+		double CenterY = 0.0;
+		double Radius = 0.0;
+		EPurity Purity = EPurity::Impure;
+	};
+
+	/// Runs Task for every index in [0, NumTasks), in any order and on any thread
+	using FParallelForFunction = std::function<void(int32_t NumTasks, const std::function<void(int32_t)>& Task)>;
+
+	struct FRandomizerOptions
+	{
+		int32_t Seed = 0;
+		double GroupingRadius = 4000.0;
+		int32_t MaxNodesPerGroup = 5;
+		bool bUsePurityExclusion = false;
+		bool bUseFullRandomization = false;
+		// Indexed by FNodeEntry::ClassIndex. Indexes must follow the classes' sort order since nodes are sorted by it
+		std::vector<FResourceClassInfo> Classes;
+		// Pool of class indexes full randomization picks from, in pick order
+		std::vector<int32_t> FullRandomizationClasses;
+		std::vector<FPurityZone> PurityZones;
+		// Deals the locations out per class up front and randomizes every class on its own random stream, which
+		// gives a different layout than the default single pass but one that's the same for any thread count
+		bool bParallelByClass = false;
+		// Used by bParallelByClass, the classes run one after another on the calling thread if this is empty
+		FParallelForFunction ParallelFor;
+	};
+
+	struct FNodeAssignment
+	{
+		// Index into the node table this node takes everything but location and purity from
+		int32_t SourceNode = -1;
+		FVec3 Location;
+		EPurity Purity = EPurity::Max;
+	};
+
+	struct FRandomizerResult
+	{
+		// Untouched nodes first, then randomized nodes in the order they were placed
+		std::vector<FNodeAssignment> Assignments;
+		int32_t NumMissingSourceNodes = 0;
+		int32_t NumPurityShortfalls = 0;
+	};
+
+	/// Runs the whole randomization pipeline (filter, sort, shuffle, group, assign purities) over a node table
+	/// @param Nodes Node table, every collected node
+	/// @param Budget Purity budget, decremented as nodes are placed
+	/// @param Options Settings and per class info
+	/// @return Where each node ended up and with which purity
+	FRandomizerResult RandomizeNodes(const std::vector<FNodeEntry>& Nodes, FPurityBudget& Budget,
+	                                 const FRandomizerOptions& Options);
+}
@@ -66,6 +66,8 @@ struct FResourceNodeData
 	UPROPERTY(SaveGame)	bool bCanPlaceResourceExtractor = false;
 	UPROPERTY(SaveGame)	bool bIsOccupied = false;
 	UPROPERTY(SaveGame)	bool IsRayCasted = false;
+	// Settle traces spent on this node this session, not saved
+	UPROPERTY()	int32 NumSettleTraces = 0;
 	UPROPERTY(SaveGame)	FGuid NodeGUID;
 	// UPROPERTY() FResourceNodeVisualData VisualData;
 };
@@ -78,8 +80,8 @@ class RESOURCEROULETTE_API UResourceCollectionManager : public UObject
 
 public:
 	UResourceCollectionManager();
-	TArray<FResourceNodeData>& GetCollectedResourceNodes() { return CollectedResourceNodes; }
-	void SetCollectedResourcesNodes(const TArray<FResourceNodeData>& InCollectedResourceNodes);
+	// Hands the nodes from the last scan over to whoever keeps them, leaves this one empty
+	TArray<FResourceNodeData> TakeCollectedResourceNodes() { return MoveTemp(CollectedResourceNodes); }
 	void CollectWorldResources(const UWorld* World);
 	// FResourceNodeVisualData CollectMeshData(AFGResourceNode* ResourceNode);
 	void LogCollectedResources() const;
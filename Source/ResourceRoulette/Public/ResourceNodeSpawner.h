@@ -3,19 +3,38 @@
 #include "CoreMinimal.h"
 #include "ResourceAssets.h"
 #include "ResourceCollectionManager.h"
-#include "ResourceNodeRandomizer.h"
 #include "ResourceRouletteSeedManager.h"
 #include "Resources/FGResourceNode.h"
+#include "Engine/StreamableManager.h"
 #include "ResourceNodeSpawner.generated.h"
 
+class AResourceRouletteSubsystem;
+class UHierarchicalInstancedStaticMeshComponent;
+
+/// Everything spawning needs for one resource class, resolved once and reused for every node of it
+USTRUCT()
 struct FResourceNodeCache
 {
-	UStaticMesh* Mesh;
-	TArray<UMaterialInterface*> Materials;
-	UClass* Classname;
-	UMaterialInterface* DecalMaterial;
+	GENERATED_BODY()
+
+	UPROPERTY()	UStaticMesh* Mesh = nullptr;
+	UPROPERTY()	TArray<UMaterialInterface*> Materials;
+	UPROPERTY()	UClass* ResourceClass = nullptr;
+	UPROPERTY()	UMaterialInterface* DecalMaterial = nullptr;
+	bool bSolidAssetsLoaded = false;
+	bool bDecalAssetsLoaded = false;
+	// Materials and decal materials a headless server didn't load
+	int32 NumAssetsSkipped = 0;
 };
 
+/// Which instance of the per class instanced mesh a spawned node's rock is
+struct FResourceNodeMeshInstance
+{
+	FName ResourceClass;
+	int32 InstanceIndex = INDEX_NONE;
+};
+
+DECLARE_DELEGATE(FOnResourceSpawningComplete);
 
 UCLASS()
 class RESOURCEROULETTE_API UResourceNodeSpawner : public UObject
@@ -25,18 +44,71 @@ class RESOURCEROULETTE_API UResourceNodeSpawner : public UObject
 public:
 	UResourceNodeSpawner();
 
-	void SpawnWorldResources(UWorld* World, UResourceNodeRandomizer* InNodeRandomizer, bool IsFromSaved);
+	void SpawnWorldResources(UWorld* World, const FOnResourceSpawningComplete& OnComplete);
+	void CancelSpawning();
+	bool IsSpawning() const { return bIsSpawning; }
 	bool SpawnResourceNodeDecal(UWorld* World, FResourceNodeData& NodeData,
 	                            const UResourceRouletteAssets* ResourceAssets);
 
 	TMap<FGuid, AFGResourceNode*>& GetSpawnedResourceNodes() { return SpawnedResourceNodes; }
 
+	const UPrimitiveComponent* GetNodeMeshInstances(const FGuid& NodeGUID) const;
+	bool UpdateNodeMeshInstance(const FResourceNodeData& NodeData);
+	void FlushNodeMeshInstanceMoves();
+	void ClearNodeMeshInstances();
+	void SetNodeCollision(AFGResourceNode* ResourceNode, const FResourceNodeData& NodeData, bool bEnabled);
+	void SetInstancedRocksRequired(const bool bRequired) { bInstancedRocksRequired = bRequired; }
+
+	void PreloadResourceAssets(const UWorld* World);
+
 private:
 	bool SpawnResourceNodeSolid(UWorld* World, FResourceNodeData& NodeData,
 	                            const UResourceRouletteAssets* ResourceAssets);
 
+	void ScheduleNextBatch();
+	void SpawnNextBatch();
+
+	void UpdateHeadlessMode(const UWorld* World);
+	void LogAssetStats() const;
+	const FResourceNodeCache& GetResourceNodeCache(const FName& ResourceClassName);
+	UClass* GetNodeActorClass(const FString& Classname);
+	UHierarchicalInstancedStaticMeshComponent* GetOrCreateNodeMeshInstances(const FName& ResourceClassName,
+	                                                                        const FResourceNodeCache& CachedAssets);
+	void AddNodeCollision(AFGResourceNode* ResourceNode, const FResourceNodeData& NodeData, UStaticMesh* CollisionMesh,
+	                      const FVector& MeshExtent) const;
+
+	// Keyed by resource class. Kept across rerolls since the assets never change
+	UPROPERTY()	TMap<FName, FResourceNodeCache> ResourceNodeCache;
+	UPROPERTY()	TMap<FString, UClass*> NodeActorClassCache;
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+	int32 CacheHits = 0;
+	int32 CacheMisses = 0;
+	int32 NumSyncLoads = 0;
+	double AssetLoadSeconds = 0.0;
+
+	// Dedicated server or -nullrhi, only what gameplay and collision need gets loaded and created
+	bool bHeadless = false;
+	int32 NumDecalsSkipped = 0;
+
 	UPROPERTY()	TMap<FGuid, AFGResourceNode*> SpawnedResourceNodes;
-	UPROPERTY()	UResourceNodeRandomizer* NodeRandomizer;
+	// Instanced rock meshes, one component per resource class on the subsystem actor
+	UPROPERTY()	TMap<FName, UHierarchicalInstancedStaticMeshComponent*> NodeMeshInstances;
+	TMap<FGuid, FResourceNodeMeshInstance> NodeMeshInstanceIndexes;
+	// Instance moves from this frame's settles by resource class and instance index, applied in one go per class
+	TMap<FName, TMap<int32, FTransform>> PendingMeshInstanceMoves;
+	// Node proxies keep nothing but the actor, so their rocks have to be instances whatever InstancedNodeMeshes says
+	bool bInstancedRocksRequired = false;
+	UPROPERTY()	UResourceRouletteAssets* ResourceAssets;
+
+	// Spawns straight from the subsystem's session nodes, by index
+	TWeakObjectPtr<AResourceRouletteSubsystem> NodeStore;
 
-	TArray<FResourceNodeData> ProcessedNodes;
+	// Batched spawning state
+	bool bIsSpawning = false;
+	int32 NextNodeToSpawn = 0;
+	int32 NumSpawnFrames = 0;
+	double SpawnStartTime = 0.0;
+	TWeakObjectPtr<UWorld> SpawnWorld;
+	FTimerHandle SpawnBatchTimerHandle;
+	FOnResourceSpawningComplete OnSpawningComplete;
 };
@@ -3,6 +3,7 @@
 #include "CoreMinimal.h"
 #include "Resources/FGResourceNode.h"
 #include "ResourceRouletteUtility.h"
+#include "RandomizerCore/ResourcePurityBudget.h"
 
 #include "ResourcePurityManager.generated.h"
 
@@ -24,24 +25,34 @@ class RESOURCEROULETTE_API UResourcePurityManager : public UObject
 public:
 	UResourcePurityManager();
 
-	void SetRemainingPurityCounts(const TMap<FName, TMap<EResourcePurity, int32>>& NewPurityCounts);
+	void SetRemainingPurities(const ResourceRouletteCore::FPurityBudget& NewRemainingPurities);
 
-	const TMap<FName, TMap<EResourcePurity, int32>>& GetRemainingPurityCounts() const;
-	const TMap<FName, TMap<EResourcePurity, int32>>& GetFoundPurityCounts() const;
+	const ResourceRouletteCore::FPurityBudget& GetRemainingPurities() const { return RemainingPurities; }
+	const ResourceRouletteCore::FPurityBudget& GetFoundPurities() const { return FoundPurities; }
+	const TArray<FName>& GetResourceClasses() const { return ResourceClasses; }
+	int32 GetResourceClassIndex(FName ResourceClass) const;
 	EResourcePurity GetZonePurity(const FVector& Location) const;
+	const TArray<FResourcePurityZone>& GetPurityZones() const { return PurityZones; }
 
 	bool IsPurityAvailable(const FName ResourceClass, const EResourcePurity Purity) const;
+	bool IsPurityAvailable(int32 ClassIndex, EResourcePurity Purity) const;
 	void DecrementAvailablePurities(const FName ResourceClass, const EResourcePurity Purity);
+	void DecrementAvailablePurities(int32 ClassIndex, EResourcePurity Purity);
+	bool TryDecrementAvailablePuritiesAtomic(int32 ClassIndex, EResourcePurity Purity);
 	void CollectWorldPurities(const UWorld* World);
 	void CollectOriginalPurities(const TArray<FResourceNodeData>& ResourceNodes);
 
 private:
 	void LogFoundPurities();
+	void ResetPurities();
 	void AddFoundPurity(FName ResourceClass, EResourcePurity Purity);
 	static bool IsValidPurityEnum(EResourcePurity Purity);
 
-	TMap<FName, TMap<EResourcePurity, int32>> FoundPurityCounts;
-	TMap<FName, TMap<EResourcePurity, int32>> RemainingPurityCounts;
+	// Resource classes get a dense index when they're first seen during a scan, the budgets are indexed by it
+	TArray<FName> ResourceClasses;
+	TMap<FName, int32> ResourceClassIndexes;
+	ResourceRouletteCore::FPurityBudget FoundPurities;
+	ResourceRouletteCore::FPurityBudget RemainingPurities;
 
 	UPROPERTY()	TArray<FResourcePurityZone> PurityZones;
 };
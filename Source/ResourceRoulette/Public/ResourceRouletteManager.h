@@ -6,8 +6,51 @@
 #include "ResourceCollectionManager.h"
 #include "ResourceNodeRandomizer.h"
 #include "ResourceNodeSpawner.h"
+#include "ResourceSettleCache.h"
+#include "RandomizerCore/ResourceNodeTable.h"
+#include "WorldCollision.h"
 #include "ResourceRouletteManager.generated.h"
 
+/// Where a time-sliced world update got to, so the next frame can pick it back up
+struct FResourceWorldUpdatePass
+{
+	enum class EPhase : uint8
+	{
+		Idle,
+		// Settling nodes near the player
+		Nodes,
+		// Sweeping the object array for vanilla meshes and decals
+		Components
+	};
+
+	EPhase Phase = EPhase::Idle;
+	// Every player with a pawn when the pass started
+	TArray<FVector> PlayerLocations;
+	// Nodes near any player that still need settling, nearest first, found once when the pass starts
+	TArray<int32> NodeIndexes;
+	// Into NodeIndexes or object index depending on the phase
+	int32 Cursor = 0;
+	int32 NumFrames = 0;
+	int32 NumNodesSettled = 0;
+	int32 NumComponentsDestroyed = 0;
+	// Settles started on the frame NumFrames counts up to, for the per-tick cap
+	int32 NumSettlesThisFrame = 0;
+};
+
+/// A node whose settle traces are still in flight
+struct FPendingNodeSettle
+{
+	FGuid NodeGUID;
+	// Into the subsystem's session nodes, checked against NodeGUID before use
+	int32 NodeIndex = INDEX_NONE;
+	FVector NodeLocation = FVector::ZeroVector;
+	TArray<FVector> HitPoints;
+	// Fitted to HitPoints when deciding whether to fire the rest, reset if more traces go out
+	TOptional<FVector> PlaneNormal;
+	int32 NumTracesFired = 0;
+	int32 NumTracesLeft = 0;
+};
+
 UCLASS()
 class RESOURCEROULETTE_API UResourceRouletteManager : public UObject
 {
@@ -18,12 +61,19 @@ public:
 	void Update(UWorld* World, AResourceRouletteSeedManager* InSeedManager, bool bReroll = false);
 	void ScanWorldResourceNodes(UWorld* World, bool bReroll = false);
 	void RandomizeWorldResourceNodes(UWorld* World, bool bReroll = false);
-	void SpawnWorldResourceNodes(UWorld* World, bool IsFromSaved);
-	void UpdateWorldResourceNodes(const UWorld* World) const;
+	void SpawnWorldResourceNodes(UWorld* World);
+	void OnResourceNodesSpawned();
+	void CancelSpawning();
+	void UpdateWorldResourceNodes(UWorld* World);
+	void TickWorldResourceNodes(UWorld* World);
 	void InitMeshesToDestroy();
+	void RegisterMeshSuppressionHooks(UWorld* World);
+	void UnregisterMeshSuppressionHooks();
 	void RemoveResourceRouletteNodes();
 	void UpdateRadarTowers() const;
 	void RemoveExtractorsFromWorld() const;
+	void LogNodeActivation(const UWorld* World) const;
+	void SaveSettleCache();
 
 private:
 	// Used in the mesh destroying bonanza
@@ -33,14 +83,62 @@ private:
 	bool bIsResourcesRandomized;
 	bool bIsResourcesSpawned;
 
+	FResourceWorldUpdatePass WorldUpdatePass;
+	void TickWorldUpdatePass(UWorld* World);
+
+	// Positions, settled and active bits of the session nodes, so finding nodes near the player doesn't walk the
+	// full FResourceNodeData array. Same indexes as the subsystem's array
+	ResourceRouletteCore::FResourceNodeTable NodeTable;
+
+	void RebuildNodeTable(const TArray<FResourceNodeData>& ProcessedNodes);
+	void GetPlayerLocations(const UWorld* World, TArray<FVector>& OutLocations) const;
+	void FindNodesToSettle(const TArray<FResourceNodeData>& ProcessedNodes, const TArray<FVector>& PlayerLocations,
+	                       TArray<int32>& OutNodeIndexes);
+	bool SettleNodeNearPlayer(TArray<FResourceNodeData>& ProcessedNodes, int32 NodeIndex, UWorld* World,
+	                          const TArray<FVector>& PlayerLocations);
+	void ApplySettledTransform(const FResourceNodeData& NodeData, const AFGResourceNode* ResourceNode) const;
+	void FlushDirtyNodes(UWorld* World);
+	void UpdateNodeActivation(const TArray<FVector>& PlayerLocations, const TArray<FResourceNodeData>& ProcessedNodes);
+
+	// Async terrain settling, traces come back over the next frames and the results get applied in a batch
+	TMap<uint32, FPendingNodeSettle> PendingSettles;
+	uint32 NextSettleId;
+	FTraceDelegate SettleTraceDelegate;
+
+	// Settle results from earlier sessions on this map, rerolls and new saves reuse them instead of tracing
+	FResourceSettleCache SettleCache;
+
+	bool IsSettleQueueFull() const;
+	bool IsSettlePending(const FGuid& NodeGUID) const;
+	void QueueNodeSettle(int32 NodeIndex, const FResourceNodeData& NodeData, UWorld* World,
+	                     const AFGResourceNode* ResourceNode);
+	void FireSettleTraces(uint32 SettleId, FPendingNodeSettle& PendingSettle, UWorld* World,
+	                      const AFGResourceNode* ResourceNode, int32 NumTraces) const;
+	void OnSettleTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void ApplyCompletedSettles(UWorld* World);
+	bool ShouldDestroyMeshComponent(const UStaticMeshComponent* StaticMeshComponent) const;
+
+	// Event driven mesh suppression, new levels and spawned actors get checked once instead of sweeping forever
+	bool bInitialComponentSweepDone;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle ActorSpawnedHandle;
+	TWeakObjectPtr<UWorld> HookedWorld;
+	TArray<TWeakObjectPtr<USceneComponent>> PendingSuppressionChecks;
+
+	bool IsComponentSweepNeeded() const;
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void OnActorSpawned(AActor* SpawnedActor);
+	void QueueSuppressionChecks(const AActor* Actor);
+	void ProcessSuppressionChecks(const UWorld* World);
+
 	UPROPERTY()	AResourceRouletteSeedManager* SeedManager;
 	UPROPERTY()	UResourceCollectionManager* ResourceCollectionManager;
 	UPROPERTY()	UResourcePurityManager* ResourcePurityManager;
 	UPROPERTY()	UResourceNodeRandomizer* ResourceNodeRandomizer;
 	UPROPERTY()	UResourceNodeSpawner* ResourceNodeSpawner;
-	UPROPERTY()	TArray<FResourceNodeData> NotProcessedResourceNodes;
 	UPROPERTY()	TSet<FName> RegisteredTags;
-	UPROPERTY()	TSet<FName> MeshesToDestroy;
+	// The node meshes InitMeshesToDestroy resolved, so checks are a pointer lookup instead of building a path name
+	UPROPERTY()	TSet<UStaticMesh*> MeshAssetsToDestroy;
 };
 
 // TODO: I should probably fix this
@@ -1,66 +1,80 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
 #include "ResourceRouletteUtility.h"
-#include "Windows/WindowsPlatformTime.h"
 //////////////////////////////////////////////////////////////////////////////////
 // If this is 1 then we do profiling, if it's 0 then we don't do profiling      //
 // SET TO ZERO BEFORE RELEASING MOD												//
 //////////////////////////////////////////////////////////////////////////////////
 #define ENABLE_PROFILING 0
 
+// Every RR_PROFILE site gets one static FResourceRouletteProfileSite that collects its stats, use
+// ResourceRoulette.Profiler.Dump / .ExportTrace / .Reset in the console to look at them
 #if ENABLE_PROFILING
-#define RR_PROFILE() FResourceRouletteProfiler ScopedProfiler(TEXT(__FUNCTION__))
-#define RR_PROFILE_SUBSECTION(SubsectionName) FResourceRouletteProfilerSubsection ScopedSubProfiler(TEXT(__FUNCTION__), TEXT(SubsectionName))
+#define RR_PROFILE() \
+	static FResourceRouletteProfileSite ProfileSite(__FUNCTION__); \
+	FResourceRouletteProfiler ScopedProfiler(ProfileSite)
+#define RR_PROFILE_SUBSECTION(SubsectionName) \
+	static FResourceRouletteProfileSite ProfileSubsectionSite(__FUNCTION__, TEXT(SubsectionName)); \
+	FResourceRouletteProfiler ScopedSubProfiler(ProfileSubsectionSite)
 #else
 #define RR_PROFILE()
 #define RR_PROFILE_SUBSECTION(SubsectionName)
 #endif
 
 
-class FResourceRouletteProfiler
+/// Aggregated timings for one RR_PROFILE site, registers itself with the profiler on construction
+class RESOURCEROULETTE_API FResourceRouletteProfileSite
 {
 public:
-	explicit FResourceRouletteProfiler(const FString& InFunctionName) : FunctionName(InFunctionName)
-	{
-		StartTime = FPlatformTime::Seconds();
-	}
+	explicit FResourceRouletteProfileSite(const ANSICHAR* FunctionName, const TCHAR* SubsectionName = nullptr);
 
-	~FResourceRouletteProfiler()
-	{
-		const double EndTime = FPlatformTime::Seconds();
-		const double ElapsedTime = (EndTime - StartTime) * 1000.0;
+	void AddSample(uint64 InclusiveCycles, uint64 ExclusiveCycles);
+	void Reset();
 
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(TEXT("%s executed in %.3f ms"), *FunctionName, ElapsedTime),
-			ELogLevel::Debug);
-	}
+	const FString& GetName() const { return Name; }
 
 private:
-	double StartTime;
-	FString FunctionName;
+	friend class FResourceRouletteProfiler;
+
+	// Only the most recent samples are kept for the p99
+	static constexpr int32 MaxRecentSamples = 4096;
+
+	FString Name;
+	FCriticalSection Mutex;
+	uint64 NumCalls = 0;
+	uint64 TotalCycles = 0;
+	uint64 SelfCycles = 0;
+	uint64 MinCycles = MAX_uint64;
+	uint64 MaxCycles = 0;
+	TArray<uint64> RecentSamples;
 };
 
-class FResourceRouletteProfilerSubsection
+/// Scoped timer, keeps a per-thread stack of open scopes so children can be taken out of the parent's self time
+class RESOURCEROULETTE_API FResourceRouletteProfiler
 {
 public:
-	FResourceRouletteProfilerSubsection(const TCHAR* InFunctionName, const TCHAR* InSubsectionName)
-	{
-		StartTime = FPlatformTime::Seconds();
-		SubFunctionName = FString::Printf(TEXT("%s - %s"), InFunctionName, InSubsectionName);
-	}
+	explicit FResourceRouletteProfiler(FResourceRouletteProfileSite& InSite);
+	~FResourceRouletteProfiler();
+
+	FResourceRouletteProfiler(const FResourceRouletteProfiler&) = delete;
+	FResourceRouletteProfiler& operator=(const FResourceRouletteProfiler&) = delete;
 
-	~FResourceRouletteProfilerSubsection()
-	{
-		const double EndTime = FPlatformTime::Seconds();
-		const double ElapsedTime = (EndTime - StartTime) * 1000.0;
+	/// Logs calls, total, self, min, max, average and p99 for every site that ran, slowest first
+	static void LogSummary();
 
-		FResourceRouletteUtilityLog::Get().LogMessage(
-			FString::Printf(TEXT("%s executed in %.3f ms"), *SubFunctionName, ElapsedTime),
-			ELogLevel::Debug);
-	}
+	/// Writes every recorded scope as Chrome trace events, open it in chrome://tracing or Perfetto
+	/// @param FilePath Where to put the json
+	static bool ExportTrace(const FString& FilePath);
+
+	/// Clears the stats and the recorded trace
+	static void Reset();
 
 private:
-	double StartTime;
-	FString SubFunctionName;
-};
\ No newline at end of file
+	FResourceRouletteProfileSite& Site;
+	FResourceRouletteProfiler* Parent;
+	uint64 StartCycles;
+	uint64 ChildCycles = 0;
+	uint32 Depth;
+};
@@ -14,8 +14,10 @@ class RESOURCEROULETTE_API AResourceRouletteSubsystem : public AModSubsystem, pu
 
 public:
 	AResourceRouletteSubsystem();
+	virtual void Tick(float DeltaSeconds) override;
 
 	static AResourceRouletteSubsystem* Get(const UObject* WorldContext);
+	static void LogLookupStats();
 
 	UFUNCTION(BlueprintCallable)
 	void InitializeResourceRoulette();
@@ -32,16 +34,22 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void UpdateResourceRoulette() const;
 
+	void OnResourceNodesSpawned() const;
+
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	bool IsInitialized() const { return bIsInitialized; }
 
 	bool GetSessionAlreadySpawned() const { return SessionAlreadySpawned; }
-	TArray<FResourceNodeData>& GetSessionRandomizedResourceNodes() { return SessionRandomizedResourceNodes; }
-	TArray<FResourceNodeData>& GetOriginalResourceNodes() { return OriginalResourceNodes; }
+	// The one copy of the node arrays, everything else works on these in place by index
+	TArray<FResourceNodeData>& GetSessionRandomizedResourceNodes() { return SavedRandomizedResourceNodes; }
+	TArray<FResourceNodeData>& GetOriginalResourceNodes() { return SavedOriginalResourceNodes; }
 
 	void SetSessionAlreadySpawned(bool InSessionAlreadySpawned);
-	void SetSessionRandomizedResourceNodes(const TArray<FResourceNodeData>& InSessionRandomizedResourceNodes);
-	void SetOriginalResourceNodes(const TArray<FResourceNodeData>& InOriginalResourceNodes);
+	void SetSessionRandomizedResourceNodes(TArray<FResourceNodeData>&& InSessionRandomizedResourceNodes);
+	void SetOriginalResourceNodes(TArray<FResourceNodeData>&& InOriginalResourceNodes);
+
+	static void LogNodeMemory(UWorld* World);
+	static void LogNodeActivation(UWorld* World);
 
 	virtual bool ShouldSave_Implementation() const override { return true; }
 	virtual void PreSaveGame_Implementation(int32 SaveVersion, int32 GameVersion) override;
@@ -61,12 +69,11 @@ private:
 	bool SessionAlreadySpawned = false;
 
 	UPROPERTY(SaveGame)	FString SavedModVersion;
+	// Session nodes live straight in the saved properties, so saving and loading doesn't copy them around.
+	// The names stay as they are for older saves
 	UPROPERTY(SaveGame)	TArray<FResourceNodeData> SavedRandomizedResourceNodes;
 	UPROPERTY(SaveGame)	TArray<FResourceNodeData> SavedOriginalResourceNodes;
 
-	UPROPERTY()	TArray<FResourceNodeData> SessionRandomizedResourceNodes;
-	UPROPERTY()	TArray<FResourceNodeData> OriginalResourceNodes;
-
 	bool bIsInitialized = false;
 
 	UPROPERTY()	AResourceRouletteSeedManager* SeedManager;
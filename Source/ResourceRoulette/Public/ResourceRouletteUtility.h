@@ -6,6 +6,8 @@
 #include "Resources/FGResourceNode.h"
 #include "Buildables/FGBuildableResourceExtractor.h"
 #include "Misc/OutputDeviceFile.h"
+#include "HAL/Runnable.h"
+#include <atomic>
 #include "SessionSettings/SessionSettingsManager.h"
 #include "ResourceRouletteUtility.generated.h"
 
@@ -32,7 +34,7 @@ enum class EBlueprintLogLevel : uint8
 
 const FName ResourceRouletteTag = "ResourceRouletteObject";
 
-class FResourceRouletteUtilityLog
+class FResourceRouletteUtilityLog : public FRunnable
 {
 public:
 	static FResourceRouletteUtilityLog& Get();
@@ -40,8 +42,14 @@ public:
 	void InitializeLog();
 	void ShutdownLog();
 	void LogMessage(const FString& Message, ELogLevel Level);
+	// Output of console commands, printed whatever ResourceRoulette.LogLevel is set to
+	void LogReport(const FString& Message);
 	void SetUseCustomLogFile(bool bEnableCustomLogFile);
 
+	// Writer thread
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
 private:
 	bool bUseCustomLogFile = true;
 
@@ -50,10 +58,26 @@ private:
 	FResourceRouletteUtilityLog& operator=(const FResourceRouletteUtilityLog&) = delete;
 
 	void RawLogMessage(const FString& Message);
+	void CopyToLogBuffer(const TCHAR* Characters, int32 NumCharacters);
+	void DrainLogBuffer();
 
-	FString* LogFile = nullptr;
+	bool bIsLogOpen = false;
 	FCriticalSection LogFileMutex;
 
+	// Ring buffer of pending characters, callers just copy into it and the writer thread empties it
+	TArray<TCHAR> LogBuffer;
+	int32 LogBufferHead = 0;
+	int32 LogBufferNum = 0;
+	int32 NumDroppedMessages = 0;
+
+	// Only touched by the writer thread while it's running
+	TUniquePtr<FArchive> LogFileWriter;
+	TArray<TCHAR> PendingCharacters;
+
+	FRunnableThread* WriterThread = nullptr;
+	FEvent* WriterWakeEvent = nullptr;
+	std::atomic<bool> bStopWriter = false;
+
 	static FResourceRouletteUtilityLog Instance;
 };
 
@@ -90,14 +114,28 @@ public:
 	static const TArray<FName>& GetNonGroupableResources();
 
 	static void LogAllResourceNodes(const UWorld* World);
+	static bool IsHeadlessServer(const UWorld* World);
 
 	static FVector CalculateBestFitPlaneNormal(const TArray<FVector>& Points);
 	static bool CalculateLocationAndRotationForNode(FResourceNodeData& NodeData, const UWorld* World,
-	                                                const AActor* ResourceNodeActor);
+	                                                const AActor* ResourceNodeActor,
+	                                                const UPrimitiveComponent* NodeMeshInstances = nullptr);
+	static void GetSettleTraceSegments(const FVector& NodeLocation, TArray<TPair<FVector, FVector>>& OutSegments);
+	static FCollisionQueryParams GetSettleQueryParams(const AActor* ResourceNodeActor,
+	                                                  const UPrimitiveComponent* NodeMeshInstances = nullptr);
+	static bool FindSettleHitPoint(const TArray<FHitResult>& Hits, FVector& OutHitPoint);
+	static bool ApplySettleHitPoints(FResourceNodeData& NodeData, const TArray<FVector>& HitPoints,
+	                                 const FVector* PlaneNormal = nullptr);
+	static int32 GetNumSettleTraces();
+	static int32 GetNumInitialSettleTraces();
+	static bool NeedsMoreSettleTraces(const TArray<FVector>& HitPoints, TOptional<FVector>& OutPlaneNormal);
+	static void RecordSettleTraces(FResourceNodeData& NodeData, int32 NumTraces);
+	static void LogSettleStats();
 
 	static void AssociateExtractorsWithNodes(UWorld* World, const TArray<FResourceNodeData>& ProcessedNodes,
 	                                         const TMap<FGuid, AFGResourceNode*>& SpawnedResourceNodes);
 	static void RemoveExtractors(UWorld* World, const TArray<FResourceNodeData>& ProcessedNodes,
 	                             const TMap<FGuid, AFGResourceNode*>& SpawnedResourceNodes);
 	static void ScannerGenerateNodeClusters(UWorld* World, float ClusterRadius);
+	static void ScannerUpdateNodeClusters(UWorld* World, const TMap<const AFGResourceNodeBase*, FVector>& MovedNodes);
 };
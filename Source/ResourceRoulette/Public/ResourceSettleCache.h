@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+struct FResourceNodeData;
+
+/// Where a node on one candidate location ended up after settling
+struct FResourceSettleCacheEntry
+{
+	double SettledZ = 0.0;
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	friend FArchive& operator<<(FArchive& Ar, FResourceSettleCacheEntry& Entry)
+	{
+		return Ar << Entry.SettledZ << Entry.Rotation;
+	}
+};
+
+/// Settle results keyed by the candidate location a node was placed on. Candidates are the vanilla node positions,
+/// so they're the same for every save on a map and the cache lives in one file per map under Saved
+class RESOURCEROULETTE_API FResourceSettleCache
+{
+public:
+	void LoadForWorld(const UWorld* World);
+	void Save();
+
+	bool Apply(FResourceNodeData& NodeData) const;
+	void Add(const FVector& CandidateLocation, const FResourceNodeData& SettledNode);
+
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	static FIntVector QuantizeLocation(const FVector& Location);
+
+	FString CacheFilePath;
+	TMap<FIntVector, FResourceSettleCacheEntry> Entries;
+	bool bIsDirty = false;
+};